@@ -0,0 +1,30 @@
+TEMPLATE = app
+TARGET = nfcshare
+CONFIG += console
+CONFIG -= app_bundle
+QT = core dbus
+
+QMAKE_CXXFLAGS += -Wno-unused-parameter
+
+DEFINES += QT_NO_KEYWORDS
+
+CONFIG(debug, debug|release) {
+    DEFINES += DEBUG
+}
+
+INCLUDEPATH += ../lib/include
+LIBS += -L$$OUT_PWD/../lib -lnfcshare
+
+SOURCES += \
+    main.cpp
+
+target.path = $$[QT_INSTALL_BINS]
+INSTALLS += target
+
+# D-Bus activation of the daemon mode
+dbus_service.files = org.sailfishos.nfcshare.service
+dbus_service.path = $$[QT_INSTALL_PREFIX]/share/dbus-1/services
+INSTALLS += dbus_service
+
+OTHER_FILES += \
+    org.sailfishos.nfcshare.service
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// Headless NFC sharing for scripts and system services. Shares the
+// text given on the command line (or the contents of a file) and
+// exits as soon as the whole NDEF message has been read. In daemon
+// mode, serves org.sailfishos.nfcshare D-Bus service instead.
+
+#include "ndefapp.h"
+#include "ndefrecord.h"
+#include "nfcshare.h"
+#include "nfcshareservice.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMimeDatabase>
+#include <QtCore/QTextStream>
+#include <QtCore/QTimer>
+
+#define RET_OK (0)
+#define RET_TIMEOUT (1)
+#define RET_ERR (2)
+
+static
+bool
+parseTransport(
+    const QString& aName,
+    NfcShare::Transport* aTransport)
+{
+    if (aName == QLatin1String("tag")) {
+        *aTransport = NfcShare::Type4Tag;
+    } else if (aName == QLatin1String("snep")) {
+        *aTransport = NfcShare::SnepPush;
+    } else if (aName == QLatin1String("auto")) {
+        *aTransport = NfcShare::AutoTransport;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static
+NdefApp::Transport
+appTransport(
+    NfcShare::Transport aTransport)
+{
+    return (aTransport == NfcShare::SnepPush) ? NdefApp::TransportSnep :
+        (aTransport == NfcShare::AutoTransport) ? NdefApp::TransportAuto :
+        NdefApp::TransportType4;
+}
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    QTextStream err(stderr);
+
+    parser.setApplicationDescription("Shares text or a file over NFC.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("text", "Text or URL to share.");
+    QCommandLineOption fileOption(QStringList() << "f" << "file",
+        "Share the contents of FILE as a MIME record.", "FILE");
+    QCommandLineOption mimeOption(QStringList() << "m" << "mime",
+        "MIME type of the file (detected by default).", "TYPE");
+    QCommandLineOption transportOption(QStringList() << "t" << "transport",
+        "Transport: tag (default), snep or auto.", "TRANSPORT", "tag");
+    QCommandLineOption waitOption(QStringList() << "w" << "wait",
+        "Give up after SEC seconds (0 to wait forever, the default).",
+        "SEC", "0");
+    QCommandLineOption compressOption(QStringList() << "z" << "compress",
+        "Compress the message if that helps (for nfcsharez readers).");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose",
+        "Enable debug output.");
+    QCommandLineOption daemonOption(QStringList() << "d" << "daemon",
+        "Serve " + NfcShareService::SERVICE + " on the session bus.");
+    parser.addOption(fileOption);
+    parser.addOption(mimeOption);
+    parser.addOption(transportOption);
+    parser.addOption(waitOption);
+    parser.addOption(compressOption);
+    parser.addOption(verboseOption);
+    parser.addOption(daemonOption);
+    parser.process(app);
+
+    NfcShare::Transport transport;
+    bool ok = false;
+    const int wait = parser.value(waitOption).toInt(&ok);
+    const QStringList args(parser.positionalArguments());
+    const bool haveFile = parser.isSet(fileOption);
+    const bool daemon = parser.isSet(daemonOption);
+    const bool compress = parser.isSet(compressOption);
+
+    if (!parseTransport(parser.value(transportOption), &transport) ||
+        !ok || wait < 0 || (daemon ? (haveFile || !args.isEmpty()) :
+        haveFile ? !args.isEmpty() : args.size() != 1)) {
+        parser.showHelp(RET_ERR);
+    }
+
+    if (parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("nfcshare.*.debug=true");
+    }
+
+    if (daemon) {
+        NfcShareService service;
+
+        if (!service.isRegistered()) {
+            err << "Failed to register " << NfcShareService::SERVICE << "\n";
+            return RET_ERR;
+        }
+        return app.exec();
+    }
+
+    // Either one is used, depending on what's being shared
+    NfcShare share;
+    NdefApp* ndef = Q_NULLPTR;
+
+    if (haveFile) {
+        const QString fileName(parser.value(fileOption));
+        QFile file(fileName);
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << fileName << ": " << file.errorString() << "\n";
+            return RET_ERR;
+        }
+
+        const QString mime(parser.isSet(mimeOption) ?
+            parser.value(mimeOption) :
+            QMimeDatabase().mimeTypeForFile(fileName).name());
+        QByteArray msg(NdefRecord::encode(NdefRecord::TnfMediaType,
+            mime.toLatin1(), file.readAll()));
+
+        if (compress) {
+            const QByteArray compressed(NdefRecord::compress(msg));
+
+            if (!compressed.isEmpty()) {
+                msg = compressed;
+            }
+        }
+
+        ndef = new NdefApp(msg.constData(), msg.size(),
+            appTransport(transport), &app);
+        if (ndef->isTooMuchData()) {
+            err << fileName << " is too large (" << msg.size() <<
+                " bytes, " << NdefApp::maxMessageSize() << " max)\n";
+            return RET_ERR;
+        }
+        QObject::connect(ndef, SIGNAL(done()), &app, SLOT(quit()));
+    } else {
+        share.setTransport(transport);
+        share.setCompress(compress);
+        share.setText(args.first());
+        if (share.isTooMuchData()) {
+            err << "Text is too large (" << NdefApp::maxMessageSize() <<
+                " bytes max)\n";
+            return RET_ERR;
+        }
+        QObject::connect(&share, SIGNAL(done()), &app, SLOT(quit()));
+    }
+
+    if (wait) {
+        QTimer::singleShot(wait * 1000, &app, SLOT(quit()));
+    }
+
+    app.exec();
+    return (ndef ? ndef->isDone() : share.isDone()) ? RET_OK : RET_TIMEOUT;
+}
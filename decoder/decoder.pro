@@ -0,0 +1,37 @@
+TEMPLATE = lib
+TARGET = nfcsharez
+VERSION = 1.0.0
+CONFIG += link_pkgconfig create_pc create_prl no_install_prl
+CONFIG -= qt
+PKGCONFIG += zlib
+
+QMAKE_CFLAGS += -Wno-unused-parameter
+
+CONFIG(debug, debug|release) {
+    DEFINES += DEBUG
+}
+
+INCLUDEPATH += include
+
+PUBLIC_HEADERS = \
+    include/nfcsharez.h
+
+HEADERS += \
+    $${PUBLIC_HEADERS}
+
+SOURCES += \
+    src/nfcsharez.c
+
+target.path = $$[QT_INSTALL_LIBS]
+INSTALLS += target
+
+headers.files = $${PUBLIC_HEADERS}
+headers.path = $$[QT_INSTALL_PREFIX]/include/nfcsharez
+INSTALLS += headers
+
+QMAKE_PKGCONFIG_NAME = libnfcsharez
+QMAKE_PKGCONFIG_DESCRIPTION = Decoder for compressed NfcShare NDEF messages
+QMAKE_PKGCONFIG_LIBDIR = $$target.path
+QMAKE_PKGCONFIG_INCDIR = $$headers.path
+QMAKE_PKGCONFIG_REQUIRES = zlib
+QMAKE_PKGCONFIG_DESTDIR = pkgconfig
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCSHARE_Z_H
+#define NFCSHARE_Z_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Decoder for the compressed NDEF messages produced by libnfcshare
+ * when compression is enabled (NfcShare.compress, nfcshare -z). Such
+ * a message consists of a single NFC Forum external type record:
+ *
+ *   TNF     4 (external)
+ *   TYPE    "sailfishos.org:ndefz"
+ *   PAYLOAD 1 byte method (1 = zlib), 4 bytes original size
+ *           (big-endian), RFC 1950 zlib stream
+ *
+ * and unpacks into the original NDEF message. Depends on zlib only.
+ */
+
+#define NFCSHARE_Z_TYPE "sailfishos.org:ndefz"
+
+/* Returns non-zero if the NDEF message is a compressed one */
+int
+nfcshare_z_detect(
+    const void* ndef,
+    size_t size);
+
+/* Returns the original NDEF message allocated with malloc() (to be
+ * released with free()) or NULL if the message isn't compressed or
+ * is broken. */
+void*
+nfcshare_z_decode(
+    const void* ndef,
+    size_t size,
+    size_t* out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NFCSHARE_Z_H */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcsharez.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+
+/* NDEF record header */
+#define NDEF_HDR_MB  (0x80)
+#define NDEF_HDR_SR  (0x10)
+#define NDEF_HDR_IL  (0x08)
+#define NDEF_HDR_TNF (0x07)
+#define NDEF_TNF_EXTERNAL (0x04)
+
+/* Compressed payload header */
+#define Z_METHOD_ZLIB (0x01)
+#define Z_HEADER_SIZE (5)
+
+/* More than a tag can possibly unpack into, guards against garbage */
+#define Z_MAX_SIZE (0x1000000)
+
+static
+const unsigned char*
+nfcshare_z_payload(
+    const void* ndef,
+    size_t size,
+    size_t* payload_size)
+{
+    /*
+     * MB ME CF SR IL TNF, TYPE LENGTH, PAYLOAD LENGTH (1 or 4 bytes),
+     * optional ID LENGTH, TYPE, ID, PAYLOAD. Only the first record
+     * is looked at.
+     */
+    const unsigned char* ptr = ndef;
+    const unsigned char* end = ptr + size;
+    const size_t type_len = strlen(NFCSHARE_Z_TYPE);
+    unsigned char hdr;
+    size_t len, rem, id_len = 0;
+
+    if (!ptr || size < 3) {
+        return NULL;
+    }
+
+    hdr = *ptr++;
+    if (!(hdr & NDEF_HDR_MB) ||
+        (hdr & NDEF_HDR_TNF) != NDEF_TNF_EXTERNAL ||
+        *ptr++ != type_len) {
+        return NULL;
+    }
+
+    if (hdr & NDEF_HDR_SR) {
+        len = *ptr++;
+    } else if (end - ptr >= 4) {
+        len = ((size_t)ptr[0] << 24) | ((size_t)ptr[1] << 16) |
+            ((size_t)ptr[2] << 8) | ptr[3];
+        ptr += 4;
+    } else {
+        return NULL;
+    }
+
+    if (hdr & NDEF_HDR_IL) {
+        if (ptr >= end) {
+            return NULL;
+        }
+        id_len = *ptr++;
+    }
+
+    /*
+     * Each field is checked against what's left, one at a time. Adding
+     * the lengths up first could wrap around where size_t is 32 bits.
+     */
+    rem = end - ptr;
+    if (type_len > rem) {
+        return NULL;
+    }
+    /* External type names are case insensitive */
+    if (strncasecmp((const char*)ptr, NFCSHARE_Z_TYPE, type_len)) {
+        return NULL;
+    }
+    ptr += type_len;
+    rem -= type_len;
+    if (id_len > rem) {
+        return NULL;
+    }
+    ptr += id_len;
+    rem -= id_len;
+    if (len > rem || len < Z_HEADER_SIZE || ptr[0] != Z_METHOD_ZLIB) {
+        return NULL;
+    }
+    *payload_size = len;
+    return ptr;
+}
+
+int
+nfcshare_z_detect(
+    const void* ndef,
+    size_t size)
+{
+    size_t len;
+
+    return nfcshare_z_payload(ndef, size, &len) != NULL;
+}
+
+void*
+nfcshare_z_decode(
+    const void* ndef,
+    size_t size,
+    size_t* out_size)
+{
+    size_t len;
+    const unsigned char* payload = nfcshare_z_payload(ndef, size, &len);
+
+    if (payload) {
+        /* Method byte, then the big-endian size of the original */
+        const unsigned long expected = ((unsigned long)payload[1] << 24) |
+            ((unsigned long)payload[2] << 16) |
+            ((unsigned long)payload[3] << 8) | payload[4];
+
+        if (expected > 0 && expected <= Z_MAX_SIZE) {
+            unsigned char* out = malloc(expected);
+            uLongf out_len = expected;
+
+            if (out) {
+                if (uncompress(out, &out_len, payload + Z_HEADER_SIZE,
+                    len - Z_HEADER_SIZE) == Z_OK && out_len == expected) {
+                    if (out_size) {
+                        *out_size = out_len;
+                    }
+                    return out;
+                }
+                free(out);
+            }
+        }
+    }
+    return NULL;
+}
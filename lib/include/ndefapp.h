@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NDEF_APP_H
+#define NDEF_APP_H
+
+#include "ndefgenerator.h"
+#include "ndefmetrics.h"
+#include "nfcsharetypes.h"
+
+#include <QtCore/QObject>
+
+class NFCSHARE_EXPORT NdefApp :
+    public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(LeaseState)
+    Q_ENUMS(Tech)
+    Q_PROPERTY(bool tooMuchData READ isTooMuchData CONSTANT)
+    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
+    Q_PROPERTY(bool done READ isDone NOTIFY doneChanged)
+    Q_PROPERTY(uint bytesTransferred READ getBytesTransferred NOTIFY bytesTransferredChanged)
+    Q_PROPERTY(qreal transferRate READ getTransferRate NOTIFY bytesTransferredChanged)
+    Q_PROPERTY(qreal estimatedTimeRemaining READ getEstimatedTimeRemaining NOTIFY bytesTransferredChanged)
+    Q_PROPERTY(NdefMetrics* metrics READ getMetrics CONSTANT)
+    Q_PROPERTY(LeaseState leaseState READ getLeaseState NOTIFY leaseStateChanged)
+    Q_PROPERTY(int idleTimeout READ getIdleTimeout WRITE setIdleTimeout)
+    Q_PROPERTY(int techs READ getTechs WRITE setTechs)
+    class GioHost;
+    class Private;
+
+public:
+    // How the NDEF message gets delivered
+    enum Transport {
+        TransportType4,     // Type 4 tag emulation
+        TransportSnep,      // SNEP push to the P2P peer
+        TransportAuto       // Whichever the other side supports
+    };
+
+    // Card emulation mode and tech requests
+    enum LeaseState {
+        LeaseNone,          // Not requested (yet) or failed
+        LeaseAcquiring,     // Requests are in progress
+        LeaseHeld,          // Waiting for the reader
+        LeaseReleased       // Released when done or idle
+    };
+
+    // Technologies to emulate the tag on (same bits as nfcd uses)
+    enum Tech {
+        TechA = 0x01,       // Type 4A
+        TechB = 0x02,       // Type 4B
+        TechAB = TechA | TechB
+    };
+
+    // The data may be NULL if the size alone exceeds maxMessageSize().
+    // Non-zero receive size lets the reader write a message back.
+    NdefApp(const void*, uint, Transport, QObject*, uint aReceiveSize = 0);
+    // Serves a new message from the generator to each reader
+    NdefApp(NdefGenerator*, uint, Transport, QObject*, uint aReceiveSize = 0);
+
+    static uint maxMessageSize();
+    static uint maxReceiveSize();
+    static int defaultTechs();
+
+    bool isTooMuchData() const;
+    bool isReady() const;
+    bool isDone() const;
+    uint getBytesTotal() const;
+    uint getBytesTransferred() const;
+    qreal getTransferRate() const;
+    qreal getEstimatedTimeRemaining() const;
+    NdefMetrics* getMetrics() const;
+
+    LeaseState getLeaseState() const;
+    int getIdleTimeout() const;
+    void setIdleTimeout(int);
+    int getTechs() const;
+    void setTechs(int);
+    void reacquire();
+
+Q_SIGNALS:
+    void readyChanged();
+    void doneChanged();
+    void bytesTransferredChanged();
+    void leaseStateChanged();
+    void delivered();
+    void received(QByteArray);
+    void done();
+
+private:
+    Private* iPrivate;
+};
+
+#endif // NDEF_APP_H
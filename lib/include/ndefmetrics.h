@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NDEF_METRICS_H
+#define NDEF_METRICS_H
+
+#include "nfcsharetypes.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtCore/QVariantList>
+#include <QtCore/QVariantMap>
+
+// Where the share time goes. All times are in milliseconds since
+// the share has been created, negative if the stage hasn't been
+// reached yet.
+class NFCSHARE_EXPORT NdefMetrics :
+    public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(Stage)
+    Q_PROPERTY(qreal registerTime READ registerTime NOTIFY changed)
+    Q_PROPERTY(qreal modeTime READ modeTime NOTIFY changed)
+    Q_PROPERTY(qreal techsTime READ techsTime NOTIFY changed)
+    Q_PROPERTY(qreal readyTime READ readyTime NOTIFY changed)
+    Q_PROPERTY(qreal firstSelectTime READ firstSelectTime NOTIFY changed)
+    Q_PROPERTY(qreal lastReadTime READ lastReadTime NOTIFY changed)
+    Q_PROPERTY(qreal doneTime READ doneTime NOTIFY changed)
+    Q_PROPERTY(uint apduCount READ apduCount NOTIFY changed)
+    Q_PROPERTY(QVariantList latencyBuckets READ latencyBuckets CONSTANT)
+    Q_PROPERTY(QVariantList latencyHistogram READ latencyHistogram NOTIFY changed)
+    Q_PROPERTY(qreal bytesPerSecond READ bytesPerSecond NOTIFY changed)
+    Q_PROPERTY(uint retryCount READ retryCount NOTIFY changed)
+    Q_PROPERTY(uint failureCount READ failureCount NOTIFY changed)
+    Q_PROPERTY(uint resetCount READ resetCount NOTIFY changed)
+    Q_PROPERTY(uint leaseCount READ leaseCount NOTIFY changed)
+    Q_PROPERTY(qreal lastLeaseTime READ lastLeaseTime NOTIFY changed)
+    Q_PROPERTY(qreal maxLeaseTime READ maxLeaseTime NOTIFY changed)
+    Q_PROPERTY(uint rejectCount READ rejectCount NOTIFY changed)
+    Q_PROPERTY(QVariantMap rejectedCommands READ rejectedCommands NOTIFY changed)
+    Q_PROPERTY(QVariantMap techSessions READ techSessions NOTIFY changed)
+    Q_PROPERTY(QVariantMap techActivationTime READ techActivationTime NOTIFY changed)
+    Q_PROPERTY(uint poolMissCount READ poolMissCount NOTIFY changed)
+
+public:
+    enum Stage {
+        StageRegister,
+        StageMode,
+        StageTechs,
+        StageReady,
+        StageFirstSelect,
+        StageLastRead,
+        StageDone,
+        StageCount
+    };
+
+    explicit NdefMetrics(QObject* aParent = Q_NULLPTR);
+
+    void stage(Stage);
+    void apdu(qint64);
+    void bytesConfirmed(uint);
+    void retry();
+    void failure();
+    void reset();
+    void leaseAcquired(qreal);
+    void rejected(uchar, uchar, uchar);
+    void session(uint);
+    void activated(uint, qreal);
+    void poolMiss();
+    static QString techName(uint);
+    qreal elapsed() const;
+
+    Q_INVOKABLE qreal stageTime(Stage) const;
+    Q_INVOKABLE bool dump(QString) const;
+
+    qreal registerTime() const;
+    qreal modeTime() const;
+    qreal techsTime() const;
+    qreal readyTime() const;
+    qreal firstSelectTime() const;
+    qreal lastReadTime() const;
+    qreal doneTime() const;
+    uint apduCount() const;
+    QVariantList latencyBuckets() const;
+    QVariantList latencyHistogram() const;
+    qreal bytesPerSecond() const;
+    uint retryCount() const;
+    uint failureCount() const;
+    uint resetCount() const;
+    uint leaseCount() const;
+    qreal lastLeaseTime() const;
+    qreal maxLeaseTime() const;
+    uint rejectCount() const;
+    QVariantMap rejectedCommands() const;
+    QVariantMap techSessions() const;
+    QVariantMap techActivationTime() const;
+    uint poolMissCount() const;
+
+Q_SIGNALS:
+    void changed();
+
+private:
+    enum { LATENCY_BUCKETS = 10 };
+    enum { TECHS = 3 };     // NFC-A, NFC-B, NFC-F
+    static int techIndex(uint);
+    static const qint64 LATENCY_LIMIT_US[LATENCY_BUCKETS - 1];
+    QElapsedTimer iTimer;
+    qint64 iStage[StageCount];      // nanoseconds, -1 if not reached
+    uint iLatency[LATENCY_BUCKETS];
+    uint iApduCount;
+    uint iBytes;
+    uint iRetries;
+    uint iFailures;
+    uint iResets;
+    uint iLeases;
+    qreal iLastLeaseMs;     // RequestMode to RequestTechs completion
+    qreal iMaxLeaseMs;
+    uint iRejects;
+    QMap<uint,uint> iRejected;  // INS:P1:P2 => count
+    uint iTechSessions[TECHS];
+    uint iTechActivations[TECHS];
+    qreal iTechActivationMs[TECHS]; // Sum, for the average
+    uint iPoolMisses;
+};
+
+#endif // NDEF_METRICS_H
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NDEF_RECORD_H
+#define NDEF_RECORD_H
+
+#include "nfcsharetypes.h"
+
+#include <QtCore/QByteArray>
+
+// Minimal NDEF record encoder for the record types which libnfcdef
+// doesn't know how to build.
+class NFCSHARE_EXPORT NdefRecord
+{
+public:
+    enum Tnf {
+        TnfEmpty = 0x00,
+        TnfWellKnown = 0x01,
+        TnfMediaType = 0x02,
+        TnfAbsoluteUri = 0x03,
+        TnfExternal = 0x04
+    };
+
+    enum Flag {
+        FlagMessageBegin = 0x80,
+        FlagMessageEnd = 0x40,
+        FlagFirstAndLast = FlagMessageBegin | FlagMessageEnd
+    };
+
+    static QByteArray encode(Tnf, const QByteArray&, const QByteArray&,
+        const QByteArray& aId = QByteArray(), int aFlags = FlagFirstAndLast);
+
+    // Size of the record encode() would produce, without building it
+    static uint encodedSize(uint aTypeSize, uint aPayloadSize,
+        uint aIdSize = 0);
+
+    // Wraps the whole message into a single compressed record, which
+    // only our own readers understand (see libnfcsharez). Returns an
+    // empty array if that wouldn't make the message any smaller.
+    static QByteArray compress(const QByteArray&);
+    static const char COMPRESSED_TYPE[];
+};
+
+#endif // NDEF_RECORD_H
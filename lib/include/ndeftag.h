@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NDEF_TAG_H
+#define NDEF_TAG_H
+
+#include "nfcsharetypes.h"
+
+#include <QtCore/QByteArray>
+
+// Type 4 NDEF tag (CC and NDEF files) which takes C-APDUs and returns
+// R-APDUs, independently of how they get delivered.
+class NFCSHARE_EXPORT NdefTag
+{
+    Q_DISABLE_COPY(NdefTag)
+    class File;
+    class Private;
+
+public:
+    class Response;
+
+    // Events returned by the methods below
+    enum Event {
+        EventNone = 0x00,
+        EventProgress = 0x01,   // More bytes have been read
+        EventReset = 0x02,      // Incomplete read has been discarded
+        EventDone = 0x04,       // The whole NDEF file has been read
+        EventReceived = 0x08    // The reader has written a new message
+    };
+
+    // Zero MLe means the largest one the CC can advertise (0xFFFF).
+    // Non-zero receive size makes the NDEF file writable, messages up
+    // to that size (or the size of the one being read, if it's larger)
+    // are accepted. Once committed, the written message is what the
+    // readers get until replace().
+    NdefTag(const void*, uint, uint aMaxLe = 0, uint aReceiveSize = 0);
+    ~NdefTag();
+
+    static uint maxMessageSize();
+    static uint maxReceiveSize();
+    static QByteArray aid();
+    static QByteArray legacyAid();
+
+    bool isTooMuchData() const;
+    bool isDone() const;
+    uint size() const;
+    uint bytesRead() const;
+    QByteArray received() const;
+
+    // Off by default, the v1 application (legacyAid) can only be
+    // selected by name if the app has registered it with nfcd
+    void setLegacyAidEnabled(bool);
+    void replace(const void*, uint);
+    Response process(uchar, uchar, uchar, uchar, const QByteArray&, uint);
+    int responseStatus(uint, bool);
+    int start();
+    int stop();
+
+private:
+    Private* iPrivate;
+};
+
+class NFCSHARE_EXPORT NdefTag::Response
+{
+public:
+    Response();
+    Response(uchar, uchar, const QByteArray& aData = QByteArray());
+
+    static Response error(uchar, uchar);
+
+    bool isOk() const;
+    uint id() const;
+    const QByteArray& data() const;
+    uchar sw1() const;
+    uchar sw2() const;
+
+private:
+    static uint nextId();
+
+private:
+    uchar iSw[2];
+    QByteArray iData;
+    uint iResponseId;
+};
+
+#endif // NDEF_TAG_H
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFC_SHARE_H
+#define NFC_SHARE_H
+
+#include "ndefmetrics.h"
+#include "nfcsharebearer.h"
+#include "nfcsharegenerator.h"
+#include "nfcsharetypes.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+class NFCSHARE_EXPORT NfcShare :
+    public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(Transport)
+    Q_ENUMS(LeaseState)
+    Q_ENUMS(Tech)
+    Q_PROPERTY(QString text READ getText WRITE setText NOTIFY textChanged)
+    Q_PROPERTY(bool tooMuchData READ isTooMuchData NOTIFY tooMuchDataChanged)
+    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
+    Q_PROPERTY(bool done READ isDone NOTIFY doneChanged)
+    Q_PROPERTY(uint bytesTotal READ getBytesTotal NOTIFY bytesTotalChanged)
+    Q_PROPERTY(uint bytesTransferred READ getBytesTransferred NOTIFY bytesTransferredChanged)
+    Q_PROPERTY(qreal transferRate READ getTransferRate NOTIFY bytesTransferredChanged)
+    Q_PROPERTY(qreal estimatedTimeRemaining READ getEstimatedTimeRemaining NOTIFY bytesTransferredChanged)
+    Q_PROPERTY(NfcShareBearer* bearer READ getBearer WRITE setBearer NOTIFY bearerChanged)
+    Q_PROPERTY(bool handover READ isHandover NOTIFY handoverChanged)
+    Q_PROPERTY(Transport transport READ getTransport WRITE setTransport NOTIFY transportChanged)
+    Q_PROPERTY(bool compress READ getCompress WRITE setCompress NOTIFY compressChanged)
+    Q_PROPERTY(NdefMetrics* metrics READ getMetrics NOTIFY metricsChanged)
+    Q_PROPERTY(LeaseState leaseState READ getLeaseState NOTIFY leaseStateChanged)
+    Q_PROPERTY(int idleTimeout READ getIdleTimeout WRITE setIdleTimeout NOTIFY idleTimeoutChanged)
+    Q_PROPERTY(int techs READ getTechs WRITE setTechs NOTIFY techsChanged)
+    Q_PROPERTY(NfcShareGenerator* generator READ getGenerator WRITE setGenerator NOTIFY generatorChanged)
+    Q_PROPERTY(int receiveSize READ getReceiveSize WRITE setReceiveSize NOTIFY receiveSizeChanged)
+
+public:
+    enum Transport {
+        Type4Tag,
+        SnepPush,
+        AutoTransport
+    };
+
+    // Same as NdefApp::LeaseState
+    enum LeaseState {
+        LeaseNone,
+        LeaseAcquiring,
+        LeaseHeld,
+        LeaseReleased
+    };
+
+    // Same as NdefApp::Tech
+    enum Tech {
+        TechA = 0x01,
+        TechB = 0x02,
+        TechAB = TechA | TechB
+    };
+
+    explicit NfcShare(QObject* aParent = Q_NULLPTR);
+    ~NfcShare();
+
+    // Size of the NDEF message the text would be shared as, without
+    // encoding it. Anything that doesn't fit into the tag may come out
+    // as a lower bound, which is still above NdefApp::maxMessageSize().
+    static uint encodedSize(const QString&);
+    // The NDEF message itself, uncompressed
+    static QByteArray encode(const QString&);
+
+    QString getText() const;
+    void setText(QString);
+
+    bool isTooMuchData() const;
+    bool isReady() const;
+    bool isDone() const;
+    uint getBytesTotal() const;
+    uint getBytesTransferred() const;
+    qreal getTransferRate() const;
+    qreal getEstimatedTimeRemaining() const;
+
+    NfcShareBearer* getBearer() const;
+    void setBearer(NfcShareBearer*);
+    bool isHandover() const;
+
+    Transport getTransport() const;
+    void setTransport(Transport);
+    bool getCompress() const;
+    void setCompress(bool);
+
+    NdefMetrics* getMetrics() const;
+
+    LeaseState getLeaseState() const;
+    int getIdleTimeout() const;
+    void setIdleTimeout(int);
+    int getTechs() const;
+    void setTechs(int);
+    NfcShareGenerator* getGenerator() const;
+    void setGenerator(NfcShareGenerator*);
+    int getReceiveSize() const;
+    void setReceiveSize(int);
+
+    Q_INVOKABLE void reacquire();
+
+Q_SIGNALS:
+    void textChanged();
+    void tooMuchDataChanged();
+    void readyChanged();
+    void doneChanged();
+    void bytesTotalChanged();
+    void bytesTransferredChanged();
+    void bearerChanged();
+    void handoverChanged();
+    void transportChanged();
+    void compressChanged();
+    void metricsChanged();
+    void leaseStateChanged();
+    void idleTimeoutChanged();
+    void techsChanged();
+    void generatorChanged();
+    void receiveSizeChanged();
+    void delivered();
+    void received(QByteArray);
+    void done();
+
+private Q_SLOTS:
+    void onBearerChanged();
+    void onGeneratorChanged();
+
+private:
+    void updateApp();
+
+    class Private;
+    Private* iPrivate;
+};
+
+#endif // NFC_SHARE_H
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFC_SHARE_BEARER_H
+#define NFC_SHARE_BEARER_H
+
+#include "nfcsharetypes.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+// Alternative carrier for the content which doesn't fit into the
+// emulated tag. The tag then carries a Handover Select message pointing
+// to this carrier and the bulk transfer is left to whoever provides the
+// carrier (e.g. a Bluetooth OOB or Wi-Fi Direct service, or a local HTTP
+// server). The carrier configuration is supplied by the owner of this
+// object, the content is handed over via contentOffered() signal.
+class NFCSHARE_EXPORT NfcShareBearer :
+    public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(PowerState)
+    Q_PROPERTY(QString carrierType READ carrierType WRITE setCarrierType NOTIFY carrierTypeChanged)
+    Q_PROPERTY(QByteArray carrierData READ carrierData WRITE setCarrierData NOTIFY carrierDataChanged)
+    Q_PROPERTY(QString uri READ uri WRITE setUri NOTIFY uriChanged)
+    Q_PROPERTY(PowerState powerState READ powerState WRITE setPowerState NOTIFY powerStateChanged)
+    Q_PROPERTY(bool valid READ isValid NOTIFY validChanged)
+
+public:
+    // Carrier Power State (CPS)
+    enum PowerState {
+        Inactive,
+        Active,
+        Activating,
+        Unknown
+    };
+
+    explicit NfcShareBearer(QObject* aParent = Q_NULLPTR);
+
+    QString carrierType() const;
+    void setCarrierType(QString);
+
+    QByteArray carrierData() const;
+    void setCarrierData(QByteArray);
+
+    QString uri() const;
+    void setUri(QString);
+
+    PowerState powerState() const;
+    void setPowerState(PowerState);
+
+    bool isValid() const;
+    QByteArray handoverSelect() const;
+
+    void offer(const QString&);
+    void withdraw();
+
+Q_SIGNALS:
+    void carrierTypeChanged();
+    void carrierDataChanged();
+    void uriChanged();
+    void powerStateChanged();
+    void validChanged();
+    void contentOffered(QString text);
+    void contentWithdrawn();
+
+private:
+    QString iCarrierType;
+    QByteArray iCarrierData;
+    QString iUri;
+    PowerState iPowerState;
+    bool iOffered;
+};
+
+#endif // NFC_SHARE_BEARER_H
@@ -36,48 +36,40 @@
  * any official policies, either expressed or implied.
  */
 
-#ifndef NFC_SHARE_H
-#define NFC_SHARE_H
+#ifndef NFC_SHARE_GENERATOR_H
+#define NFC_SHARE_GENERATOR_H
+
+#include "nfcsharetypes.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QString>
 
-class NfcShare :
+// Supplies NfcShare with a distinct text for each reader session,
+// e.g. a rotating token. Subclasses override generateText(), up to
+// poolSize texts are generated and encoded ahead of time. It's all
+// done on NfcShare's thread (the GUI one in QML, where the callback
+// has to run anyway), one text per event loop iteration.
+class NFCSHARE_EXPORT NfcShareGenerator :
     public QObject
 {
     Q_OBJECT
-    Q_PROPERTY(QString text READ getText WRITE setText NOTIFY textChanged)
-    Q_PROPERTY(bool tooMuchData READ isTooMuchData NOTIFY tooMuchDataChanged)
-    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
-    Q_PROPERTY(bool done READ isDone NOTIFY doneChanged)
-    Q_PROPERTY(uint bytesTotal READ getBytesTotal NOTIFY bytesTotalChanged)
-    Q_PROPERTY(uint bytesTransferred READ getBytesTransferred NOTIFY bytesTransferredChanged)
+    Q_PROPERTY(int poolSize READ getPoolSize WRITE setPoolSize NOTIFY poolSizeChanged)
 
 public:
-    explicit NfcShare(QObject* aParent = Q_NULLPTR);
-    ~NfcShare();
+    enum { DEFAULT_POOL_SIZE = 4 };
+
+    explicit NfcShareGenerator(QObject* aParent = Q_NULLPTR);
 
-    QString getText() const;
-    void setText(QString);
+    int getPoolSize() const;
+    void setPoolSize(int);
 
-    bool isTooMuchData() const;
-    bool isReady() const;
-    bool isDone() const;
-    uint getBytesTotal() const;
-    uint getBytesTransferred() const;
+    virtual QString generateText();
 
 Q_SIGNALS:
-    void textChanged();
-    void tooMuchDataChanged();
-    void readyChanged();
-    void doneChanged();
-    void bytesTotalChanged();
-    void bytesTransferredChanged();
-    void done();
+    void poolSizeChanged();
 
 private:
-    class Private;
-    Private* iPrivate;
+    int iPoolSize;
 };
 
-#endif // NFC_SHARE_H
+#endif // NFC_SHARE_GENERATOR_H
@@ -36,40 +36,36 @@
  * any official policies, either expressed or implied.
  */
 
-#ifndef NDEF_APP_H
-#define NDEF_APP_H
+#ifndef NFC_SHARE_SERVICE_H
+#define NFC_SHARE_SERVICE_H
+
+#include "nfcsharetypes.h"
 
 #include <QtCore/QObject>
+#include <QtDBus/QDBusConnection>
 
-class NdefApp :
+// Lets other processes share NDEF messages or text over D-Bus, by
+// passing a sealed memfd (or a byte array for small payloads). Each
+// published payload gets its own object with Ready, Progress and Done
+// signals, which goes away when the publisher leaves the bus.
+class NFCSHARE_EXPORT NfcShareService :
     public QObject
 {
     Q_OBJECT
-    Q_PROPERTY(bool tooMuchData READ isTooMuchData CONSTANT)
-    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
-    Q_PROPERTY(bool done READ isDone NOTIFY doneChanged)
-    Q_PROPERTY(uint bytesTransferred READ getBytesTransferred NOTIFY bytesTransferredChanged)
-    class File;
-    class Private;
-    class Response;
 
 public:
-    NdefApp(const void*, uint, QObject*);
+    static const QString SERVICE;
 
-    bool isTooMuchData() const;
-    bool isReady() const;
-    bool isDone() const;
-    uint getBytesTotal() const;
-    uint getBytesTransferred() const;
+    explicit NfcShareService(QDBusConnection aBus =
+        QDBusConnection::sessionBus(), QObject* aParent = Q_NULLPTR);
+    ~NfcShareService();
 
-Q_SIGNALS:
-    void readyChanged();
-    void doneChanged();
-    void bytesTransferredChanged();
-    void done();
+    bool isRegistered() const;
 
 private:
+    class Handle;
+    class Private;
     Private* iPrivate;
 };
 
-#endif // NDEF_APP_H
+#endif // NFC_SHARE_SERVICE_H
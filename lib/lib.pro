@@ -0,0 +1,72 @@
+TEMPLATE = lib
+TARGET = nfcshare
+VERSION = 1.0.0
+CONFIG += link_pkgconfig create_pc create_prl no_install_prl
+PKGCONFIG += libnfcdef
+QT = core dbus
+
+QMAKE_CXXFLAGS += -Wno-unused-parameter -fvisibility=hidden
+QMAKE_LFLAGS += -fvisibility=hidden
+
+DEFINES += QT_NO_KEYWORDS NFCSHARE_LIBRARY
+
+CONFIG(debug, debug|release) {
+    DEFINES += DEBUG
+}
+
+# GDBus implementation of the LocalHostApp interface
+CONFIG(use_gio) {
+    PKGCONFIG += gio-2.0
+    DEFINES += HAVE_GIO
+}
+
+INCLUDEPATH += include
+
+PUBLIC_HEADERS = \
+    include/ndefapp.h \
+    include/ndefgenerator.h \
+    include/ndefmetrics.h \
+    include/ndefrecord.h \
+    include/ndeftag.h \
+    include/nfcshare.h \
+    include/nfcsharebearer.h \
+    include/nfcsharegenerator.h \
+    include/nfcshareservice.h \
+    include/nfcsharetypes.h
+
+HEADERS += \
+    $${PUBLIC_HEADERS} \
+    src/apdutrace.h \
+    src/ndefcache.h \
+    src/nfcsharelog.h \
+    src/sharehistory.h \
+    src/sneppush.h
+
+SOURCES += \
+    src/apdutrace.cpp \
+    src/ndefapp.cpp \
+    src/ndefcache.cpp \
+    src/ndefmetrics.cpp \
+    src/ndefrecord.cpp \
+    src/ndeftag.cpp \
+    src/nfcshare.cpp \
+    src/nfcsharebearer.cpp \
+    src/nfcsharegenerator.cpp \
+    src/nfcsharelog.cpp \
+    src/nfcshareservice.cpp \
+    src/sharehistory.cpp \
+    src/sneppush.cpp
+
+target.path = $$[QT_INSTALL_LIBS]
+INSTALLS += target
+
+headers.files = $${PUBLIC_HEADERS}
+headers.path = $$[QT_INSTALL_PREFIX]/include/nfcshare
+INSTALLS += headers
+
+QMAKE_PKGCONFIG_NAME = libnfcshare
+QMAKE_PKGCONFIG_DESCRIPTION = NFC sharing (Type 4 tag emulation and SNEP push)
+QMAKE_PKGCONFIG_LIBDIR = $$target.path
+QMAKE_PKGCONFIG_INCDIR = $$headers.path
+QMAKE_PKGCONFIG_REQUIRES = Qt5Core Qt5DBus
+QMAKE_PKGCONFIG_DESTDIR = pkgconfig
@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "apdutrace.h"
+#include "nfcsharelog.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+
+#define WARN(x) qCWarning(nfcshareApp) << x
+
+// ==========================================================================
+//
+// Trace file format (QDataStream, Qt 5.6 encoding, big-endian):
+//
+// +------------------------------------------------------------------------+
+// | Type       | Description                                               |
+// +------------+-----------------------------------------------------------+
+// | quint32    | Magic (NFCA)                                              |
+// | quint32    | Format version (2)                                        |
+// | quint32    | MLe passed to NdefTag (zero for the default)              |
+// | quint32    | Receive size passed to NdefTag (zero if read-only)        |
+// | QByteArray | NDEF message                                              |
+// | ...        | Entries                                                   |
+// +------------------------------------------------------------------------+
+//
+// Each entry starts with the type (quint8) and the timestamp (quint64,
+// nanoseconds) followed by the type specific fields:
+//
+// h:       QString host, which gets the next index (0, 1, 2...)
+// s, t, e: quint32 host index
+// c:       quint32 host index, quint8 cla, ins, p1, p2, QByteArray data,
+//          quint32 le, QByteArray response, quint8 sw1, sw2,
+//          quint32 response_id
+// r:       quint32 response_id, bool ok
+// n:       QByteArray NDEF message
+// a:       bool enabled
+//
+// Host paths are written once, the first time each one shows up, and
+// then referred to by index. The h entries aren't returned by next().
+//
+// ==========================================================================
+
+#define TRACE_MAGIC (0x4e464341)
+#define TRACE_VERSION (2)
+#define TRACE_STREAM_VERSION QDataStream::Qt_5_6
+#define TRACE_TYPE_HOST ('h')
+
+// ==========================================================================
+// ApduTrace::Entry
+// ==========================================================================
+
+ApduTrace::Entry::Entry() :
+    iType(TypeStart),
+    iTimestamp(0),
+    iCla(0),
+    iIns(0),
+    iP1(0),
+    iP2(0),
+    iLe(0),
+    iSw1(0),
+    iSw2(0),
+    iResponseId(0),
+    iOk(false)
+{}
+
+// ==========================================================================
+// ApduTrace
+// ==========================================================================
+
+ApduTrace::ApduTrace(
+    const QString& aFileName) :
+    iFile(new QFile(aFileName)),
+    iIn(Q_NULLPTR),
+    iMaxLe(0),
+    iReceiveSize(0)
+{
+    if (iFile->open(QIODevice::ReadOnly)) {
+        QDataStream* in = new QDataStream(iFile);
+        quint32 magic = 0, version = 0, maxLe = 0, receiveSize = 0;
+
+        in->setVersion(TRACE_STREAM_VERSION);
+        *in >> magic >> version;
+        if (in->status() == QDataStream::Ok && magic == TRACE_MAGIC &&
+            version == TRACE_VERSION) {
+            *in >> maxLe >> receiveSize >> iNdef;
+        }
+        if (in->status() == QDataStream::Ok && magic == TRACE_MAGIC &&
+            version == TRACE_VERSION) {
+            iIn = in;
+            iMaxLe = maxLe;
+            iReceiveSize = receiveSize;
+        } else {
+            WARN(aFileName << "is not an APDU trace (version"
+                << TRACE_VERSION << ")");
+            delete in;
+        }
+    } else {
+        WARN("Failed to open" << aFileName);
+    }
+}
+
+ApduTrace::~ApduTrace()
+{
+    delete iIn;
+    delete iFile;
+}
+
+bool
+ApduTrace::isValid() const
+{
+    return iIn != Q_NULLPTR;
+}
+
+const QByteArray&
+ApduTrace::ndef() const
+{
+    return iNdef;
+}
+
+uint
+ApduTrace::maxLe() const
+{
+    return iMaxLe;
+}
+
+uint
+ApduTrace::receiveSize() const
+{
+    return iReceiveSize;
+}
+
+bool
+ApduTrace::readHost(
+    QString& aHost)
+{
+    quint32 index = 0;
+
+    *iIn >> index;
+    if ((int)index < iHosts.size()) {
+        aHost = iHosts.at(index);
+        return true;
+    } else {
+        WARN("Undefined host" << index);
+        return false;
+    }
+}
+
+bool
+ApduTrace::next(
+    Entry& aEntry)
+{
+    while (iIn && !iIn->atEnd()) {
+        QDataStream& in = *iIn;
+        quint8 type = 0;
+        quint32 le = 0, id = 0;
+
+        in >> type >> aEntry.iTimestamp;
+        if (type == TRACE_TYPE_HOST) {
+            QString host;
+
+            in >> host;
+            iHosts.append(host);
+            if (in.status() != QDataStream::Ok) {
+                return false;
+            }
+            continue;
+        }
+
+        aEntry.iType = (Type)type;
+        switch (aEntry.iType) {
+        case TypeStart:
+        case TypeRestart:
+        case TypeStop:
+            if (!readHost(aEntry.iHost)) {
+                return false;
+            }
+            break;
+        case TypeCommand:
+            if (!readHost(aEntry.iHost)) {
+                return false;
+            }
+            in >> aEntry.iCla >> aEntry.iIns >> aEntry.iP1 >> aEntry.iP2 >>
+                aEntry.iData >> le >> aEntry.iResponse >> aEntry.iSw1 >>
+                aEntry.iSw2 >> id;
+            aEntry.iLe = le;
+            aEntry.iResponseId = id;
+            break;
+        case TypeStatus:
+            in >> id >> aEntry.iOk;
+            aEntry.iResponseId = id;
+            break;
+        case TypeReplace:
+            in >> aEntry.iData;
+            break;
+        case TypeLegacyAid:
+            in >> aEntry.iOk;
+            break;
+        default:
+            WARN("Unexpected trace entry type" << type);
+            return false;
+        }
+        return in.status() == QDataStream::Ok;
+    }
+    return false;
+}
+
+// ==========================================================================
+// ApduRecorder::Private
+// ==========================================================================
+
+class ApduRecorder::Private
+{
+public:
+    Private(const QString&);
+
+    quint32 host(const QString&);
+    void begin(ApduTrace::Type);
+    void begin(quint8);
+
+public:
+    QFile iFile;
+    QDataStream iOut;
+    QElapsedTimer iTimer;
+    QHash<QString,quint32> iHosts;
+};
+
+ApduRecorder::Private::Private(
+    const QString& aFileName) :
+    iFile(aFileName)
+{
+    iOut.setVersion(TRACE_STREAM_VERSION);
+    iTimer.start();
+}
+
+quint32
+ApduRecorder::Private::host(
+    const QString& aHost)
+{
+    // Must be called before the entry referring to the host is started
+    QHash<QString,quint32>::const_iterator it = iHosts.constFind(aHost);
+
+    if (it != iHosts.constEnd()) {
+        return it.value();
+    } else {
+        const quint32 index = iHosts.size();
+
+        begin((quint8)TRACE_TYPE_HOST);
+        iOut << aHost;
+        iHosts.insert(aHost, index);
+        return index;
+    }
+}
+
+void
+ApduRecorder::Private::begin(
+    ApduTrace::Type aType)
+{
+    begin((quint8)aType);
+}
+
+void
+ApduRecorder::Private::begin(
+    quint8 aType)
+{
+    iOut << aType << (quint64)iTimer.nsecsElapsed();
+}
+
+// ==========================================================================
+// ApduRecorder
+// ==========================================================================
+
+ApduRecorder::ApduRecorder(
+    const QString& aFileName,
+    const QByteArray& aNdef,
+    uint aMaxLe,
+    uint aReceiveSize) :
+    iPrivate(new Private(aFileName))
+{
+    if (iPrivate->iFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        iPrivate->iOut.setDevice(&iPrivate->iFile);
+        iPrivate->iOut << (quint32)TRACE_MAGIC << (quint32)TRACE_VERSION <<
+            (quint32)aMaxLe << (quint32)aReceiveSize << aNdef;
+        iPrivate->iFile.flush();
+    } else {
+        WARN("Failed to create" << aFileName);
+    }
+}
+
+ApduRecorder::~ApduRecorder()
+{
+    delete iPrivate;
+}
+
+bool
+ApduRecorder::isOpen() const
+{
+    return iPrivate->iFile.isOpen();
+}
+
+void
+ApduRecorder::start(
+    const QString& aHost)
+{
+    if (isOpen()) {
+        const quint32 host = iPrivate->host(aHost);
+
+        iPrivate->begin(ApduTrace::TypeStart);
+        iPrivate->iOut << host;
+    }
+}
+
+void
+ApduRecorder::restart(
+    const QString& aHost)
+{
+    if (isOpen()) {
+        const quint32 host = iPrivate->host(aHost);
+
+        iPrivate->begin(ApduTrace::TypeRestart);
+        iPrivate->iOut << host;
+    }
+}
+
+void
+ApduRecorder::stop(
+    const QString& aHost)
+{
+    if (isOpen()) {
+        const quint32 host = iPrivate->host(aHost);
+
+        iPrivate->begin(ApduTrace::TypeStop);
+        iPrivate->iOut << host;
+        // The session is over, make sure it's on disk
+        iPrivate->iFile.flush();
+    }
+}
+
+void
+ApduRecorder::command(
+    const QString& aHost,
+    uchar aCla,
+    uchar aIns,
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData,
+    uint aLe,
+    const QByteArray& aResponse,
+    uchar aSw1,
+    uchar aSw2,
+    uint aResponseId)
+{
+    if (isOpen()) {
+        const quint32 host = iPrivate->host(aHost);
+
+        iPrivate->begin(ApduTrace::TypeCommand);
+        iPrivate->iOut << host << aCla << aIns << aP1 << aP2 << aData <<
+            (quint32)aLe << aResponse << aSw1 << aSw2 <<
+            (quint32)aResponseId;
+    }
+}
+
+void
+ApduRecorder::status(
+    uint aResponseId,
+    bool aOk)
+{
+    if (isOpen()) {
+        iPrivate->begin(ApduTrace::TypeStatus);
+        iPrivate->iOut << (quint32)aResponseId << aOk;
+    }
+}
+
+void
+ApduRecorder::replace(
+    const QByteArray& aNdef)
+{
+    if (isOpen()) {
+        iPrivate->begin(ApduTrace::TypeReplace);
+        iPrivate->iOut << aNdef;
+    }
+}
+
+void
+ApduRecorder::legacyAid(
+    bool aEnabled)
+{
+    if (isOpen()) {
+        iPrivate->begin(ApduTrace::TypeLegacyAid);
+        iPrivate->iOut << aEnabled;
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef APDU_TRACE_H
+#define APDU_TRACE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+class QFile;
+class QDataStream;
+
+// Binary trace of a card emulation session. The file starts with
+// the NDEF message being shared and the tag parameters, followed by
+// one entry per call made by nfcd and per change made by NdefApp.
+class ApduTrace
+{
+    Q_DISABLE_COPY(ApduTrace)
+
+public:
+    enum Type {
+        TypeStart = 's',        // Start
+        TypeRestart = 't',      // Restart
+        TypeStop = 'e',         // Stop
+        TypeCommand = 'c',      // Process
+        TypeStatus = 'r',       // ResponseStatus
+        TypeReplace = 'n',      // Next generated message (in iData)
+        TypeLegacyAid = 'a'     // Legacy AID enabled or disabled (iOk)
+    };
+
+    class Entry {
+    public:
+        Entry();
+
+        Type iType;
+        quint64 iTimestamp;     // Nanoseconds since the trace was opened
+        QString iHost;
+        uchar iCla;
+        uchar iIns;
+        uchar iP1;
+        uchar iP2;
+        QByteArray iData;
+        uint iLe;
+        QByteArray iResponse;
+        uchar iSw1;
+        uchar iSw2;
+        uint iResponseId;
+        bool iOk;
+    };
+
+    // Opens an existing trace for reading
+    ApduTrace(const QString&);
+    ~ApduTrace();
+
+    bool isValid() const;
+    const QByteArray& ndef() const;
+    uint maxLe() const;
+    uint receiveSize() const;
+    bool next(Entry&);
+
+private:
+    bool readHost(QString&);
+
+private:
+    QFile* iFile;
+    QDataStream* iIn;
+    QByteArray iNdef;
+    uint iMaxLe;
+    uint iReceiveSize;
+    QStringList iHosts;     // Indexed by what the entries refer to
+};
+
+class ApduRecorder
+{
+    Q_DISABLE_COPY(ApduRecorder)
+    class Private;
+
+public:
+    // Creates (truncates) the trace and writes the header. MLe and
+    // receive size are the ones NdefTag has been created with.
+    ApduRecorder(const QString&, const QByteArray&, uint, uint);
+    ~ApduRecorder();
+
+    bool isOpen() const;
+    void start(const QString&);
+    void restart(const QString&);
+    void stop(const QString&);
+    void command(const QString&, uchar, uchar, uchar, uchar,
+        const QByteArray&, uint, const QByteArray&, uchar, uchar, uint);
+    void status(uint, bool);
+    void replace(const QByteArray&);
+    void legacyAid(bool);
+
+private:
+    Private* iPrivate;
+};
+
+#endif // APDU_TRACE_H
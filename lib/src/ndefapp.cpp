@@ -0,0 +1,2105 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "apdutrace.h"
+#include "ndefapp.h"
+#include "ndefmetrics.h"
+#include "ndeftag.h"
+#include "nfcsharelog.h"
+#include "sharehistory.h"
+#include "sneppush.h"
+
+#include <QtCore/QAbstractEventDispatcher>
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QQueue>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+#include <QtCore/QtMath>
+#include <QtDBus/QDBusAbstractAdaptor>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusObjectPath>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusUnixFileDescriptor>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef HAVE_GIO
+#  include <gio/gio.h>
+#endif
+
+#define DBG(x) qCDebug(nfcshareApp) << x
+#define DUMP(x) qCDebug(nfcshareApdu) << x
+#define WARN(x) qCWarning(nfcshareApp) << x
+#define TRACE(...) qCDebug(nfcshareTrace, __VA_ARGS__)
+
+#define NFCSHARE_DBUS_ADDRESS_ENV "NFCSHARE_DBUS_ADDRESS"
+#define NFCSHARE_DBUS_BACKEND_ENV "NFCSHARE_DBUS_BACKEND"
+#define NFCSHARE_APDU_TRACE_ENV "NFCSHARE_APDU_TRACE"
+#define NFCSHARE_HISTORY_FILE_ENV "NFCSHARE_HISTORY_FILE"
+#define NFCSHARE_LEGACY_AID_ENV "NFCSHARE_LEGACY_AID"
+#define NFCSHARE_MAX_LE_ENV "NFCSHARE_MAX_LE"
+#define NFCSHARE_TECHS_ENV "NFCSHARE_TECHS"
+
+#define ISO_INS_SELECT (0xa4)
+
+#define PROGRESS_INTERVAL_MS (16)
+
+// SNEP push retries with the peer which is still in the field
+#define SNEP_RETRY_DELAY_MS (200)
+#define SNEP_MAX_RETRIES (3)
+
+// ==========================================================================
+// NdefApp::Private
+// ==========================================================================
+
+class NdefApp::Private :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfc.LocalHostApp")
+    Q_CLASSINFO("D-Bus Introspection",
+        "<interface name=\"org.sailfishos.nfc.LocalHostApp\">\n"
+        "  <method name=\"GetInterfaceVersion\">\n"
+        "    <arg name=\"version\" type=\"i\" direction=\"out\"/>\n"
+        "  </method>\n"
+        "  <method name=\"Start\">\n"
+        "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+        "  </method>\n"
+        "  <method name=\"Restart\">\n"
+        "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+        "  </method>\n"
+        "  <method name=\"Stop\">\n"
+        "    <arg name=\"path\" type=\"o\" direction=\"in\"/>\n"
+        "  </method>\n"
+        "  <method name=\"ImplicitSelect\">\n"
+        "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+        "  </method>\n"
+        "  <method name=\"Select\">\n"
+        "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+        "  </method>\n"
+        "  <method name=\"Deselect\">\n"
+        "    <arg name=\"path\" type=\"o\" direction=\"in\"/>\n"
+        "  </method>\n"
+        "  <method name=\"Process\">\n"
+        "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+        "    <arg name=\"CLA\" type=\"y\" direction=\"in\"/>\n"
+        "    <arg name=\"INS\" type=\"y\" direction=\"in\"/>\n"
+        "    <arg name=\"P1\" type=\"y\" direction=\"in\"/>\n"
+        "    <arg name=\"P2\" type=\"y\" direction=\"in\"/>\n"
+        "    <arg name=\"data\" type=\"ay\" direction=\"in\"/>\n"
+        "    <arg name=\"Le\" type=\"u\" direction=\"in\"/>\n"
+        "    <arg name=\"response\" type=\"ay\" direction=\"out\"/>\n"
+        "    <arg name=\"SW1\" type=\"y\" direction=\"out\"/>\n"
+        "    <arg name=\"SW2\" type=\"y\" direction=\"out\"/>\n"
+        "    <arg name=\"response_id\" type=\"u\" direction=\"out\"/>\n"
+        "  </method>\n"
+        "  <method name=\"ResponseStatus\">\n"
+        "    <arg name=\"response_id\" type=\"u\" direction=\"in\"/>\n"
+        "    <arg name=\"ok\" type=\"b\" direction=\"in\"/>\n"
+        "  </method>\n"
+        "</interface>\n")
+
+    enum { INTERFACE_VERSION = 1 };
+    class Orphan;
+
+    static const QString NFC_SERVICE_NAME;
+    static const QString NFC_SERVICE_INTERFACE;
+    static const QString NFC_SERVICE_PATH;
+    static const QString STATIC_TAG_PATH;
+    static const QString STATIC_TAG_INTERFACE;
+    static const QString APP_PATH;
+    static const QString LEGACY_APP_PATH;
+    static const QString HOST_INTERFACE;
+
+public:
+    Private(const void*, uint, Transport, NdefApp*, NdefGenerator*, uint,
+        uint);
+    ~Private();
+
+    bool isTooMuchData() const;
+    void reacquire();
+    void setIdleTimeout(int);
+    void setTechs(int);
+    uint bytesTransferred() const;
+    qreal transferRate() const;
+    qreal estimatedTimeRemaining() const;
+    void localHostAppRegistered();
+#ifdef HAVE_GIO
+    void gioAppRegistered(GioHost*, bool);
+#endif
+    NdefTag::Response process(const QString&, uchar, uchar, uchar, uchar, const QByteArray&, uint);
+
+public Q_SLOTS:
+    int GetInterfaceVersion();
+    void Start(QDBusObjectPath);
+    void Restart(QDBusObjectPath);
+    void Stop(QDBusObjectPath);
+    void ImplicitSelect(QDBusObjectPath);
+    void Select(QDBusObjectPath);
+    void Deselect(QDBusObjectPath);
+    void Process(QDBusObjectPath, uchar, uchar, uchar, uchar,  QByteArray, uint, QDBusMessage);
+    void ResponseStatus(uint, bool);
+
+private Q_SLOTS:
+    void onRegisterLocalHostAppFinished(QDBusPendingCallWatcher*);
+    void onRegisterLegacyAppFinished(QDBusPendingCallWatcher*);
+    void onRequestModeFinished(QDBusPendingCallWatcher*);
+    void onRequestTechsFinished(QDBusPendingCallWatcher*);
+    void onSnepBytesSentChanged();
+    void onSnepFailed();
+    void onSnepDone();
+    void onPublishFinished(QDBusPendingCallWatcher*);
+    void onStaticTagProgress(uint, uint, uint);
+    void onStaticTagDone(uint);
+    void onProgressTimer();
+    void onIdleTimeout();
+    void onPoolTimer();
+    void onHostTechnologyFinished(QDBusPendingCallWatcher*);
+
+private:
+    static QDBusMessage createMethodCall(QString);
+    static QDBusConnection nfcBus();
+    static uint maxLe();
+#ifdef HAVE_GIO
+    static bool useGio();
+#endif
+    static QVariantList replyArgs(const NdefTag::Response&);
+    NdefApp* parentObject();
+    void callAsync(const QDBusMessage&, const char*, const QDBusMessage&);
+    void callFinished();
+    bool publishStaticTag(const QByteArray&);
+    void registerLocalHostApp();
+    void registerLegacyApp();
+    void appRegistered();
+    void setLegacyAidEnabled(bool);
+    bool isDuplicateStart(const QString&);
+    void startSession(const QString&);
+    void nextMessage();
+    void fillPool();
+    void sessionActivated();
+    void requestMode();
+    void requestTechs();
+    void handleTagEvents(int);
+    void progressChanged(bool aFinal = false);
+    void releaseLease();
+    bool dropLease();
+    void setLeaseState(LeaseState);
+    void touch();
+    void setDone();
+    void appendHistory(const QString&);
+
+public:
+    const Transport iTransport;
+    NdefTag iTag;
+    bool iDone;
+    bool iRegisteredApp;
+    bool iRegisteredLegacyApp;
+    uint iRegisteredModeId;
+    uint iRegisteredTechsId;
+    LeaseState iLeaseState;
+    bool iReady;
+    QString iText;
+    QDBusConnection iBus;
+    bool iRegisteredObject;
+    bool iRegisteredLegacyObject;
+    const bool iLegacyAid;  // Also serve the v1 NDEF application
+    SnepPush* iSnep;
+    uint iSnepFailures;     // In a row
+    GioHost* iGioHost;
+    GioHost* iGioLegacyHost;
+    uint iStaticTagId;
+    uint iStaticTagBytes;
+    uint iSessions;
+    NdefMetrics* iMetrics;
+    ApduRecorder* iRecorder;
+    QDBusPendingCallWatcher* iPendingCall;
+    QDBusMessage iPendingRelease;
+    uint iNdefSize;
+    QByteArray iRecordType;
+    QString iHost;
+    QTimer* iProgressTimer;
+    qreal iRateStartMs;     // When the first chunk got confirmed
+    uint iRateStartBytes;
+    qreal iRateLastMs;
+    uint iRateLastBytes;
+    QTimer* iIdleTimer;
+    int iIdleTimeout;       // Zero if off
+    qreal iLastActivityMs;
+    qreal iLeaseStartMs;
+    bool iActive;           // Between Start and Stop
+    bool iFresh;            // Started but no APDUs yet
+    int iTechs;
+    QDBusPendingCallWatcher* iTechCall;
+    qreal iSessionStartMs;
+    uint iSessionTech;      // Zero until known
+    qreal iActivationMs;    // Start to the first successful SELECT
+    bool iActivationReported;
+    NdefGenerator* iGenerator;
+    const int iPoolSize;
+    QQueue<QByteArray> iPool;
+    QTimer* iPoolTimer;
+    bool iMessageUsed;      // Has been offered to a reader
+    bool iDelivered;        // Has been read in full
+};
+
+const QString NdefApp::Private::APP_PATH("/ndefshare");
+const QString NdefApp::Private::LEGACY_APP_PATH("/ndefshare/v1");
+const QString NdefApp::Private::HOST_INTERFACE("org.sailfishos.nfc.Host");
+const QString NdefApp::Private::NFC_SERVICE_NAME("org.sailfishos.nfc.daemon");
+const QString NdefApp::Private::NFC_SERVICE_INTERFACE("org.sailfishos.nfc.Daemon");
+const QString NdefApp::Private::NFC_SERVICE_PATH("/");
+const QString NdefApp::Private::STATIC_TAG_PATH("/ndefshare");
+const QString NdefApp::Private::STATIC_TAG_INTERFACE("org.sailfishos.nfc.StaticTag");
+
+#ifdef HAVE_GIO
+
+// ==========================================================================
+// NdefApp::GioHost
+//
+// GDBus implementation of org.sailfishos.nfc.LocalHostApp, which skips
+// meta-object invocation and QVariant marshalling. Method calls are
+// dispatched by the default GLib main context, i.e. this requires Qt
+// to run on top of the GLib event dispatcher (which is the case on
+// Sailfish OS).
+// ==========================================================================
+
+class NdefApp::GioHost
+{
+    class Registration;
+
+public:
+    GioHost(Private*, const QString&);
+    ~GioHost();
+
+    void registerApp(const QByteArray&, uint);
+
+private:
+    static void methodCall(GDBusConnection*, const char*, const char*,
+        const char*, const char*, GVariant*, GDBusMethodInvocation*,
+        gpointer);
+    static void registerAppDone(GObject*, GAsyncResult*, gpointer);
+    static void freeByteArray(gpointer);
+    static GDBusConnection* nfcBus();
+    void call(const char*, GVariant*);
+
+private:
+    static const char INTROSPECTION_XML[];
+    static const GDBusInterfaceVTable VTABLE;
+    Private* iPrivate;
+    GDBusConnection* iBus;
+    Registration* iRegistration;    // RegisterLocalHostApp in progress
+    QByteArray iPath;
+    guint iObjectId;
+    bool iRegisteredApp;
+};
+
+// Context of the RegisterLocalHostApp call. Outlives the host if it
+// gets destroyed while the call is in progress, in which case the app
+// gets unregistered once nfcd completes the call. Cancelling the call
+// would only drop the reply, nfcd would still register the app.
+class NdefApp::GioHost::Registration
+{
+public:
+    Registration(GioHost*);
+    ~Registration();
+
+public:
+    GioHost* iHost;     // Null once the host is gone
+    GDBusConnection* iBus;
+    QByteArray iPath;
+};
+
+NdefApp::GioHost::Registration::Registration(
+    GioHost* aHost) :
+    iHost(aHost),
+    iBus(G_DBUS_CONNECTION(g_object_ref(aHost->iBus))),
+    iPath(aHost->iPath)
+{
+}
+
+NdefApp::GioHost::Registration::~Registration()
+{
+    g_object_unref(iBus);
+}
+
+const char NdefApp::GioHost::INTROSPECTION_XML[] =
+    "<node>\n"
+    "<interface name=\"org.sailfishos.nfc.LocalHostApp\">\n"
+    "  <method name=\"GetInterfaceVersion\">\n"
+    "    <arg name=\"version\" type=\"i\" direction=\"out\"/>\n"
+    "  </method>\n"
+    "  <method name=\"Start\">\n"
+    "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+    "  </method>\n"
+    "  <method name=\"Restart\">\n"
+    "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+    "  </method>\n"
+    "  <method name=\"Stop\">\n"
+    "    <arg name=\"path\" type=\"o\" direction=\"in\"/>\n"
+    "  </method>\n"
+    "  <method name=\"ImplicitSelect\">\n"
+    "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+    "  </method>\n"
+    "  <method name=\"Select\">\n"
+    "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+    "  </method>\n"
+    "  <method name=\"Deselect\">\n"
+    "    <arg name=\"path\" type=\"o\" direction=\"in\"/>\n"
+    "  </method>\n"
+    "  <method name=\"Process\">\n"
+    "    <arg name=\"host\" type=\"o\" direction=\"in\"/>\n"
+    "    <arg name=\"CLA\" type=\"y\" direction=\"in\"/>\n"
+    "    <arg name=\"INS\" type=\"y\" direction=\"in\"/>\n"
+    "    <arg name=\"P1\" type=\"y\" direction=\"in\"/>\n"
+    "    <arg name=\"P2\" type=\"y\" direction=\"in\"/>\n"
+    "    <arg name=\"data\" type=\"ay\" direction=\"in\"/>\n"
+    "    <arg name=\"Le\" type=\"u\" direction=\"in\"/>\n"
+    "    <arg name=\"response\" type=\"ay\" direction=\"out\"/>\n"
+    "    <arg name=\"SW1\" type=\"y\" direction=\"out\"/>\n"
+    "    <arg name=\"SW2\" type=\"y\" direction=\"out\"/>\n"
+    "    <arg name=\"response_id\" type=\"u\" direction=\"out\"/>\n"
+    "  </method>\n"
+    "  <method name=\"ResponseStatus\">\n"
+    "    <arg name=\"response_id\" type=\"u\" direction=\"in\"/>\n"
+    "    <arg name=\"ok\" type=\"b\" direction=\"in\"/>\n"
+    "  </method>\n"
+    "</interface>\n"
+    "</node>\n";
+
+const GDBusInterfaceVTable NdefApp::GioHost::VTABLE = {
+    NdefApp::GioHost::methodCall, Q_NULLPTR, Q_NULLPTR, { Q_NULLPTR }
+};
+
+NdefApp::GioHost::GioHost(
+    Private* aPrivate,
+    const QString& aPath) :
+    iPrivate(aPrivate),
+    iBus(nfcBus()),
+    iRegistration(Q_NULLPTR),
+    iPath(aPath.toLatin1()),
+    iObjectId(0),
+    iRegisteredApp(false)
+{
+    if (iBus) {
+        GDBusNodeInfo* node = g_dbus_node_info_new_for_xml(INTROSPECTION_XML,
+            Q_NULLPTR);
+
+        iObjectId = g_dbus_connection_register_object(iBus,
+            iPath.constData(), node->interfaces[0], &VTABLE, this,
+            Q_NULLPTR, Q_NULLPTR);
+        g_dbus_node_info_unref(node);
+    }
+    if (!iObjectId) {
+        WARN("Failed to register" << iPath.constData());
+    }
+}
+
+NdefApp::GioHost::~GioHost()
+{
+    if (iRegistration) {
+        // Let registerAppDone() clean up after us
+        iRegistration->iHost = Q_NULLPTR;
+    }
+    if (iBus) {
+        if (iRegisteredApp) {
+            // <method name="UnregisterLocalHostApp">
+            //   <arg name="path" type="o" direction="in"/>
+            // </method>
+            call("UnregisterLocalHostApp", g_variant_new("(o)",
+                iPath.constData()));
+        }
+        if (iObjectId) {
+            g_dbus_connection_unregister_object(iBus, iObjectId);
+        }
+        g_object_unref(iBus);
+    }
+}
+
+void
+NdefApp::GioHost::call(
+    const char* aMethod,
+    GVariant* aArgs)
+{
+    g_dbus_connection_call(iBus, "org.sailfishos.nfc.daemon", "/",
+        "org.sailfishos.nfc.Daemon", aMethod, aArgs, Q_NULLPTR,
+        G_DBUS_CALL_FLAGS_NONE, -1, Q_NULLPTR, Q_NULLPTR, Q_NULLPTR);
+}
+
+void
+NdefApp::GioHost::registerApp(
+    const QByteArray& aAid,
+    uint aFlags)
+{
+    if (iRegistration) {
+        DBG(iPath.constData() << "is already being registered");
+    } else if (iObjectId) {
+        iRegistration = new Registration(this);
+
+        // Same RegisterLocalHostApp call as the QtDBus one
+        g_dbus_connection_call(iBus, "org.sailfishos.nfc.daemon", "/",
+            "org.sailfishos.nfc.Daemon", "RegisterLocalHostApp",
+            g_variant_new("(os@ayu)", iPath.constData(),
+                "NfcShare", g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
+                aAid.constData(), aAid.size(), 1), aFlags),
+            Q_NULLPTR, G_DBUS_CALL_FLAGS_NONE, -1, Q_NULLPTR,
+            registerAppDone, iRegistration);
+    } else {
+        iPrivate->gioAppRegistered(this, false);
+    }
+}
+
+//static
+void
+NdefApp::GioHost::registerAppDone(
+    GObject* aBus,
+    GAsyncResult* aResult,
+    gpointer aRegistration)
+{
+    Registration* reg = (Registration*)aRegistration;
+    GioHost* self = reg->iHost;
+    GError* error = Q_NULLPTR;
+    GVariant* ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(aBus),
+        aResult, &error);
+
+    if (self) {
+        self->iRegistration = Q_NULLPTR;
+    }
+    if (ret) {
+        g_variant_unref(ret);
+        if (self) {
+            self->iRegisteredApp = true;
+            self->iPrivate->gioAppRegistered(self, true);
+        } else {
+            // <method name="UnregisterLocalHostApp">
+            //   <arg name="path" type="o" direction="in"/>
+            // </method>
+            DBG("Undoing orphaned RegisterLocalHostApp");
+            g_dbus_connection_call(reg->iBus, "org.sailfishos.nfc.daemon",
+                "/", "org.sailfishos.nfc.Daemon", "UnregisterLocalHostApp",
+                g_variant_new("(o)", reg->iPath.constData()), Q_NULLPTR,
+                G_DBUS_CALL_FLAGS_NONE, -1, Q_NULLPTR, Q_NULLPTR, Q_NULLPTR);
+        }
+    } else {
+        WARN(error->message);
+        if (self) {
+            self->iPrivate->gioAppRegistered(self, false);
+        }
+        g_error_free(error);
+    }
+    delete reg;
+}
+
+//static
+GDBusConnection*
+NdefApp::GioHost::nfcBus()
+{
+    // Same as NdefApp::Private::nfcBus(), including the private bus
+    // connection being shared by all apps (like the system bus one) so
+    // that calls made by consecutive apps don't overtake each other
+    static GDBusConnection* privateBus = Q_NULLPTR;
+    static QByteArray privateAddress;
+    const QByteArray address(qgetenv(NFCSHARE_DBUS_ADDRESS_ENV));
+
+    if (address.isEmpty()) {
+        return g_bus_get_sync(G_BUS_TYPE_SYSTEM, Q_NULLPTR, Q_NULLPTR);
+    } else {
+        if (privateBus && (address != privateAddress ||
+            g_dbus_connection_is_closed(privateBus))) {
+            g_object_unref(privateBus);
+            privateBus = Q_NULLPTR;
+        }
+        if (!privateBus) {
+            privateBus = g_dbus_connection_new_for_address_sync(
+                address.constData(), (GDBusConnectionFlags)
+                (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                 G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+                Q_NULLPTR, Q_NULLPTR, Q_NULLPTR);
+            privateAddress = address;
+        }
+        return privateBus ? G_DBUS_CONNECTION(g_object_ref(privateBus)) :
+            Q_NULLPTR;
+    }
+}
+
+//static
+void
+NdefApp::GioHost::freeByteArray(
+    gpointer aData)
+{
+    delete (QByteArray*)aData;
+}
+
+//static
+void
+NdefApp::GioHost::methodCall(
+    GDBusConnection*,
+    const char*,
+    const char*,
+    const char*,
+    const char* aMethod,
+    GVariant* aArgs,
+    GDBusMethodInvocation* aCall,
+    gpointer aSelf)
+{
+    Private* priv = ((GioHost*)aSelf)->iPrivate;
+
+    if (!strcmp(aMethod, "Process")) {
+        const char* host;
+        guchar cla, ins, p1, p2;
+        guint le;
+        GVariant* data;
+        gsize size;
+
+        g_variant_get(aArgs, "(&oyyyy@ayu)", &host, &cla, &ins, &p1, &p2,
+            &data, &le);
+
+        // Neither the command nor the response data get copied
+        const void* bytes = g_variant_get_fixed_array(data, &size, 1);
+        const NdefTag::Response resp(priv->process(QString::fromLatin1(host),
+            cla, ins, p1, p2, QByteArray::fromRawData((const char*)bytes,
+            size), le));
+        QByteArray* out = new QByteArray(resp.data());
+
+        g_variant_unref(data);
+        g_dbus_method_invocation_return_value(aCall,
+            g_variant_new("(@ayyyu)", g_variant_new_from_data(
+                G_VARIANT_TYPE_BYTESTRING, out->constData(), out->size(),
+                TRUE, freeByteArray, out), resp.sw1(), resp.sw2(),
+                resp.id()));
+    } else if (!strcmp(aMethod, "ResponseStatus")) {
+        guint id;
+        gboolean ok;
+
+        g_variant_get(aArgs, "(ub)", &id, &ok);
+        priv->ResponseStatus(id, ok);
+        g_dbus_method_invocation_return_value(aCall, Q_NULLPTR);
+    } else if (!strcmp(aMethod, "GetInterfaceVersion")) {
+        g_dbus_method_invocation_return_value(aCall,
+            g_variant_new("(i)", priv->GetInterfaceVersion()));
+    } else {
+        const char* path;
+
+        g_variant_get(aArgs, "(&o)", &path);
+        const QDBusObjectPath host(QString::fromLatin1(path));
+
+        if (!strcmp(aMethod, "Start")) {
+            priv->Start(host);
+        } else if (!strcmp(aMethod, "Restart")) {
+            priv->Restart(host);
+        } else if (!strcmp(aMethod, "Stop")) {
+            priv->Stop(host);
+        } else if (!strcmp(aMethod, "ImplicitSelect")) {
+            priv->ImplicitSelect(host);
+        } else if (!strcmp(aMethod, "Select")) {
+            priv->Select(host);
+        } else if (!strcmp(aMethod, "Deselect")) {
+            priv->Deselect(host);
+        }
+        g_dbus_method_invocation_return_value(aCall, Q_NULLPTR);
+    }
+}
+
+//static
+bool
+NdefApp::Private::useGio()
+{
+    // GDBus calls only get dispatched if Qt runs the GLib main loop,
+    // which isn't the case with QT_NO_GLIB=1 or a custom dispatcher
+    const QAbstractEventDispatcher* dispatcher =
+        QAbstractEventDispatcher::instance();
+
+    if (!dispatcher || !dispatcher->inherits("QEventDispatcherGlib")) {
+        DBG("Not running GLib event loop, using QtDBus");
+        return false;
+    }
+
+    // NFCSHARE_DBUS_BACKEND=qt switches back to QtDBus
+    const char* backend = getenv(NFCSHARE_DBUS_BACKEND_ENV);
+
+    return !backend || strcmp(backend, "qt");
+}
+
+#endif // HAVE_GIO
+
+// ==========================================================================
+// NdefApp::Private::Orphan
+//
+// Outlives NdefApp::Private if it gets destroyed while a registration
+// step is still in progress, and undoes that step once nfcd completes
+// it. Otherwise quickly recreated shares would leave registrations
+// and mode/tech requests behind in nfcd.
+// ==========================================================================
+
+class NdefApp::Private::Orphan :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    Orphan(QDBusConnection, QDBusPendingCallWatcher*, const QDBusMessage&);
+
+private Q_SLOTS:
+    void onFinished(QDBusPendingCallWatcher*);
+
+private:
+    QDBusConnection iBus;
+    QDBusMessage iRelease;
+};
+
+NdefApp::Private::Orphan::Orphan(
+    QDBusConnection aBus,
+    QDBusPendingCallWatcher* aWatcher,
+    const QDBusMessage& aRelease) :
+    iBus(aBus),
+    iRelease(aRelease)
+{
+    aWatcher->disconnect();
+    aWatcher->setParent(this);
+    connect(aWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+        SLOT(onFinished(QDBusPendingCallWatcher*)));
+}
+
+void
+NdefApp::Private::Orphan::onFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    const QDBusMessage reply(aWatcher->reply());
+
+    if (reply.type() == QDBusMessage::ReplyMessage) {
+        QDBusMessage msg(iRelease);
+
+        // The id returned by the call is what needs to be released,
+        // RegisterLocalHostApp returns nothing and gets undone by path
+        if (msg.arguments().isEmpty() && !reply.arguments().isEmpty()) {
+            msg << reply.arguments().first();
+        }
+        DBG("Undoing orphaned" << msg.member());
+        iBus.asyncCall(msg);
+    }
+    deleteLater();
+}
+
+NdefApp::Private::Private(
+    const void* aNdefData,
+    uint aNdefSize,
+    Transport aTransport,
+    NdefApp* aApp,
+    NdefGenerator* aGenerator,
+    uint aPoolSize,
+    uint aReceiveSize) :
+    QDBusAbstractAdaptor(aApp),
+    iTransport(aTransport),
+    iTag(aNdefData, aNdefSize, maxLe(), aReceiveSize),
+    iDone(false),
+    iRegisteredApp(false),
+    iRegisteredLegacyApp(false),
+    iRegisteredModeId(0),
+    iRegisteredTechsId(0),
+    iLeaseState(LeaseNone),
+    iReady(false),
+    iBus(nfcBus()),
+    iRegisteredObject(false),
+    iRegisteredLegacyObject(false),
+    iLegacyAid(!qgetenv(NFCSHARE_LEGACY_AID_ENV).isEmpty()),
+    iSnep(Q_NULLPTR),
+    iSnepFailures(0),
+    iGioHost(Q_NULLPTR),
+    iGioLegacyHost(Q_NULLPTR),
+    iStaticTagId(0),
+    iStaticTagBytes(0),
+    iSessions(0),
+    iMetrics(new NdefMetrics(aApp)),
+    iRecorder(Q_NULLPTR),
+    iPendingCall(Q_NULLPTR),
+    iNdefSize(aNdefSize),
+    iRecordType(aNdefData ? ShareHistory::Record::recordType(
+        QByteArray::fromRawData((const char*)aNdefData, aNdefSize)) :
+        QByteArray()),
+    iProgressTimer(new QTimer(this)),
+    iRateStartMs(-1),
+    iRateStartBytes(0),
+    iRateLastMs(-1),
+    iRateLastBytes(0),
+    iIdleTimer(new QTimer(this)),
+    iIdleTimeout(0),
+    iLastActivityMs(0),
+    iLeaseStartMs(-1),
+    iActive(false),
+    iFresh(false),
+    iTechs(defaultTechs()),
+    iTechCall(Q_NULLPTR),
+    iSessionStartMs(-1),
+    iSessionTech(0),
+    iActivationMs(-1),
+    iActivationReported(false),
+    iGenerator(aGenerator),
+    iPoolSize(qMax(aPoolSize, 1u)),
+    iPoolTimer(Q_NULLPTR),
+    iMessageUsed(false),
+    iDelivered(false)
+{
+    // Progress notifications are coalesced to the display frame rate,
+    // there's no point in updating the UI more often than that
+    iProgressTimer->setSingleShot(true);
+    iProgressTimer->setInterval(PROGRESS_INTERVAL_MS);
+    connect(iProgressTimer, SIGNAL(timeout()), SLOT(onProgressTimer()));
+
+    // Idle timeout is off until configured
+    iIdleTimer->setSingleShot(true);
+    connect(iIdleTimer, SIGNAL(timeout()), SLOT(onIdleTimeout()));
+
+#ifdef HAVE_GIO
+    if (useGio()) {
+        iGioHost = new GioHost(this, APP_PATH);
+        if (iLegacyAid) {
+            iGioLegacyHost = new GioHost(this, LEGACY_APP_PATH);
+        }
+    }
+#endif
+    if (!iGioHost) {
+        iRegisteredObject = iBus.registerObject(APP_PATH, this,
+            QDBusConnection::ExportAllSlots);
+        if (iLegacyAid) {
+            // Same object, different path
+            iRegisteredLegacyObject = iBus.registerObject(LEGACY_APP_PATH,
+                this, QDBusConnection::ExportAllSlots);
+        }
+    }
+
+    // If the message is too large, we deliberately leave the object
+    // in a non-ready state.
+    if (!isTooMuchData()) {
+        const QByteArray ndef((const char*)aNdefData, aNdefSize);
+        const QByteArray traceFile(qgetenv(NFCSHARE_APDU_TRACE_ENV));
+
+        if (!traceFile.isEmpty() && iTransport != TransportSnep) {
+            // APDUs have to go through us to get recorded, which rules
+            // out the static tag plugin
+            iRecorder = new ApduRecorder(QString::fromLocal8Bit(traceFile),
+                ndef, maxLe(), aReceiveSize);
+        }
+
+        // Go through the asynchronous sequence:
+        //
+        // 1. Publish(memfd) to nfcd's static tag plugin, if available,
+        //    or else RegisterLocalHostApp("/ndefshare") (unless SNEP only)
+        // 2. RequestMode(CardEmulation and/or P2P Target)
+        // 3. RequestTechs(NFC-A and/or NFC-B)
+        //
+        // The sequence can be aborted at any point.
+        // The static tag can't change its message between sessions
+        // and can't be written to
+        if (iTransport == TransportSnep) {
+            requestMode();
+        } else if (iRecorder || iGenerator || aReceiveSize ||
+            !publishStaticTag(ndef)) {
+            registerLocalHostApp();
+        }
+
+        if (iGenerator) {
+            // Pool gets filled from the event loop, one message at a time
+            iPoolTimer = new QTimer(this);
+            iPoolTimer->setSingleShot(true);
+            iPoolTimer->setInterval(0);
+            connect(iPoolTimer, SIGNAL(timeout()), SLOT(onPoolTimer()));
+            iPoolTimer->start();
+        }
+
+        // SNEP push starts as soon as a peer shows up. It's a one-off
+        // thing, the generator doesn't get to rotate what's pushed.
+        if (iTransport != TransportType4) {
+            if (iGenerator) {
+                DBG("SNEP pushes the first generated message only");
+            }
+            iSnep = new SnepPush(iBus, ndef, this);
+            connect(iSnep, SIGNAL(bytesSentChanged()),
+                SLOT(onSnepBytesSentChanged()));
+            connect(iSnep, SIGNAL(failed()), SLOT(onSnepFailed()));
+            connect(iSnep, SIGNAL(done()), SLOT(onSnepDone()));
+        }
+    }
+}
+
+NdefApp::Private::~Private()
+{
+    if (iPendingCall) {
+        // Deletes itself when the call completes
+        new Orphan(iBus, iPendingCall, iPendingRelease);
+    }
+
+    // Undo the initialization sequence:
+    if (iStaticTagId) {
+        // <method name="Withdraw">
+        //   <arg name="id" type="u" direction="in"/>
+        // </method>
+        QDBusMessage msg(QDBusMessage::createMethodCall(NFC_SERVICE_NAME,
+            STATIC_TAG_PATH, STATIC_TAG_INTERFACE, "Withdraw"));
+        msg << iStaticTagId;
+        iBus.asyncCall(msg);
+    }
+    releaseLease();
+    if (iRegisteredApp) {
+        // <method name="UnregisterLocalHostApp">
+        //   <arg name="path" type="o" direction="in"/>
+        // </method>
+        QDBusMessage msg(createMethodCall("UnregisterLocalHostApp"));
+        msg << QVariant::fromValue(QDBusObjectPath(APP_PATH)); // path
+        iBus.asyncCall(msg);
+    }
+    if (iRegisteredLegacyApp) {
+        QDBusMessage msg(createMethodCall("UnregisterLocalHostApp"));
+        msg << QVariant::fromValue(QDBusObjectPath(LEGACY_APP_PATH));
+        iBus.asyncCall(msg);
+    }
+    if (iRegisteredObject) {
+        iBus.unregisterObject(APP_PATH);
+    }
+    if (iRegisteredLegacyObject) {
+        iBus.unregisterObject(LEGACY_APP_PATH);
+    }
+#ifdef HAVE_GIO
+    delete iGioLegacyHost;
+    delete iGioHost;
+#endif
+
+    const QByteArray metricsFile(qgetenv("NFCSHARE_METRICS_FILE"));
+    if (!metricsFile.isEmpty()) {
+        iMetrics->dump(QString::fromLocal8Bit(metricsFile));
+    }
+
+    const QByteArray historyFile(qgetenv(NFCSHARE_HISTORY_FILE_ENV));
+    if (!historyFile.isEmpty()) {
+        appendHistory(QString::fromLocal8Bit(historyFile));
+    }
+    delete iRecorder;
+}
+
+bool
+NdefApp::Private::publishStaticTag(
+    const QByteArray& aNdef)
+{
+    // Hand the NDEF message over to nfcd in a sealed memfd, so that
+    // APDUs get handled right inside nfcd
+    const int fd = memfd_create("ndefshare", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if (fd >= 0) {
+        bool ok = false;
+
+        if (write(fd, aNdef.constData(), aNdef.size()) == (ssize_t)aNdef.size() &&
+            fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+            F_SEAL_WRITE | F_SEAL_SEAL) == 0) {
+            // <method name="Publish">
+            //   <arg name="fd" type="h" direction="in"/>
+            //   <arg name="id" type="u" direction="out"/>
+            // </method>
+            TRACE("publish.begin t=%.3f", iMetrics->elapsed());
+            QDBusMessage msg(QDBusMessage::createMethodCall(NFC_SERVICE_NAME,
+                STATIC_TAG_PATH, STATIC_TAG_INTERFACE, "Publish"));
+            msg << QVariant::fromValue(QDBusUnixFileDescriptor(fd));
+            callAsync(msg, SLOT(onPublishFinished(QDBusPendingCallWatcher*)),
+                QDBusMessage::createMethodCall(NFC_SERVICE_NAME,
+                STATIC_TAG_PATH, STATIC_TAG_INTERFACE, "Withdraw"));
+            ok = true;
+        }
+        // QDBusUnixFileDescriptor keeps its own copy
+        close(fd);
+        return ok;
+    }
+    return false;
+}
+
+void
+NdefApp::Private::callAsync(
+    const QDBusMessage& aCall,
+    const char* aSlot,
+    const QDBusMessage& aRelease)
+{
+    // Registration steps are done one at a time
+    iPendingCall = new QDBusPendingCallWatcher(iBus.asyncCall(aCall), this);
+    iPendingRelease = aRelease;
+    connect(iPendingCall, SIGNAL(finished(QDBusPendingCallWatcher*)), aSlot);
+}
+
+void
+NdefApp::Private::callFinished()
+{
+    iPendingCall = Q_NULLPTR;
+    iPendingRelease = QDBusMessage();
+}
+
+void
+NdefApp::Private::onPublishFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<uint> reply(*aWatcher);
+
+    callFinished();
+    TRACE("publish.end ok=%d t=%.3f", reply.isValid(), iMetrics->elapsed());
+    if (reply.isValid()) {
+        iStaticTagId = reply.value();
+        DBG("Published static tag" << iStaticTagId);
+        iMetrics->stage(NdefMetrics::StageRegister);
+
+        // <signal name="Progress">
+        //   <arg name="id" type="u"/>
+        //   <arg name="bytes" type="u"/>
+        //   <arg name="total" type="u"/>
+        // </signal>
+        // <signal name="Done">
+        //   <arg name="id" type="u"/>
+        // </signal>
+        iBus.connect(NFC_SERVICE_NAME, STATIC_TAG_PATH, STATIC_TAG_INTERFACE,
+            "Progress", this, SLOT(onStaticTagProgress(uint,uint,uint)));
+        iBus.connect(NFC_SERVICE_NAME, STATIC_TAG_PATH, STATIC_TAG_INTERFACE,
+            "Done", this, SLOT(onStaticTagDone(uint)));
+        requestMode();
+    } else {
+        // No static tag plugin, serve APDUs ourselves
+        DBG(reply.error());
+        registerLocalHostApp();
+    }
+    aWatcher->deleteLater();
+}
+
+void
+NdefApp::Private::onStaticTagProgress(
+    uint aId,
+    uint aBytes,
+    uint aTotal)
+{
+    if (aId == iStaticTagId && iStaticTagBytes != aBytes) {
+        DBG(aBytes << "bytes out of" << aTotal);
+        if (aBytes > iStaticTagBytes) {
+            iMetrics->stage(NdefMetrics::StageLastRead);
+        } else {
+            iMetrics->reset();
+        }
+        iStaticTagBytes = aBytes;
+        iMetrics->bytesConfirmed(aBytes);
+        touch();
+        progressChanged();
+    }
+}
+
+void
+NdefApp::Private::onStaticTagDone(
+    uint aId)
+{
+    if (aId == iStaticTagId) {
+        iStaticTagBytes = iTag.size();
+        progressChanged(true);
+        setDone();
+    }
+}
+
+void
+NdefApp::Private::registerLocalHostApp()
+{
+    TRACE("register.begin t=%.3f", iMetrics->elapsed());
+#ifdef HAVE_GIO
+    if (iGioHost) {
+        // The app must be registered over the same connection
+        iGioHost->registerApp(NdefTag::aid(), 0x01);
+        return;
+    }
+#endif
+
+    // <method name="RegisterLocalHostApp">
+    //   <arg name="path" type="o" direction="in"/>
+    //   <arg name="name" type="s" direction="in"/>
+    //   <arg name="aid" type="ay" direction="in"/>
+    //   <arg name="flags" type="u" direction="in"/>
+    // </method>
+    //
+    // Flags:
+    //   0x01 - Allow implicit selection
+    QDBusMessage msg(createMethodCall("RegisterLocalHostApp"));
+    msg << QVariant::fromValue(QDBusObjectPath(APP_PATH)) // path
+        << QString("NfcShare")                            // name
+        << NdefTag::aid()                                 // aid
+        << uint(0x01);                                    // flags
+    QDBusMessage unregister(createMethodCall("UnregisterLocalHostApp"));
+    unregister << QVariant::fromValue(QDBusObjectPath(APP_PATH));
+    callAsync(msg, SLOT(onRegisterLocalHostAppFinished(QDBusPendingCallWatcher*)),
+        unregister);
+}
+
+void
+NdefApp::Private::onRegisterLocalHostAppFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<void> reply(*aWatcher);
+
+    callFinished();
+    TRACE("register.end ok=%d t=%.3f", reply.isValid(), iMetrics->elapsed());
+    if (reply.isValid()) {
+        iRegisteredApp = true;
+        appRegistered();
+    } else {
+        WARN(reply.error());
+    }
+    aWatcher->deleteLater();
+}
+
+void
+NdefApp::Private::appRegistered()
+{
+    if (iLegacyAid && (iGioLegacyHost || iRegisteredLegacyObject)) {
+        registerLegacyApp();
+    } else {
+        localHostAppRegistered();
+    }
+}
+
+void
+NdefApp::Private::setLegacyAidEnabled(
+    bool aEnabled)
+{
+    iTag.setLegacyAidEnabled(aEnabled);
+    if (iRecorder) {
+        iRecorder->legacyAid(aEnabled);
+    }
+}
+
+void
+NdefApp::Private::registerLegacyApp()
+{
+    // Some older readers only know the mapping version 1.0 AID. That
+    // app doesn't ask for implicit selection, the main one has it.
+    TRACE("register_legacy.begin t=%.3f", iMetrics->elapsed());
+#ifdef HAVE_GIO
+    if (iGioLegacyHost) {
+        iGioLegacyHost->registerApp(NdefTag::legacyAid(), 0);
+        return;
+    }
+#endif
+
+    QDBusMessage msg(createMethodCall("RegisterLocalHostApp"));
+    msg << QVariant::fromValue(QDBusObjectPath(LEGACY_APP_PATH)) // path
+        << QString("NfcShare")                                   // name
+        << NdefTag::legacyAid()                                  // aid
+        << uint(0);                                              // flags
+    QDBusMessage unregister(createMethodCall("UnregisterLocalHostApp"));
+    unregister << QVariant::fromValue(QDBusObjectPath(LEGACY_APP_PATH));
+    callAsync(msg, SLOT(onRegisterLegacyAppFinished(QDBusPendingCallWatcher*)),
+        unregister);
+}
+
+void
+NdefApp::Private::onRegisterLegacyAppFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<void> reply(*aWatcher);
+
+    callFinished();
+    TRACE("register_legacy.end ok=%d t=%.3f", reply.isValid(),
+        iMetrics->elapsed());
+    if (reply.isValid()) {
+        iRegisteredLegacyApp = true;
+        setLegacyAidEnabled(true);
+    } else {
+        // Not fatal, the v2 app is there
+        WARN(reply.error());
+    }
+    localHostAppRegistered();
+    aWatcher->deleteLater();
+}
+
+#ifdef HAVE_GIO
+void
+NdefApp::Private::gioAppRegistered(
+    GioHost* aHost,
+    bool aOk)
+{
+    if (aHost == iGioHost) {
+        TRACE("register.end ok=%d t=%.3f", aOk, iMetrics->elapsed());
+        if (aOk) {
+            appRegistered();
+        }
+    } else {
+        // Legacy app is optional, carry on either way
+        TRACE("register_legacy.end ok=%d t=%.3f", aOk, iMetrics->elapsed());
+        setLegacyAidEnabled(aOk);
+        localHostAppRegistered();
+    }
+}
+#endif
+
+void
+NdefApp::Private::onRequestModeFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<uint> reply(*aWatcher);
+
+    callFinished();
+    TRACE("mode.end ok=%d t=%.3f", reply.isValid(), iMetrics->elapsed());
+    if (reply.isValid()) {
+        iRegisteredModeId = reply.value();
+        DBG("Mode request" << iRegisteredModeId);
+        iMetrics->stage(NdefMetrics::StageMode);
+        requestTechs();
+    } else {
+        WARN(reply.error());
+        setLeaseState(LeaseNone);
+    }
+    aWatcher->deleteLater();
+}
+
+void
+NdefApp::Private::onRequestTechsFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<uint> reply(*aWatcher);
+
+    callFinished();
+    TRACE("techs.end ok=%d t=%.3f", reply.isValid(), iMetrics->elapsed());
+    if (reply.isValid()) {
+        iRegisteredTechsId = reply.value();
+        DBG("Tech request" << iRegisteredTechsId << hex << iTechs);
+        iMetrics->stage(NdefMetrics::StageTechs);
+        iMetrics->stage(NdefMetrics::StageReady);
+        iMetrics->leaseAcquired(iMetrics->elapsed() - iLeaseStartMs);
+        setLeaseState(LeaseHeld);
+        touch();
+        iReady = true;
+        Q_EMIT parentObject()->readyChanged();
+    } else {
+        WARN(reply.error());
+        setLeaseState(LeaseNone);
+    }
+    aWatcher->deleteLater();
+}
+
+void
+NdefApp::Private::requestTechs()
+{
+    // <method name="RequestTechs">
+    //   <arg name="allow" type="u" direction="in"/>
+    //   <arg name="disallow" type="u" direction="in"/>
+    //   <arg name="id" type="u" direction="out"/>
+    // </method>
+    //
+    // Tech bits:
+    //   0x01 - NFC-A
+    //   0x02 - NFC-B
+    //   0x04 - NFC-F
+    TRACE("techs.begin techs=%02x t=%.3f", iTechs, iMetrics->elapsed());
+    QDBusMessage msg(createMethodCall("RequestTechs"));
+    msg << uint(iTechs)     // allow
+        << uint(~iTechs);   // disallow everything else
+    callAsync(msg, SLOT(onRequestTechsFinished(QDBusPendingCallWatcher*)),
+        createMethodCall("ReleaseTechs"));
+}
+
+void
+NdefApp::Private::localHostAppRegistered()
+{
+    DBG("Registered NFS share service at" << APP_PATH);
+    iMetrics->stage(NdefMetrics::StageRegister);
+    requestMode();
+}
+
+void
+NdefApp::Private::requestMode()
+{
+    // <method name="RequestMode">
+    //   <arg name="enable" type="u" direction="in"/>
+    //   <arg name="disable" type="u" direction="in"/>
+    //   <arg name="id" type="u" direction="out"/>
+    // </method>
+    //
+    // Polling mode bits:
+    //   0x01 - P2P Initiator
+    //   0x02 - Reader/Writer
+    //
+    // Listening mode bits:
+    //   0x04 - P2P Target
+    //   0x08 - Card Emulation
+    uint enable;
+
+    switch (iTransport) {
+    case TransportSnep:
+        enable = 0x04;  // P2P Target
+        break;
+    case TransportAuto:
+        enable = 0x0c;  // P2P Target + Card Emulation
+        break;
+    case TransportType4:
+    default:
+        enable = 0x08;  // Card Emulation
+        break;
+    }
+
+    TRACE("mode.begin mode=%02x t=%.3f", enable, iMetrics->elapsed());
+    iLeaseStartMs = iMetrics->elapsed();
+    setLeaseState(LeaseAcquiring);
+    QDBusMessage msg(createMethodCall("RequestMode"));
+    msg << enable
+        << uint(0x02);  // disable Reader/Writer mode
+    callAsync(msg, SLOT(onRequestModeFinished(QDBusPendingCallWatcher*)),
+        createMethodCall("ReleaseMode"));
+}
+
+void
+NdefApp::Private::onSnepBytesSentChanged()
+{
+    touch();
+    progressChanged();
+}
+
+void
+NdefApp::Private::onSnepFailed()
+{
+    // A peer that comes back is handled by SnepPush itself, one that
+    // has stayed around needs a nudge. Give up on it after a few
+    // attempts, it probably doesn't want what we are pushing.
+    iMetrics->retry();
+    if (++iSnepFailures <= SNEP_MAX_RETRIES) {
+        DBG("SNEP push failed, retrying" << iSnepFailures << "of" <<
+            SNEP_MAX_RETRIES);
+        QTimer::singleShot(SNEP_RETRY_DELAY_MS, iSnep, SLOT(retry()));
+    } else {
+        WARN("SNEP push failed" << iSnepFailures << "times, waiting for"
+            " the next peer");
+    }
+}
+
+void
+NdefApp::Private::onSnepDone()
+{
+    DBG("SNEP push done");
+    iMetrics->bytesConfirmed(iTag.size());
+    progressChanged(true);
+    setDone();
+}
+
+NdefApp*
+NdefApp::Private::parentObject()
+{
+    return qobject_cast<NdefApp*>(parent());
+}
+
+//static
+QDBusConnection
+NdefApp::Private::nfcBus()
+{
+    // A stand-in nfcd may live on a private bus
+    const QByteArray address(qgetenv(NFCSHARE_DBUS_ADDRESS_ENV));
+
+    return address.isEmpty() ? QDBusConnection::systemBus() :
+        QDBusConnection::connectToBus(QString::fromLatin1(address),
+            QStringLiteral("nfcshare"));
+}
+
+//static
+uint
+NdefApp::Private::maxLe()
+{
+    // Caps the R-APDU size advertised in the CC (and honoured by
+    // READ BINARY) for links which can't carry 64K responses.
+    // Zero (the default) means no limit other than the CC format.
+    return qgetenv(NFCSHARE_MAX_LE_ENV).toUInt(Q_NULLPTR, 0);
+}
+
+//static
+QDBusMessage
+NdefApp::Private::createMethodCall(
+    QString aMethod)
+{
+    return QDBusMessage::createMethodCall(NFC_SERVICE_NAME,
+        NFC_SERVICE_PATH, NFC_SERVICE_INTERFACE, aMethod);
+}
+
+bool
+NdefApp::Private::isTooMuchData() const
+{
+    return iTag.isTooMuchData();
+}
+
+qreal
+NdefApp::Private::transferRate() const
+{
+    // Bytes per second, from the first confirmed chunk to the last one
+    return (iRateLastMs > iRateStartMs && iRateStartMs >= 0) ?
+        ((iRateLastBytes - iRateStartBytes) * 1000 /
+        (iRateLastMs - iRateStartMs)) : 0;
+}
+
+qreal
+NdefApp::Private::estimatedTimeRemaining() const
+{
+    // Seconds, negative if unknown
+    const qreal rate = transferRate();
+    const uint total = iTag.size();
+
+    return iDone ? 0 : (rate > 0 && iRateLastBytes <= total) ?
+        ((total - iRateLastBytes) / rate) : -1;
+}
+
+void
+NdefApp::Private::progressChanged(
+    bool aFinal)
+{
+    const uint bytes = bytesTransferred();
+
+    if (bytes < iRateLastBytes || !bytes) {
+        // Started over
+        iRateStartMs = iRateLastMs = -1;
+        iRateStartBytes = iRateLastBytes = 0;
+    }
+    if (bytes) {
+        iRateLastMs = iMetrics->elapsed();
+        iRateLastBytes = bytes;
+        if (iRateStartMs < 0) {
+            iRateStartMs = iRateLastMs;
+            iRateStartBytes = bytes;
+        }
+    }
+
+    if (aFinal) {
+        iProgressTimer->stop();
+        Q_EMIT parentObject()->bytesTransferredChanged();
+    } else if (!iProgressTimer->isActive()) {
+        iProgressTimer->start();
+    }
+}
+
+void
+NdefApp::Private::onProgressTimer()
+{
+    Q_EMIT parentObject()->bytesTransferredChanged();
+}
+
+uint
+NdefApp::Private::bytesTransferred() const
+{
+    uint bytes = iStaticTagId ? iStaticTagBytes : iTag.bytesRead();
+
+    if (iSnep) {
+        if (iSnep->isDone()) {
+            return iTag.size();
+        } else {
+            // Plus 2 bytes of the NDEF file header
+            const uint sent = iSnep->bytesSent();
+
+            bytes = qMax(bytes, sent ? (sent + 2) : 0);
+        }
+    }
+    return bytes;
+}
+
+//static
+QVariantList
+NdefApp::Private::replyArgs(
+    const NdefTag::Response& aResponse)
+{
+    QVariantList list;
+    list << aResponse.data()                            // response
+         << qVariantFromValue<uchar>(aResponse.sw1())   // SW1
+         << qVariantFromValue<uchar>(aResponse.sw2())   // SW2
+         << aResponse.id();                             // response_id
+    return list;
+}
+
+void
+NdefApp::Private::handleTagEvents(
+    int aEvents)
+{
+    if (aEvents & NdefTag::EventProgress) {
+        iMetrics->stage(NdefMetrics::StageLastRead);
+        iMetrics->bytesConfirmed(iTag.bytesRead());
+    }
+    if (aEvents & NdefTag::EventReset) {
+        iMetrics->reset();
+    }
+    if (aEvents & (NdefTag::EventProgress | NdefTag::EventReset)) {
+        // The last chunk and the reset are reported right away
+        progressChanged(iTag.bytesRead() == iTag.size() ||
+            (aEvents & NdefTag::EventReset));
+    }
+    if (aEvents & NdefTag::EventReceived) {
+        const QByteArray ndef(iTag.received());
+
+        TRACE("tag.received bytes=%d t=%.3f", ndef.size(),
+            iMetrics->elapsed());
+        Q_EMIT parentObject()->received(ndef);
+    }
+    if (aEvents & NdefTag::EventDone) {
+        if (iGenerator) {
+            // Stay around for the next reader
+            iMetrics->stage(NdefMetrics::StageDone);
+            iDelivered = true;
+            Q_EMIT parentObject()->delivered();
+        } else {
+            setDone();
+        }
+    }
+}
+
+void
+NdefApp::Private::onPoolTimer()
+{
+    // Generating may take a while, don't do it while a reader waits
+    if (!iActive && iPool.size() < iPoolSize) {
+        const QByteArray ndef(iGenerator->generate());
+
+        if (!ndef.isEmpty() && (uint)ndef.size() <= NdefTag::maxMessageSize()) {
+            iPool.enqueue(ndef);
+        } else {
+            WARN("Generated message ignored," << ndef.size() << "bytes");
+        }
+        fillPool();
+    }
+}
+
+void
+NdefApp::Private::fillPool()
+{
+    if (iPoolTimer && !iActive && iPool.size() < iPoolSize) {
+        iPoolTimer->start();
+    }
+}
+
+void
+NdefApp::Private::nextMessage()
+{
+    QByteArray ndef;
+
+    if (!iPool.isEmpty()) {
+        ndef = iPool.dequeue();
+    } else {
+        // Has to be generated right here, which is what the pool
+        // is supposed to prevent
+        ndef = iGenerator->generate();
+        iMetrics->poolMiss();
+        if (ndef.isEmpty() || (uint)ndef.size() > NdefTag::maxMessageSize()) {
+            WARN("Reusing the last message");
+            return;
+        }
+    }
+
+    TRACE("generator.next bytes=%d pool=%d t=%.3f", ndef.size(),
+        iPool.size(), iMetrics->elapsed());
+    iTag.replace(ndef.constData(), ndef.size());
+    if (iRecorder) {
+        iRecorder->replace(ndef);
+    }
+    iDelivered = false;
+    iNdefSize = ndef.size();
+    iRecordType = ShareHistory::Record::recordType(ndef);
+    iMetrics->bytesConfirmed(0);
+    progressChanged(true);
+}
+
+void
+NdefApp::Private::appendHistory(
+    const QString& aFileName)
+{
+    ShareHistory::Record rec;
+    const qreal first = iMetrics->firstSelectTime();
+    const qreal done = iMetrics->doneTime();
+
+    rec.iTimestamp = QDateTime::currentMSecsSinceEpoch() / 1000;
+    rec.iBytes = iNdefSize;
+    rec.iType = iRecordType;
+    rec.iTransport = iStaticTagId ? "static" :
+        (iTransport == TransportSnep) ? "snep" :
+        (iTransport == TransportAuto) ? "auto" : "tag";
+    rec.iReader = iHost;
+    rec.iTech = NdefMetrics::techName(iSessionTech).toLatin1();
+    rec.iReadyMs = iMetrics->readyTime();
+    rec.iFirstApduMs = first;
+    rec.iTransferMs = (first >= 0 && done >= first) ? (done - first) : -1;
+    rec.iRetries = iMetrics->retryCount();
+    rec.iResets = iMetrics->resetCount();
+    rec.iOutcome = iDone ? "done" : isTooMuchData() ? "too_large" :
+        iReady ? "incomplete" : "not_ready";
+    ShareHistory::append(aFileName, rec);
+}
+
+void
+NdefApp::Private::releaseLease()
+{
+    // Both calls are sent without waiting for the replies
+    if (iRegisteredTechsId) {
+        // <method name="ReleaseTechs">
+        //   <arg name="id" type="u" direction="in"/>
+        // </method>
+        QDBusMessage msg(createMethodCall("ReleaseTechs"));
+        msg << iRegisteredTechsId;
+        iBus.asyncCall(msg);
+        iRegisteredTechsId = 0;
+    }
+    if (iRegisteredModeId) {
+        // <method name="ReleaseMode">
+        //   <arg name="id" type="u" direction="in"/>
+        // </method>
+        QDBusMessage msg(createMethodCall("ReleaseMode"));
+        msg << iRegisteredModeId;
+        iBus.asyncCall(msg);
+        iRegisteredModeId = 0;
+    }
+}
+
+bool
+NdefApp::Private::dropLease()
+{
+    // Mode or techs request which is still in flight gets released
+    // as soon as it completes
+    bool released = false;
+
+    if (iPendingCall && iPendingRelease.member().startsWith("Release")) {
+        new Orphan(iBus, iPendingCall, iPendingRelease);
+        callFinished();
+        released = true;
+    }
+    if (iRegisteredModeId || iRegisteredTechsId) {
+        DBG("Releasing mode and techs");
+        releaseLease();
+        released = true;
+    }
+    if (released) {
+        iIdleTimer->stop();
+        setLeaseState(LeaseReleased);
+        if (iReady) {
+            iReady = false;
+            Q_EMIT parentObject()->readyChanged();
+        }
+    }
+    return released;
+}
+
+void
+NdefApp::Private::setLeaseState(
+    LeaseState aState)
+{
+    if (iLeaseState != aState) {
+        iLeaseState = aState;
+        Q_EMIT parentObject()->leaseStateChanged();
+    }
+}
+
+void
+NdefApp::Private::setIdleTimeout(
+    int aMsec)
+{
+    if (aMsec > 0) {
+        iIdleTimeout = aMsec;
+        if (iLeaseState == LeaseHeld) {
+            iLastActivityMs = iMetrics->elapsed();
+            iIdleTimer->start(iIdleTimeout);
+        }
+    } else {
+        iIdleTimeout = 0;
+        iIdleTimer->stop();
+    }
+}
+
+void
+NdefApp::Private::setTechs(
+    int aTechs)
+{
+    const int techs = aTechs & TechAB;
+
+    if (techs && iTechs != techs) {
+        iTechs = techs;
+        if (iLeaseState == LeaseHeld && !iPendingCall) {
+            // Swap the tech request, leaving the mode alone
+            QDBusMessage msg(createMethodCall("ReleaseTechs"));
+            msg << iRegisteredTechsId;
+            iBus.asyncCall(msg);
+            iRegisteredTechsId = 0;
+            iLeaseStartMs = iMetrics->elapsed();
+            setLeaseState(LeaseAcquiring);
+            requestTechs();
+        }
+        // Otherwise the next RequestTechs picks it up
+    }
+}
+
+void
+NdefApp::Private::touch()
+{
+    // Something is going on. This gets called for every APDU, just
+    // take note of the time, onIdleTimeout() waits for the rest.
+    iLastActivityMs = iMetrics->elapsed();
+    if (iIdleTimeout > 0 && iLeaseState == LeaseHeld &&
+        !iIdleTimer->isActive()) {
+        iIdleTimer->start(iIdleTimeout);
+    }
+}
+
+void
+NdefApp::Private::onIdleTimeout()
+{
+    const qreal remainingMs = iLastActivityMs + iIdleTimeout -
+        iMetrics->elapsed();
+
+    if (iActive) {
+        // Reader is still there, just not talking
+        iIdleTimer->start(iIdleTimeout);
+    } else if (remainingMs >= 1) {
+        // Something has happened since the timer was started
+        iIdleTimer->start(qCeil(remainingMs));
+    } else {
+        DBG("Idle for" << iIdleTimeout << "ms");
+        dropLease();
+    }
+}
+
+void
+NdefApp::Private::reacquire()
+{
+    // Only makes sense after the mode and techs have been released,
+    // the tag itself (or the SNEP push) is still in place
+    if (iLeaseState == LeaseReleased && !iPendingCall) {
+        DBG("Reacquiring mode and techs");
+        requestMode();
+    }
+}
+
+void
+NdefApp::Private::setDone()
+{
+    NdefApp* app = parentObject();
+
+    // Let the device go back to the normal polling right away
+    dropLease();
+
+    iMetrics->stage(NdefMetrics::StageDone);
+    if (!iDone) {
+        iDone = true;
+        Q_EMIT app->doneChanged();
+    }
+    Q_EMIT app->done();
+}
+
+// org.sailfishos.nfc.LocalHostApp implementation
+
+int
+NdefApp::Private::GetInterfaceVersion()
+{
+    return INTERFACE_VERSION;
+}
+
+bool
+NdefApp::Private::isDuplicateStart(
+    const QString& aHost)
+{
+    // With the legacy AID registered, nfcd starts both apps (which
+    // are the same object) for each host
+    if (iFresh && iActive && iHost == aHost) {
+        DBG("Ignoring duplicate start for" << aHost);
+        return true;
+    }
+    iFresh = true;
+    return false;
+}
+
+void
+NdefApp::Private::startSession(
+    const QString& aHost)
+{
+    iHost = aHost;
+    iSessionStartMs = iMetrics->elapsed();
+    iSessionTech = 0;
+    iActivationMs = -1;
+    iActivationReported = false;
+
+    // <method name="GetTechnology">
+    //   <arg name="technology" type="u" direction="out"/>
+    // </method>
+    delete iTechCall;
+    iTechCall = new QDBusPendingCallWatcher(iBus.asyncCall(
+        QDBusMessage::createMethodCall(NFC_SERVICE_NAME, aHost,
+        HOST_INTERFACE, "GetTechnology")), this);
+    connect(iTechCall, SIGNAL(finished(QDBusPendingCallWatcher*)),
+        SLOT(onHostTechnologyFinished(QDBusPendingCallWatcher*)));
+}
+
+void
+NdefApp::Private::onHostTechnologyFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<uint> reply(*aWatcher);
+
+    if (reply.isValid()) {
+        iSessionTech = reply.value();
+        DBG("Host" << iHost << "tech" << hex << iSessionTech);
+        TRACE("host.tech tech=%02x t=%.3f", iSessionTech,
+            iMetrics->elapsed());
+        iMetrics->session(iSessionTech);
+        sessionActivated();
+    } else {
+        DBG(reply.error());
+    }
+    iTechCall = Q_NULLPTR;
+    aWatcher->deleteLater();
+}
+
+void
+NdefApp::Private::sessionActivated()
+{
+    // Both the tech and the first SELECT may come first
+    if (iSessionTech && iActivationMs >= 0 && !iActivationReported) {
+        iActivationReported = true;
+        iMetrics->activated(iSessionTech, iActivationMs);
+    }
+}
+
+void
+NdefApp::Private::Start(
+    QDBusObjectPath aHost)
+{
+    if (isDuplicateStart(aHost.path())) {
+        return;
+    }
+    DBG("Host" << aHost.path() << "has started");
+    startSession(aHost.path());
+
+    // A delivered message isn't retried, the next one is served
+    const bool delivered = iDelivered;
+    if (iGenerator && iPoolTimer) {
+        // Each reader gets its own message
+        if (iMessageUsed) {
+            nextMessage();
+        }
+        iMessageUsed = true;
+        iPoolTimer->stop();
+    }
+    iActive = true;
+    touch();
+    if (iRecorder) {
+        iRecorder->start(aHost.path());
+    }
+    if (iSessions++ && !iDone && !delivered) {
+        iMetrics->retry();
+    }
+    handleTagEvents(iTag.start());
+}
+
+void
+NdefApp::Private::Restart(
+    QDBusObjectPath aHost)
+{
+    if (isDuplicateStart(aHost.path())) {
+        return;
+    }
+    DBG("Host" << aHost.path() << "has been restarted");
+    startSession(aHost.path());
+    iActive = true;
+    touch();
+    if (iRecorder) {
+        iRecorder->restart(aHost.path());
+    }
+    if (iSessions++ && !iDone) {
+        iMetrics->retry();
+    }
+    handleTagEvents(iTag.stop());
+}
+
+void
+NdefApp::Private::Stop(
+    QDBusObjectPath aHost)
+{
+    if (!iActive) {
+        // Duplicate (see isDuplicateStart)
+        return;
+    }
+    DBG("Host" << aHost.path() << "left");
+    iActive = false;
+    iFresh = false;
+    fillPool();
+    touch();
+    if (iRecorder) {
+        iRecorder->stop(aHost.path());
+    }
+    handleTagEvents(iTag.stop());
+}
+
+void
+NdefApp::Private::ImplicitSelect(
+    QDBusObjectPath aHost)
+{
+    DBG("Implicitly selected for" << aHost.path());
+}
+
+void
+NdefApp::Private::Select(
+    QDBusObjectPath aHost)
+{
+    DBG("Selected for" << aHost.path());
+}
+
+void
+NdefApp::Private::Deselect(
+    QDBusObjectPath aHost)
+{
+    DBG("Deselected for" << aHost.path());
+}
+
+void
+NdefApp::Private::Process(
+    QDBusObjectPath aHost,
+    uchar aCla,
+    uchar aIns,
+    uchar aP1,
+    uchar aP2,
+    QByteArray aData,
+    uint aLe,
+    QDBusMessage aMessage)
+{
+    const NdefTag::Response response(process(aHost.path(), aCla, aIns, aP1,
+        aP2, aData, aLe));
+
+    aMessage.setDelayedReply(true);
+    iBus.send(aMessage.createReply(replyArgs(response)));
+}
+
+NdefTag::Response
+NdefApp::Private::process(
+    const QString& aHost,
+    uchar aCla,
+    uchar aIns,
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData,
+    uint aLe)
+{
+    QElapsedTimer timer;
+
+    timer.start();
+    iFresh = false;
+    touch();
+    DUMP("C-APDU from" << aHost << hex << aCla << aIns << aP1 << aP2 <<
+        aData.toHex().constData() << aLe);
+
+    const NdefTag::Response response(iTag.process(aCla, aIns, aP1, aP2,
+        aData, aLe));
+    const qint64 ns = timer.nsecsElapsed();
+
+    if (!response.isOk()) {
+        iMetrics->rejected(aIns, aP1, aP2);
+    } else if (aIns == ISO_INS_SELECT) {
+        iMetrics->stage(NdefMetrics::StageFirstSelect);
+        if (iActivationMs < 0 && iSessionStartMs >= 0) {
+            iActivationMs = iMetrics->elapsed() - iSessionStartMs;
+            sessionActivated();
+        }
+    }
+    iMetrics->apdu(ns);
+    TRACE("process ins=%02x p1=%02x p2=%02x lc=%d le=%u sw=%02x%02x id=%u "
+        "us=%lld", aIns, aP1, aP2, aData.size(), aLe, response.sw1(),
+        response.sw2(), response.id(), ns / 1000);
+    if (iRecorder) {
+        iRecorder->command(aHost, aCla, aIns, aP1, aP2, aData, aLe,
+            response.data(), response.sw1(), response.sw2(), response.id());
+    }
+    return response;
+}
+
+void
+NdefApp::Private::ResponseStatus(
+    uint aResponseId,
+    bool aOk)
+{
+    TRACE("response_status id=%u ok=%d t=%.3f", aResponseId, aOk,
+        iMetrics->elapsed());
+    DBG("Response" << aResponseId << (aOk ? "ok" : "failed"));
+    if (iRecorder) {
+        iRecorder->status(aResponseId, aOk);
+    }
+    if (!aOk) {
+        iMetrics->failure();
+    }
+    handleTagEvents(iTag.responseStatus(aResponseId, aOk));
+}
+
+// ==========================================================================
+// NdefApp
+// ==========================================================================
+
+NdefApp::NdefApp(
+    const void* aNdefData,
+    uint aNdefSize,
+    Transport aTransport,
+    QObject* aParent,
+    uint aReceiveSize) :
+    QObject(aParent),
+    iPrivate(new Private(aNdefData, aNdefSize, aTransport, this, Q_NULLPTR, 0,
+        aReceiveSize))
+{}
+
+NdefApp::NdefApp(
+    NdefGenerator* aGenerator,
+    uint aPoolSize,
+    Transport aTransport,
+    QObject* aParent,
+    uint aReceiveSize) :
+    QObject(aParent),
+    iPrivate(Q_NULLPTR)
+{
+    // The generator must outlive NdefApp. The first message is
+    // generated right away, the rest come from the pool.
+    const QByteArray ndef(aGenerator->generate());
+
+    iPrivate = new Private(ndef.constData(), ndef.size(), aTransport, this,
+        aGenerator, aPoolSize, aReceiveSize);
+}
+
+//static
+uint
+NdefApp::maxMessageSize()
+{
+    return NdefTag::maxMessageSize();
+}
+
+//static
+uint
+NdefApp::maxReceiveSize()
+{
+    return NdefTag::maxReceiveSize();
+}
+
+bool
+NdefApp::isTooMuchData() const
+{
+    return iPrivate->isTooMuchData();
+}
+
+bool
+NdefApp::isReady() const
+{
+    return iPrivate->iReady;
+}
+
+bool
+NdefApp::isDone() const
+{
+    return iPrivate->iDone;
+}
+
+uint
+NdefApp::getBytesTotal() const
+{
+    return iPrivate->iTag.size();
+}
+
+uint
+NdefApp::getBytesTransferred() const
+{
+    return iPrivate->bytesTransferred();
+}
+
+qreal
+NdefApp::getTransferRate() const
+{
+    return iPrivate->transferRate();
+}
+
+qreal
+NdefApp::getEstimatedTimeRemaining() const
+{
+    return iPrivate->estimatedTimeRemaining();
+}
+
+void
+NdefApp::reacquire()
+{
+    iPrivate->reacquire();
+}
+
+NdefApp::LeaseState
+NdefApp::getLeaseState() const
+{
+    return iPrivate->iLeaseState;
+}
+
+int
+NdefApp::getIdleTimeout() const
+{
+    return iPrivate->iIdleTimeout;
+}
+
+void
+NdefApp::setIdleTimeout(
+    int aMsec)
+{
+    iPrivate->setIdleTimeout(aMsec);
+}
+
+int
+NdefApp::getTechs() const
+{
+    return iPrivate->iTechs;
+}
+
+void
+NdefApp::setTechs(
+    int aTechs)
+{
+    iPrivate->setTechs(aTechs);
+}
+
+//static
+int
+NdefApp::defaultTechs()
+{
+    // NFCSHARE_TECHS=a, b or ab, NFC-A only by default
+    const QByteArray env(qgetenv(NFCSHARE_TECHS_ENV).toLower());
+    const int techs = (env.contains('a') ? TechA : 0) |
+        (env.contains('b') ? TechB : 0);
+
+    return techs ? techs : TechA;
+}
+
+NdefMetrics*
+NdefApp::getMetrics() const
+{
+    return iPrivate->iMetrics;
+}
+
+#include "ndefapp.moc"
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "ndefcache.h"
+#include "nfcsharelog.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QList>
+#include <QtCore/QSaveFile>
+#include <QtCore/QtEndian>
+
+#include <string.h>
+
+#define DBG(x) qCDebug(nfcshareShare) << x
+
+#define NFCSHARE_CACHE_DIR_ENV "NFCSHARE_CACHE_DIR"
+
+// Cache file format:
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 4    | Magic (NDFC)                                           |
+// | 4      | 4    | K = key size (big-endian)                              |
+// | 8      | K    | Key                                                    |
+// | 8 + K  | -    | NDEF message                                           |
+// +------------------------------------------------------------------------+
+
+#define CACHE_FILE_MAGIC (0x4e444643)
+#define CACHE_FILE_HEADER_SIZE (8)
+#define CACHE_FILE_SUFFIX ".ndef"
+
+// ==========================================================================
+// NdefCache::Private
+// ==========================================================================
+
+class NdefCache::Private
+{
+public:
+    class Entry {
+    public:
+        Entry(quint64, const QByteArray&, const QByteArray&);
+
+        quint64 iHash;
+        QByteArray iKey;
+        QByteArray iNdef;
+    };
+
+    Private();
+
+    static quint64 hash(const QByteArray&);
+    QString fileName(quint64) const;
+    QByteArray load(quint64, const QByteArray&) const;
+    void save(quint64, const QByteArray&, const QByteArray&) const;
+    void remember(quint64, const QByteArray&, const QByteArray&);
+
+public:
+    const QString iDir;
+    QList<Entry> iEntries;  // Most recently used first
+};
+
+NdefCache::Private::Entry::Entry(
+    quint64 aHash,
+    const QByteArray& aKey,
+    const QByteArray& aNdef) :
+    iHash(aHash),
+    iKey(aKey),
+    iNdef(aNdef)
+{}
+
+NdefCache::Private::Private() :
+    iDir(QString::fromLocal8Bit(qgetenv(NFCSHARE_CACHE_DIR_ENV)))
+{
+    if (!iDir.isEmpty() && QDir().mkpath(iDir)) {
+        // Owner only, the cached messages may be private
+        QFile::setPermissions(iDir, QFileDevice::ReadOwner |
+            QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+    }
+}
+
+//static
+quint64
+NdefCache::Private::hash(
+    const QByteArray& aKey)
+{
+    // 64-bit FNV-1a
+    const uchar* ptr = (const uchar*)aKey.constData();
+    const uchar* end = ptr + aKey.size();
+    quint64 h = Q_UINT64_C(0xcbf29ce484222325);
+
+    while (ptr < end) {
+        h ^= *ptr++;
+        h *= Q_UINT64_C(0x100000001b3);
+    }
+    return h;
+}
+
+QString
+NdefCache::Private::fileName(
+    quint64 aHash) const
+{
+    return iDir + QLatin1Char('/') + QString::number(aHash, 16) +
+        QLatin1String(CACHE_FILE_SUFFIX);
+}
+
+QByteArray
+NdefCache::Private::load(
+    quint64 aHash,
+    const QByteArray& aKey) const
+{
+    // Not mapped: the message has to end up in a QByteArray of its own
+    // anyway (a raw mapping can't follow it around), and small reads
+    // land it there with a single copy
+    QFile file(fileName(aHash));
+    const qint64 minSize = CACHE_FILE_HEADER_SIZE + aKey.size();
+
+    if (file.open(QIODevice::ReadOnly) && file.size() > minSize &&
+        file.size() - minSize <= MAX_MESSAGE_SIZE) {
+        const qint64 size = file.size() - minSize;
+        const QByteArray head(file.read(minSize));
+        const uchar* ptr = (const uchar*)head.constData();
+
+        // Different keys may have the same hash
+        if (head.size() == minSize &&
+            qFromBigEndian<quint32>(ptr) == CACHE_FILE_MAGIC &&
+            qFromBigEndian<quint32>(ptr + 4) == (quint32)aKey.size() &&
+            !memcmp(ptr + CACHE_FILE_HEADER_SIZE, aKey.constData(),
+            aKey.size())) {
+            const QByteArray ndef(file.read(size));
+
+            if (ndef.size() == size) {
+                return ndef;
+            }
+        }
+    }
+    return QByteArray();
+}
+
+void
+NdefCache::Private::save(
+    quint64 aHash,
+    const QByteArray& aKey,
+    const QByteArray& aNdef) const
+{
+    QSaveFile file(fileName(aHash));
+
+    if (file.open(QIODevice::WriteOnly)) {
+        uchar header[CACHE_FILE_HEADER_SIZE];
+
+        // Same as the directory
+        file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+        qToBigEndian<quint32>(CACHE_FILE_MAGIC, header);
+        qToBigEndian<quint32>(aKey.size(), header + 4);
+        file.write((const char*)header, sizeof(header));
+        file.write(aKey);
+        file.write(aNdef);
+        if (file.commit()) {
+            // Drop the least recently written files
+            const QFileInfoList files(QDir(iDir).entryInfoList(QStringList(
+                QLatin1String("*" CACHE_FILE_SUFFIX)), QDir::Files,
+                QDir::Time));
+
+            for (int i = MAX_FILES; i < files.size(); i++) {
+                QFile::remove(files.at(i).filePath());
+            }
+        }
+    }
+}
+
+void
+NdefCache::Private::remember(
+    quint64 aHash,
+    const QByteArray& aKey,
+    const QByteArray& aNdef)
+{
+    iEntries.prepend(Entry(aHash, aKey, aNdef));
+    while (iEntries.size() > MAX_ENTRIES) {
+        iEntries.removeLast();
+    }
+}
+
+// ==========================================================================
+// NdefCache
+// ==========================================================================
+
+//static
+NdefCache::Private*
+NdefCache::instance()
+{
+    static Private cache;
+    return &cache;
+}
+
+//static
+QByteArray
+NdefCache::lookup(
+    const QByteArray& aKey)
+{
+    Private* cache = instance();
+    const quint64 hash = Private::hash(aKey);
+
+    for (int i = 0; i < cache->iEntries.size(); i++) {
+        const Private::Entry& entry = cache->iEntries.at(i);
+
+        if (entry.iHash == hash && entry.iKey == aKey) {
+            const QByteArray ndef(entry.iNdef);
+
+            cache->iEntries.move(i, 0);
+            DBG("Cache hit," << ndef.size() << "bytes");
+            return ndef;
+        }
+    }
+
+    if (!cache->iDir.isEmpty()) {
+        const QByteArray ndef(cache->load(hash, aKey));
+
+        if (!ndef.isEmpty()) {
+            DBG("Cache file hit," << ndef.size() << "bytes");
+            cache->remember(hash, aKey, ndef);
+            return ndef;
+        }
+    }
+    return QByteArray();
+}
+
+//static
+void
+NdefCache::insert(
+    const QByteArray& aKey,
+    const QByteArray& aNdef)
+{
+    // Large messages are rare and would blow the memory budget
+    if (!aNdef.isEmpty() && aNdef.size() <= MAX_MESSAGE_SIZE) {
+        Private* cache = instance();
+        const quint64 hash = Private::hash(aKey);
+
+        cache->remember(hash, aKey, aNdef);
+        if (!cache->iDir.isEmpty()) {
+            cache->save(hash, aKey, aNdef);
+        }
+    }
+}
@@ -0,0 +1,465 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "ndefmetrics.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+
+#define NS_PER_MS (1000000)
+#define NS_PER_US (1000)
+
+// Upper bounds (exclusive) of the APDU latency histogram buckets,
+// in microseconds. The last bucket has no upper bound.
+const qint64 NdefMetrics::LATENCY_LIMIT_US[] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000
+};
+
+static const char* const STAGE_NAMES[] = {
+    "register", "mode", "techs", "ready", "first_select", "last_read", "done"
+};
+Q_STATIC_ASSERT(sizeof(STAGE_NAMES)/sizeof(STAGE_NAMES[0]) ==
+    NdefMetrics::StageCount);
+
+// nfcd technology bits 0x01, 0x02 and 0x04
+static const char* const TECH_NAMES[] = { "a", "b", "f" };
+
+NdefMetrics::NdefMetrics(
+    QObject* aParent) :
+    QObject(aParent),
+    iApduCount(0),
+    iBytes(0),
+    iRetries(0),
+    iFailures(0),
+    iResets(0),
+    iLeases(0),
+    iLastLeaseMs(-1),
+    iMaxLeaseMs(-1),
+    iRejects(0),
+    iPoolMisses(0)
+{
+    iTimer.start();
+    for (int i = 0; i < StageCount; i++) {
+        iStage[i] = -1;
+    }
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        iLatency[i] = 0;
+    }
+    for (int i = 0; i < TECHS; i++) {
+        iTechSessions[i] = 0;
+        iTechActivations[i] = 0;
+        iTechActivationMs[i] = 0;
+    }
+}
+
+//static
+int
+NdefMetrics::techIndex(
+    uint aTech)
+{
+    for (int i = 0; i < TECHS; i++) {
+        if (aTech == (1u << i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//static
+QString
+NdefMetrics::techName(
+    uint aTech)
+{
+    const int i = techIndex(aTech);
+
+    return (i >= 0) ? QString::fromLatin1(TECH_NAMES[i]) : QString();
+}
+
+void
+NdefMetrics::stage(
+    Stage aStage)
+{
+    // Only the last read moves forward, the rest is recorded once
+    if (aStage >= 0 && aStage < StageCount &&
+        (iStage[aStage] < 0 || aStage == StageLastRead)) {
+        iStage[aStage] = iTimer.nsecsElapsed();
+        Q_EMIT changed();
+    }
+}
+
+void
+NdefMetrics::apdu(
+    qint64 aNsecs)
+{
+    const qint64 us = aNsecs / NS_PER_US;
+    int i = 0;
+
+    while (i < LATENCY_BUCKETS - 1 && us >= LATENCY_LIMIT_US[i]) {
+        i++;
+    }
+    iLatency[i]++;
+    iApduCount++;
+    Q_EMIT changed();
+}
+
+void
+NdefMetrics::bytesConfirmed(
+    uint aBytes)
+{
+    if (iBytes != aBytes) {
+        iBytes = aBytes;
+        Q_EMIT changed();
+    }
+}
+
+void
+NdefMetrics::retry()
+{
+    iRetries++;
+    Q_EMIT changed();
+}
+
+void
+NdefMetrics::failure()
+{
+    iFailures++;
+    Q_EMIT changed();
+}
+
+void
+NdefMetrics::reset()
+{
+    iResets++;
+    Q_EMIT changed();
+}
+
+void
+NdefMetrics::leaseAcquired(
+    qreal aMs)
+{
+    // How long it took to switch to card emulation (and back)
+    iLeases++;
+    iLastLeaseMs = aMs;
+    iMaxLeaseMs = qMax(iMaxLeaseMs, aMs);
+    Q_EMIT changed();
+}
+
+void
+NdefMetrics::rejected(
+    uchar aIns,
+    uchar aP1,
+    uchar aP2)
+{
+    // Tells which command variants the readers are retrying with
+    iRejected[((uint)aIns << 16) | ((uint)aP1 << 8) | aP2]++;
+    iRejects++;
+    Q_EMIT changed();
+}
+
+void
+NdefMetrics::session(
+    uint aTech)
+{
+    // Which technology the reader came over
+    const int i = techIndex(aTech);
+
+    if (i >= 0) {
+        iTechSessions[i]++;
+        Q_EMIT changed();
+    }
+}
+
+void
+NdefMetrics::activated(
+    uint aTech,
+    qreal aMs)
+{
+    // From the host start to the first successful SELECT
+    const int i = techIndex(aTech);
+
+    if (i >= 0) {
+        iTechActivations[i]++;
+        iTechActivationMs[i] += aMs;
+        Q_EMIT changed();
+    }
+}
+
+void
+NdefMetrics::poolMiss()
+{
+    // Generated message had to be produced on the APDU path
+    iPoolMisses++;
+    Q_EMIT changed();
+}
+
+qreal
+NdefMetrics::elapsed() const
+{
+    // Milliseconds since creation
+    return qreal(iTimer.nsecsElapsed()) / NS_PER_MS;
+}
+
+qreal
+NdefMetrics::stageTime(
+    Stage aStage) const
+{
+    return (aStage >= 0 && aStage < StageCount && iStage[aStage] >= 0) ?
+        (qreal(iStage[aStage]) / NS_PER_MS) : -1;
+}
+
+qreal
+NdefMetrics::registerTime() const
+{
+    return stageTime(StageRegister);
+}
+
+qreal
+NdefMetrics::modeTime() const
+{
+    return stageTime(StageMode);
+}
+
+qreal
+NdefMetrics::techsTime() const
+{
+    return stageTime(StageTechs);
+}
+
+qreal
+NdefMetrics::readyTime() const
+{
+    return stageTime(StageReady);
+}
+
+qreal
+NdefMetrics::firstSelectTime() const
+{
+    return stageTime(StageFirstSelect);
+}
+
+qreal
+NdefMetrics::lastReadTime() const
+{
+    return stageTime(StageLastRead);
+}
+
+qreal
+NdefMetrics::doneTime() const
+{
+    return stageTime(StageDone);
+}
+
+uint
+NdefMetrics::apduCount() const
+{
+    return iApduCount;
+}
+
+QVariantList
+NdefMetrics::latencyBuckets() const
+{
+    QVariantList list;
+
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        list.append(LATENCY_LIMIT_US[i]);
+    }
+    return list;
+}
+
+QVariantList
+NdefMetrics::latencyHistogram() const
+{
+    QVariantList list;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        list.append(iLatency[i]);
+    }
+    return list;
+}
+
+qreal
+NdefMetrics::bytesPerSecond() const
+{
+    // From the first SELECT to the last confirmed READ BINARY
+    const qint64 start = iStage[StageFirstSelect];
+    const qint64 end = iStage[StageLastRead];
+
+    return (start >= 0 && end > start) ?
+        (qreal(iBytes) * 1000000000 / (end - start)) : 0;
+}
+
+uint
+NdefMetrics::retryCount() const
+{
+    return iRetries;
+}
+
+uint
+NdefMetrics::failureCount() const
+{
+    return iFailures;
+}
+
+uint
+NdefMetrics::resetCount() const
+{
+    return iResets;
+}
+
+uint
+NdefMetrics::leaseCount() const
+{
+    return iLeases;
+}
+
+qreal
+NdefMetrics::lastLeaseTime() const
+{
+    return iLastLeaseMs;
+}
+
+qreal
+NdefMetrics::maxLeaseTime() const
+{
+    return iMaxLeaseMs;
+}
+
+uint
+NdefMetrics::rejectCount() const
+{
+    return iRejects;
+}
+
+QVariantMap
+NdefMetrics::rejectedCommands() const
+{
+    // Keyed by INS, P1 and P2 in hex, e.g. "a40400"
+    QVariantMap map;
+    QMapIterator<uint,uint> it(iRejected);
+
+    while (it.hasNext()) {
+        it.next();
+        map.insert(QString("%1").arg(it.key(), 6, 16, QLatin1Char('0')),
+            it.value());
+    }
+    return map;
+}
+
+QVariantMap
+NdefMetrics::techSessions() const
+{
+    QVariantMap map;
+
+    for (int i = 0; i < TECHS; i++) {
+        if (iTechSessions[i]) {
+            map.insert(TECH_NAMES[i], iTechSessions[i]);
+        }
+    }
+    return map;
+}
+
+QVariantMap
+NdefMetrics::techActivationTime() const
+{
+    // Average, in milliseconds
+    QVariantMap map;
+
+    for (int i = 0; i < TECHS; i++) {
+        if (iTechActivations[i]) {
+            map.insert(TECH_NAMES[i],
+                iTechActivationMs[i] / iTechActivations[i]);
+        }
+    }
+    return map;
+}
+
+uint
+NdefMetrics::poolMissCount() const
+{
+    return iPoolMisses;
+}
+
+bool
+NdefMetrics::dump(
+    QString aFileName) const
+{
+    QFile file(aFileName);
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QTextStream out(&file);
+
+        for (int i = 0; i < StageCount; i++) {
+            out << STAGE_NAMES[i] << "_ms: " << stageTime((Stage)i) << "\n";
+        }
+        out << "apdus: " << iApduCount << "\n";
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            if (i < LATENCY_BUCKETS - 1) {
+                out << "latency_lt_" << LATENCY_LIMIT_US[i] << "us: ";
+            } else {
+                out << "latency_ge_" << LATENCY_LIMIT_US[i - 1] << "us: ";
+            }
+            out << iLatency[i] << "\n";
+        }
+        out << "bytes: " << iBytes << "\n";
+        out << "bytes_per_second: " << bytesPerSecond() << "\n";
+        out << "retries: " << iRetries << "\n";
+        out << "failures: " << iFailures << "\n";
+        out << "resets: " << iResets << "\n";
+        out << "leases: " << iLeases << "\n";
+        out << "last_lease_ms: " << iLastLeaseMs << "\n";
+        out << "max_lease_ms: " << iMaxLeaseMs << "\n";
+        out << "rejects: " << iRejects << "\n";
+        out << "pool_misses: " << iPoolMisses << "\n";
+        for (int i = 0; i < TECHS; i++) {
+            out << "sessions_" << TECH_NAMES[i] << ": " <<
+                iTechSessions[i] << "\n";
+            out << "activation_" << TECH_NAMES[i] << "_ms: " <<
+                (iTechActivations[i] ? (iTechActivationMs[i] /
+                iTechActivations[i]) : -1) << "\n";
+        }
+        QMapIterator<uint,uint> it(iRejected);
+        while (it.hasNext()) {
+            it.next();
+            out << "rejected_" <<
+                QString("%1").arg(it.key(), 6, 16, QLatin1Char('0')) <<
+                ": " << it.value() << "\n";
+        }
+        return true;
+    }
+    return false;
+}
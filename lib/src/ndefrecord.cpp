@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "ndefrecord.h"
+
+// ==========================================================================
+//
+// [NFCForum-TS-NDEF_1.0]
+//
+// NDEF record layout:
+//
+// +------------------------------------------------------------------------+
+// | Size | Description                                                     |
+// +------+-----------------------------------------------------------------+
+// | 1    | MB ME CF SR IL TNF                                              |
+// | 1    | TYPE LENGTH                                                     |
+// | 1/4  | PAYLOAD LENGTH (1 byte if SR is set, otherwise 4 bytes)         |
+// | 0/1  | ID LENGTH (present if IL is set)                                |
+// | -    | TYPE                                                            |
+// | -    | ID                                                              |
+// | -    | PAYLOAD                                                         |
+// +------------------------------------------------------------------------+
+//
+// ==========================================================================
+
+#define NDEF_HDR_SR  (0x10)
+#define NDEF_HDR_IL  (0x08)
+#define NDEF_HDR_TNF (0x07)
+#define NDEF_HDR_FLAGS (NdefRecord::FlagFirstAndLast)
+
+// ==========================================================================
+//
+// Compressed message record (external type sailfishos.org:ndefz):
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 1    | Compression method (1 = zlib)                          |
+// | 1      | 4    | Size of the original NDEF message (big-endian)         |
+// | 5      | -    | Compressed NDEF message (RFC 1950 zlib stream)         |
+// +------------------------------------------------------------------------+
+//
+// Which happens to be what qCompress() produces, prefixed by the method.
+//
+// ==========================================================================
+
+#define COMPRESSION_ZLIB (0x01)
+#define COMPRESSION_LEVEL (9)
+
+const char NdefRecord::COMPRESSED_TYPE[] = "sailfishos.org:ndefz";
+
+//static
+QByteArray
+NdefRecord::encode(
+    Tnf aTnf,
+    const QByteArray& aType,
+    const QByteArray& aPayload,
+    const QByteArray& aId,
+    int aFlags)
+{
+    const uint payloadLen = aPayload.size();
+    const bool sr = payloadLen < 0x100;
+    uchar hdr = (aFlags & NDEF_HDR_FLAGS) | (aTnf & NDEF_HDR_TNF);
+    QByteArray rec;
+
+    rec.reserve(6 + aType.size() + aId.size() + payloadLen);
+    if (sr) {
+        hdr |= NDEF_HDR_SR;
+    }
+    if (!aId.isEmpty()) {
+        hdr |= NDEF_HDR_IL;
+    }
+    rec.append((char)hdr);
+    rec.append((char)(uchar)aType.size());
+    if (sr) {
+        rec.append((char)(uchar)payloadLen);
+    } else {
+        // big-endian
+        rec.append((char)(uchar)(payloadLen >> 24));
+        rec.append((char)(uchar)(payloadLen >> 16));
+        rec.append((char)(uchar)(payloadLen >> 8));
+        rec.append((char)(uchar)payloadLen);
+    }
+    if (!aId.isEmpty()) {
+        rec.append((char)(uchar)aId.size());
+    }
+    rec.append(aType);
+    rec.append(aId);
+    rec.append(aPayload);
+    return rec;
+}
+
+//static
+uint
+NdefRecord::encodedSize(
+    uint aTypeSize,
+    uint aPayloadSize,
+    uint aIdSize)
+{
+    // Header and the type length are always there, the rest is
+    // laid out exactly the way encode() does it
+    return 2 + ((aPayloadSize < 0x100) ? 1 : 4) + (aIdSize ? 1 : 0) +
+        aTypeSize + aIdSize + aPayloadSize;
+}
+
+//static
+QByteArray
+NdefRecord::compress(
+    const QByteArray& aNdef)
+{
+    if (!aNdef.isEmpty()) {
+        QByteArray payload;
+
+        payload.append((char)COMPRESSION_ZLIB);
+        payload.append(qCompress(aNdef, COMPRESSION_LEVEL));
+
+        const QByteArray rec(encode(TnfExternal, QByteArray(COMPRESSED_TYPE),
+            payload));
+
+        // Short text doesn't compress well enough to pay for the headers
+        if (rec.size() < aNdef.size()) {
+            return rec;
+        }
+    }
+    return QByteArray();
+}
@@ -0,0 +1,1041 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "ndeftag.h"
+#include "nfcsharelog.h"
+
+#include <QtCore/QBitArray>
+#include <QtCore/QMap>
+#include <QtCore/QString>
+
+#define DBG(x) qCDebug(nfcshareApp) << x
+#define DUMP(x) qCDebug(nfcshareApdu) << x
+#define WARN(x) qCWarning(nfcshareApp) << x
+
+// ==========================================================================
+//
+// [NFCForum-TS-Type-4-Tag_2.0]
+//
+// Data Structure of the Capability Container File:
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 2    | CCLEN (total length, 0x000F-0xFFFE bytes)              |
+// | 2      | 1    | Mapping Version (major/minor 4 bits each)              |
+// | 3      | 2    | MLe (Maximum R-APDU data size, 0x000F..0xFFFF bytes)   |
+// | 5      | 2    | MLc (Maximum C-APDU data size, 0x0001..0xFFFF bytes)   |
+// | 7      | 8    | NDEF File Control TLV (see below)                      |
+// | 15     | -    | Zero, one, or more TLV blocks                          |
+// +------------------------------------------------------------------------+
+//
+// NDEF File Control TLV:
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 1    | T = 4                                                  |
+// | 1      | 1    | L = 6                                                  |
+// | 2      | 2    | File Identifier                                        |
+// | 4      | 2    | Maximum NDEF file size, 0x0005..0xFFFE                 |
+// | 6      | 1    | NDEF file read access condition (0x00)                 |
+// | 7      | 1    | NDEF file write access condition (0x00|0xFF)           |
+// +------------------------------------------------------------------------+
+//
+// Data Structure of the NDEF File:
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 2    | N = NDEF message size (big-endian)                     |
+// | 2      | N    | NDEF message                                           |
+// +------------------------------------------------------------------------+
+//
+// ==========================================================================
+static const uchar ndef_aid[] = { 0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01 };
+static const uchar ndef_aid_v1[] = { 0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x00 };
+static const uchar mf[] = { 0x3f, 0x00 };
+static const uchar cc_ef[] = { 0xe1, 0x03 };
+static const uchar cc_data_template[] = {
+    0x00, 0x0f, 0x20, 0xff, 0xff, 0xff, 0xff,      /* CC header 7 bytes */
+    0x04, 0x06, 0xe1, 0x04, 0x00, 0x00, 0x00, 0xff /* NDEF File Control TLV */
+                /*  fid */  /* size */
+};
+#define CC_MLE_OFFSET       (3)
+#define CC_NDEF_TLV_OFFSET  (7)
+#define CC_NDEF_FID_OFFSET  (CC_NDEF_TLV_OFFSET + 2)
+#define CC_NDEF_SIZE_OFFSET (CC_NDEF_TLV_OFFSET + 4)
+#define CC_NDEF_WRITE_OFFSET (CC_NDEF_TLV_OFFSET + 7)
+#define CC_NDEF_FID_SIZE    (2)
+
+#define ISO_CLA (0x00)
+#define ISO_INS_SELECT (0xa4)
+#define ISO_INS_READ_BINARY (0xb0)
+#define ISO_INS_READ_BINARY_ODO (0xb1)
+#define ISO_INS_UPDATE_BINARY (0xd6)
+#define ISO_TAG_OFFSET (0x54)       // Offset data object
+#define ISO_TAG_DISCRETIONARY (0x53)
+
+// Ne as decoded by nfcd: 256 for short Le=00, 65536 for extended
+// Le=0000, zero if there's no Le at all.
+#define ISO_SHORT_NE_MAX (0x100)
+
+// SELECT P1 (how the file is identified)
+#define ISO_P1_SELECT_BY_ID (0x00)      // MF, DF or EF identifier
+#define ISO_P1_SELECT_CHILD_EF (0x02)   // EF under the current DF
+#define ISO_P1_SELECT_BY_NAME (0x04)    // DF name (AID)
+#define ISO_P1_SELECT_PATH_MF (0x08)    // Path from the MF
+#define ISO_P1_SELECT_PATH_DF (0x09)    // Path from the current DF
+
+// SELECT P2 (which occurrence and what to return)
+#define ISO_P2_OCCURRENCE_MASK (0x03)
+#define ISO_P2_SELECT_FILE_FIRST (0x00)
+#define ISO_P2_SELECT_FILE_LAST (0x01)
+#define ISO_P2_RESPONSE_MASK (0x0c)
+#define ISO_P2_RESPONSE_FCI (0x00)
+#define ISO_P2_RESPONSE_FCP (0x04)
+#define ISO_P2_RESPONSE_FMD (0x08)
+#define ISO_P2_RESPONSE_NONE (0x0c)
+
+// Control parameter templates
+#define ISO_TAG_FCP (0x62)
+#define ISO_TAG_FMD (0x64)
+#define ISO_TAG_FCI (0x6f)
+
+#define MAX_LE (0xffff)             // Largest MLe that fits into the CC
+#define MIN_LE (0x000f)
+#define MAX_NDEF_FILE_SIZE (0xfffe)
+#define MAX_NDEF_MESSAGE_SIZE (MAX_NDEF_FILE_SIZE - 2)
+#define MAX_UPDATE_OFFSET (0x7fff)  // P1-P2 of UPDATE BINARY (D6)
+#define MAX_RECEIVE_SIZE (MAX_UPDATE_OFFSET - 2)
+#define NDEF_ACCESS_GRANTED (0x00)
+
+// 9000 - Normal processing
+#define RESP_OK 0x90, 0x00
+// 6282 - End of file reached before reading Ne bytes
+#define RESP_END_OF_FILE 0x62, 0x82
+// 6700 - Wrong length
+#define RESP_WRONG_LENGTH 0x67, 0x00
+// 6982 - Security status not satisfied
+#define RESP_READ_ONLY 0x69, 0x82
+// 6986 - Command not allowed (no current EF)
+#define RESP_NO_CURRENT_EF 0x69, 0x86
+// 6A80 - Incorrect parameters in the command data field
+#define RESP_WRONG_DATA 0x6a, 0x80
+// 6A81 - Function not supported
+#define RESP_FUNC_NOT_SUPPORTED 0x6a, 0x81
+// 6A82 - File or application not found
+#define RESP_NOT_FOUND 0x6a, 0x82
+// 6A86 - Incorrect parameters P1-P2
+#define RESP_WRONG_P1P2 0x6a, 0x86
+// 6B00 - Wrong parameters P1-P2 (offset outside the EF)
+#define RESP_WRONG_OFFSET 0x6b, 0x00
+// 6D00 - Instruction code not supported or invalid
+#define RESP_INS_NOT_SUPPORTED 0x6d, 0x00
+// 6E00 - Class not supported
+#define RESP_CLA_NOT_SUPPORTED 0x6e, 0x00
+
+// ==========================================================================
+// NdefTag::Response
+// ==========================================================================
+
+NdefTag::Response::Response() :
+    iSw{0x6f, 0x00}, // 6F00 - Failure (No precise diagnosis)
+    iResponseId(0)
+{}
+
+NdefTag::Response::Response(
+    uchar aSw1,
+    uchar aSw2,
+    const QByteArray& aData) :
+    iSw{aSw1, aSw2},
+    iData(aData),
+    iResponseId(nextId())
+{}
+
+//static
+NdefTag::Response
+NdefTag::Response::error(
+    uchar aSw1,
+    uchar aSw2)
+{
+    Response response;
+
+    // Still no id, it's a failure
+    response.iSw[0] = aSw1;
+    response.iSw[1] = aSw2;
+    return response;
+}
+
+//static
+uint
+NdefTag::Response::nextId()
+{
+    static uint lastId = 0;
+    while (!++lastId);
+    return lastId;
+}
+
+bool
+NdefTag::Response::isOk() const
+{
+    // Failures don't have ids
+    return iResponseId != 0;
+}
+
+uint
+NdefTag::Response::id() const
+{
+    return iResponseId;
+}
+
+const QByteArray&
+NdefTag::Response::data() const
+{
+    return iData;
+}
+
+uchar
+NdefTag::Response::sw1() const
+{
+    return iSw[0];
+}
+
+uchar
+NdefTag::Response::sw2() const
+{
+    return iSw[1];
+}
+
+// ==========================================================================
+// NdefTag::File
+// ==========================================================================
+
+class NdefTag::File
+{
+public:
+    File();
+    File(QString, const QByteArray&, const QByteArray&);
+
+    bool isValid() const;
+    bool isFullyRead() const;
+    uint size() const;
+    uint bytesRead() const;
+    void reset();
+    void confirmRead();
+    QString name() const;
+    QByteArray fid() const;
+    QByteArray controlParameters(uchar) const;
+    QByteArray read(uint, uint);
+
+private:
+    QString iName;
+    QByteArray iFid;
+    QByteArray iData;
+    QBitArray iBytesRead;   // One bit per byte in iData
+    int iLastReadStart;     // Inclusive
+    int iLastReadEnd;       // Exclusive
+};
+
+NdefTag::File::File(
+    QString aName,
+    const QByteArray& aFid,
+    const QByteArray& aData) :
+    iName(aName),
+    iFid(aFid),
+    iData(aData),
+    iBytesRead(aData.size()),
+    iLastReadStart(0),
+    iLastReadEnd(0)
+{
+}
+
+NdefTag::File::File() :
+    iLastReadStart(0),
+    iLastReadEnd(0)
+{}
+
+bool
+NdefTag::File::isValid() const
+{
+    return !iFid.isEmpty();
+}
+
+bool
+NdefTag::File::isFullyRead() const
+{
+    return bytesRead() == size();
+}
+
+QString
+NdefTag::File::name() const
+{
+    return iName;
+}
+
+QByteArray
+NdefTag::File::fid() const
+{
+    return iFid;
+}
+
+uint
+NdefTag::File::size() const
+{
+    return iData.size();
+}
+
+uint
+NdefTag::File::bytesRead() const
+{
+    return iBytesRead.count(true);
+}
+
+void
+NdefTag::File::reset()
+{
+    iBytesRead.fill(false);
+    iLastReadStart = iLastReadEnd = 0;
+}
+
+void
+NdefTag::File::confirmRead()
+{
+    iBytesRead.fill(true, iLastReadStart, iLastReadEnd);
+    iLastReadStart = iLastReadEnd = 0;
+    DBG(bytesRead() << "bytes out of" << size());
+}
+
+QByteArray
+NdefTag::File::controlParameters(
+    uchar aTag) const
+{
+    QByteArray data;
+
+    // Returned by SELECT if the reader asks for FCI, FCP or FMD
+    data.append(aTag);
+    if (aTag == ISO_TAG_FMD) {
+        data.append((char)0);
+    } else {
+        data.append((char)11);
+        data.append((char)0x80);        // Data size
+        data.append((char)2);
+        data.append((uchar)(iData.size() >> 8));
+        data.append((uchar)iData.size());
+        data.append((char)0x82);        // Working EF, transparent
+        data.append((char)1);
+        data.append((char)0x01);
+        data.append((char)0x83);        // File identifier
+        data.append((char)2);
+        data.append(iFid);
+    }
+    return data;
+}
+
+QByteArray
+NdefTag::File::read(
+    uint aOffset,
+    uint aExpected)
+{
+    const uint off = qMin(uint(iData.size()), aOffset);
+    const uint len = qMin(aExpected, iData.size() - off);
+
+    DBG("Reading [" << off << ".." << (off + len - 1) << "] from" << iName);
+    iLastReadEnd = (iLastReadStart = off) + len;
+    return iData.mid(off, len);
+}
+
+// ==========================================================================
+// NdefTag::Private
+// ==========================================================================
+
+class NdefTag::Private
+{
+public:
+    Private(const void*, uint, uint, uint);
+
+    static uint receiveBufferSize(uint, uint);
+    static QByteArray ccFileData(uint, uint, uint);
+    static QByteArray ndefFileData(const void*, uint);
+    static QByteArray filePath(uchar, const QByteArray&);
+    static uint doHeaderSize(uint);
+    Response select(uchar, uchar, const QByteArray&);
+    Response selectFile(uchar, const QByteArray&);
+    Response readBinary(uchar, uchar, uint);
+    Response readBinaryOdo(uchar, uchar, const QByteArray&, uint);
+    Response readFile(uint, uint, bool);
+    Response updateBinary(uchar, uchar, const QByteArray&);
+    File* findFile(const QByteArray&);
+    void commit();
+    int mayBeReset();
+    int mayBeDone();
+
+public:
+    QMap<QByteArray,File> iFiles;
+    File* iNdefFile;
+    File iWrittenFile;          // Replaces iNdefFile for the readers
+    File* iSelectedFile;
+    uint iLastReadId;
+    bool iDone;
+    const uint iMaxLe;
+    const uint iReceiveSize;
+    QByteArray iReceiveBuffer;  // NLEN followed by the message
+    QByteArray iPendingReceived;
+    QByteArray iReceived;
+    uint iLastWriteId;
+    bool iLegacyAid;
+};
+
+NdefTag::Private::Private(
+    const void* aNdefData,
+    uint aNdefSize,
+    uint aMaxLe,
+    uint aReceiveSize) :
+    iSelectedFile(Q_NULLPTR),
+    iLastReadId(0),
+    iDone(false),
+    iMaxLe(aMaxLe ? qBound(uint(MIN_LE), aMaxLe, uint(MAX_LE)) : MAX_LE),
+    iReceiveSize(qMin(aReceiveSize, uint(MAX_RECEIVE_SIZE))),
+    iLastWriteId(0),
+    iLegacyAid(false)
+{
+    // Set files (CC and NDEF)
+    QByteArray idCc((char*)cc_ef, sizeof(cc_ef));
+    QByteArray idNdef((char*)(cc_data_template + CC_NDEF_FID_OFFSET), CC_NDEF_FID_SIZE);
+    iFiles.insert(idCc, File("CC", idCc, ccFileData(aNdefSize, iMaxLe,
+        iReceiveSize)));
+    iFiles.insert(idNdef, File("NDEF", idNdef, ndefFileData(aNdefData, aNdefSize)));
+    iNdefFile = &iFiles[idNdef];
+
+    // Whatever the reader writes goes here, not into the NDEF file
+    // it reads. Allocated upfront, nothing gets allocated per write.
+    if (iReceiveSize) {
+        iReceiveBuffer.fill(0, receiveBufferSize(aNdefSize, iReceiveSize));
+    }
+}
+
+//static
+uint
+NdefTag::Private::receiveBufferSize(
+    uint aNdefSize,
+    uint aReceiveSize)
+{
+    // NLEN plus the message. The CC advertises the size of the NDEF
+    // file, the reader may write a message as large as the one it reads.
+    if (!aReceiveSize) {
+        return 0;
+    } else if (aNdefSize <= MAX_NDEF_MESSAGE_SIZE) {
+        return qMax(aNdefSize, aReceiveSize) + 2;
+    } else {
+        return aReceiveSize + 2;
+    }
+}
+
+//static
+QByteArray
+NdefTag::Private::ccFileData(
+    uint aNdefSize,
+    uint aMaxLe,
+    uint aReceiveSize)
+{
+    QByteArray data((const char*)cc_data_template, sizeof(cc_data_template));
+    const uint ndefFileLen = aNdefSize + 2; // Extra 2 bytes for the message size
+
+    // Readers are not supposed to ask for more than that per READ BINARY
+    data[CC_MLE_OFFSET + 0] = (uchar)(aMaxLe >> 8);
+    data[CC_MLE_OFFSET + 1] = (uchar)(aMaxLe);
+
+    if (ndefFileLen <= MAX_NDEF_FILE_SIZE) {
+        // Exactly as much as the receive buffer holds, if writable
+        const uint maxFileLen = aReceiveSize ?
+            receiveBufferSize(aNdefSize, aReceiveSize) : ndefFileLen;
+
+        // big-endian
+        data[CC_NDEF_SIZE_OFFSET + 0] = (uchar)(maxFileLen >> 8);
+        data[CC_NDEF_SIZE_OFFSET + 1] = (uchar)(maxFileLen);
+        if (aReceiveSize) {
+            data[CC_NDEF_WRITE_OFFSET] = NDEF_ACCESS_GRANTED;
+        }
+    } else {
+        WARN("NDEF message too large:" << aNdefSize << "byte(s)");
+    }
+    return data;
+}
+
+//static
+QByteArray
+NdefTag::Private::ndefFileData(
+    const void* aNdefData,
+    uint aNdefSize)
+{
+    QByteArray data;
+
+    // Data Structure of the NDEF File:
+    //
+    // +--------------------------------------------------------------------+
+    // | Offset | Size | Description                                        |
+    // +--------+------+----------------------------------------------------+
+    // | 0      | 2    | N = NDEF message size (big-endian)                 |
+    // | 2      | N    | NDEF message                                       |
+    // +--------------------------------------------------------------------+
+    if (aNdefSize <= MAX_NDEF_MESSAGE_SIZE) {
+        data.reserve(aNdefSize + 2);
+        data.append((uchar)(aNdefSize >> 8)); // big-endian
+        data.append((uchar)aNdefSize);
+        data.append((char*)aNdefData, aNdefSize);
+    }
+    return data;
+}
+
+//static
+QByteArray
+NdefTag::Private::filePath(
+    uchar aP1,
+    const QByteArray& aPath)
+{
+    // Everything lives right under the MF, so the path can only consist
+    // of the file id, optionally preceded by the MF id. The MF id isn't
+    // supposed to be there for P1=08 but some readers include it anyway.
+    // Returns the file id or an empty array if the path goes nowhere.
+    const QByteArray mfId((const char*)mf, sizeof(mf));
+
+    if (aPath.size() == 2) {
+        return aPath;
+    } else if (aPath.size() == 4 && aP1 == ISO_P1_SELECT_PATH_MF &&
+        aPath.startsWith(mfId)) {
+        return aPath.mid(2);
+    }
+    return QByteArray();
+}
+
+NdefTag::Response
+NdefTag::Private::select(
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData)
+{
+    // Type 4 tag spec only needs P1=00 P2=0C (v2) and P1=04 P2=00 (v1)
+    // but rejecting other sane variants only makes readers retry.
+    if (aP2 & ~(ISO_P2_OCCURRENCE_MASK | ISO_P2_RESPONSE_MASK)) {
+        DBG("Unsupported SELECT P2" << hex << aP2);
+        return Response::error(RESP_WRONG_P1P2);
+    }
+
+    // Each file and application occurs once, there's no next or previous
+    const uchar occurrence = aP2 & ISO_P2_OCCURRENCE_MASK;
+    if (occurrence != ISO_P2_SELECT_FILE_FIRST &&
+        occurrence != ISO_P2_SELECT_FILE_LAST) {
+        DBG("No other occurrence of" << aData.toHex().constData());
+        return Response::error(RESP_NOT_FOUND);
+    }
+
+    switch (aP1) {
+    case ISO_P1_SELECT_BY_ID:
+    case ISO_P1_SELECT_CHILD_EF:
+        if (aData.size() != 2) {
+            DBG("Invalid file id" << aData.toHex().constData());
+            return Response::error(RESP_WRONG_LENGTH);
+        } else if (aP1 == ISO_P1_SELECT_BY_ID &&
+            aData == QByteArray::fromRawData((const char*)mf, sizeof(mf))) {
+            // Some readers start from the MF
+            iSelectedFile = Q_NULLPTR;
+            DBG("Selected MF");
+            return Response(RESP_OK);
+        }
+        return selectFile(aP2, aData);
+    case ISO_P1_SELECT_PATH_MF:
+    case ISO_P1_SELECT_PATH_DF:
+        if (aData.isEmpty() || (aData.size() & 1)) {
+            DBG("Invalid path" << aData.toHex().constData());
+            return Response::error(RESP_WRONG_LENGTH);
+        }
+        return selectFile(aP2, filePath(aP1, aData));
+    case ISO_P1_SELECT_BY_NAME:
+        // nfcd normally handles this one but may pass it through
+        // once the app has been selected
+        if (aData == NdefTag::aid() ||
+            (iLegacyAid && aData == NdefTag::legacyAid())) {
+            iSelectedFile = Q_NULLPTR;
+            DBG("Selected" << aData.toHex().constData());
+            return Response(RESP_OK);
+        }
+        DBG("Unknown application" << aData.toHex().constData());
+        return Response::error(RESP_NOT_FOUND);
+    default:
+        DBG("Unsupported SELECT P1" << hex << aP1);
+        return Response::error(RESP_WRONG_P1P2);
+    }
+}
+
+NdefTag::File*
+NdefTag::Private::findFile(
+    const QByteArray& aFid)
+{
+    if (!iFiles.contains(aFid)) {
+        return Q_NULLPTR;
+    }
+
+    File* file = &iFiles[aFid];
+
+    // Once the reader has written a message, that's what gets read
+    return (file == iNdefFile && iWrittenFile.isValid()) ?
+        &iWrittenFile : file;
+}
+
+NdefTag::Response
+NdefTag::Private::selectFile(
+    uchar aP2,
+    const QByteArray& aFid)
+{
+    File* file = findFile(aFid);
+
+    if (file) {
+        iSelectedFile = file;
+        DBG("Selected" << aFid.toHex().constData() << iSelectedFile->name());
+        switch (aP2 & ISO_P2_RESPONSE_MASK) {
+        case ISO_P2_RESPONSE_FCI:
+            return Response(RESP_OK, iSelectedFile->controlParameters(ISO_TAG_FCI));
+        case ISO_P2_RESPONSE_FCP:
+            return Response(RESP_OK, iSelectedFile->controlParameters(ISO_TAG_FCP));
+        case ISO_P2_RESPONSE_FMD:
+            return Response(RESP_OK, iSelectedFile->controlParameters(ISO_TAG_FMD));
+        default:
+            return Response(RESP_OK);
+        }
+    } else {
+        DBG("Unknown file" << aFid.toHex().constData());
+        return Response::error(RESP_NOT_FOUND);
+    }
+}
+
+NdefTag::Response
+NdefTag::Private::readBinary(
+    uchar aP1,
+    uchar aP2,
+    uint aLe)
+{
+    // If bit 1 of INS is set to 0 and bit 8 of P1 to 0, then P1-P2
+    // (fifteen bits) encodes an offset from zero to 32767.
+    if (!(aP1 & 0x80) && iSelectedFile) {
+        return readFile(((uint) aP1 << 8) | aP2, aLe, false);
+    } else if (!iSelectedFile) {
+        return Response::error(RESP_NO_CURRENT_EF);
+    } else {
+        // Short EF identifiers aren't supported
+        return Response::error(RESP_FUNC_NOT_SUPPORTED);
+    }
+}
+
+NdefTag::Response
+NdefTag::Private::readBinaryOdo(
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData,
+    uint aLe)
+{
+    // If bit 1 of INS is set to 1, then the offset comes in the offset
+    // data object (tag 54) which allows offsets beyond 32767. P1-P2 is
+    // either zero (current EF) or the file identifier.
+    const uint p1p2 = ((uint) aP1 << 8) | aP2;
+    const uchar* odo = (const uchar*)aData.constData();
+
+    if (p1p2) {
+        if (!(p1p2 & 0xffe0)) {
+            // Short EF identifiers aren't supported
+            return Response::error(RESP_FUNC_NOT_SUPPORTED);
+        }
+
+        QByteArray fid;
+
+        fid.append((char)aP1);
+        fid.append((char)aP2);
+
+        File* file = findFile(fid);
+
+        if (!file) {
+            DBG("Unknown file" << fid.toHex().constData());
+            return Response::error(RESP_NOT_FOUND);
+        }
+        iSelectedFile = file;
+    } else if (!iSelectedFile) {
+        return Response::error(RESP_NO_CURRENT_EF);
+    }
+
+    if (aData.size() < 3 || odo[0] != ISO_TAG_OFFSET || odo[1] < 1 ||
+        odo[1] > 3 || aData.size() != odo[1] + 2) {
+        DBG("Invalid offset data object" << aData.toHex().constData());
+        return Response::error(RESP_WRONG_DATA);
+    }
+
+    uint off = 0;
+    for (int i = 0; i < odo[1]; i++) {
+        off = (off << 8) | odo[2 + i];
+    }
+    return readFile(off, aLe, true);
+}
+
+//static
+uint
+NdefTag::Private::doHeaderSize(
+    uint aLength)
+{
+    // BER-TLV tag and length of a data object up to 64K
+    return (aLength < 0x80) ? 2 : (aLength < 0x100) ? 3 : 4;
+}
+
+NdefTag::Response
+NdefTag::Private::readFile(
+    uint aOffset,
+    uint aLe,
+    bool aWrap)
+{
+    // Absent Le is treated as a short Le=00. Some stacks drop it,
+    // and it's not like we have anything else to return.
+    const uint requested = aLe ? aLe : ISO_SHORT_NE_MAX;
+    const uint ne = qMin(requested, iMaxLe);
+    const uint size = iSelectedFile->size();
+
+    if (aOffset >= size) {
+        DBG("Offset" << aOffset << "is outside of" << iSelectedFile->name());
+        return Response::error(RESP_WRONG_OFFSET);
+    }
+
+    const uint avail = size - aOffset;
+    uint len = qMin(avail, ne);
+
+    if (aWrap) {
+        // The data object header (53 L) takes up to 4 bytes of Ne
+        while (len && doHeaderSize(len) + len > ne) {
+            len--;
+        }
+        if (!len) {
+            return Response::error(RESP_WRONG_LENGTH);
+        }
+    }
+
+    const QByteArray chunk(iSelectedFile->read(aOffset, len));
+    QByteArray data;
+
+    if (aWrap) {
+        const uint head = doHeaderSize(len);
+
+        data.reserve(head + len);
+        data.append((char)ISO_TAG_DISCRETIONARY);
+        if (head > 2) {
+            data.append((char)(0x80 + head - 2));
+            if (head > 3) {
+                data.append((uchar)(len >> 8));
+            }
+        }
+        data.append((uchar)len);
+        data.append(chunk);
+    } else {
+        data = chunk;
+    }
+
+    DUMP(data.toHex().constData());
+    if (len == avail && (uint)data.size() < requested) {
+        // It's a warning, the data are still there
+        return Response(RESP_END_OF_FILE, data);
+    }
+    return Response(RESP_OK, data);
+}
+
+NdefTag::Response
+NdefTag::Private::updateBinary(
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData)
+{
+    // [NFCForum-TS-Type-4-Tag_2.0] 5.4.5 NDEF Update Procedure: NLEN
+    // gets zeroed, then the message is written and then NLEN is set
+    // to its length. The last step (or a single write covering all
+    // of it) is what makes the new message complete.
+    const uint offset = ((uint) aP1 << 8) | aP2;
+    const uint len = aData.size();
+
+    if (!iSelectedFile) {
+        return Response::error(RESP_NO_CURRENT_EF);
+    } else if (aP1 & 0x80) {
+        // Short EF identifiers aren't supported
+        return Response::error(RESP_FUNC_NOT_SUPPORTED);
+    } else if (iSelectedFile != iNdefFile &&
+        iSelectedFile != &iWrittenFile) {
+        DBG(iSelectedFile->name() << "is read-only");
+        return Response::error(RESP_READ_ONLY);
+    } else if (!len) {
+        return Response::error(RESP_WRONG_LENGTH);
+    } else if (offset >= (uint)iReceiveBuffer.size()) {
+        DBG("Offset" << offset << "is outside of the receive buffer");
+        return Response::error(RESP_WRONG_OFFSET);
+    } else if (offset + len > (uint)iReceiveBuffer.size()) {
+        DBG("Can't write" << len << "bytes at" << offset);
+        return Response::error(RESP_WRONG_LENGTH);
+    }
+
+    DBG("Writing [" << offset << ".." << (offset + len - 1) << "]");
+    DUMP(aData.toHex().constData());
+    iReceiveBuffer.replace(offset, len, aData);
+
+    Response response(RESP_OK);
+
+    if (offset < 2) {
+        const uchar* buf = (const uchar*)iReceiveBuffer.constData();
+        const uint nlen = ((uint)buf[0] << 8) | buf[1];
+
+        if (!nlen) {
+            // The update has started, forget the previous commit
+            iPendingReceived.clear();
+            iLastWriteId = 0;
+        } else if (nlen + 2 <= (uint)iReceiveBuffer.size()) {
+            // Becomes the received message once the reader has
+            // actually got the response
+            DBG("Received" << nlen << "bytes");
+            iPendingReceived = iReceiveBuffer.mid(2, nlen);
+            iLastWriteId = response.id();
+        } else {
+            DBG("Invalid NLEN" << nlen);
+        }
+    }
+    return response;
+}
+
+void
+NdefTag::Private::commit()
+{
+    const QByteArray fid(iNdefFile->fid());
+
+    // The written message replaces the original one for the readers,
+    // the original still counts for the progress and completion
+    iReceived = iPendingReceived;
+    iPendingReceived.clear();
+    iLastWriteId = 0;
+    iWrittenFile = File(iNdefFile->name(), fid,
+        ndefFileData(iReceived.constData(), iReceived.size()));
+    if (iSelectedFile == iNdefFile) {
+        iSelectedFile = &iWrittenFile;
+    }
+}
+
+int
+NdefTag::Private::mayBeReset()
+{
+    if (!iDone && !iNdefFile->isFullyRead() && iNdefFile->bytesRead()) {
+        iNdefFile->reset();
+        return EventReset;
+    }
+    return EventNone;
+}
+
+int
+NdefTag::Private::mayBeDone()
+{
+    if (iNdefFile->isFullyRead()) {
+        iDone = true;
+        return EventDone;
+    }
+    return EventNone;
+}
+
+// ==========================================================================
+// NdefTag
+// ==========================================================================
+
+NdefTag::NdefTag(
+    const void* aNdefData,
+    uint aNdefSize,
+    uint aMaxLe,
+    uint aReceiveSize) :
+    iPrivate(new Private(aNdefData, aNdefSize, aMaxLe, aReceiveSize))
+{}
+
+NdefTag::~NdefTag()
+{
+    delete iPrivate;
+}
+
+//static
+uint
+NdefTag::maxMessageSize()
+{
+    return MAX_NDEF_MESSAGE_SIZE;
+}
+
+//static
+uint
+NdefTag::maxReceiveSize()
+{
+    // Everything has to be reachable by UPDATE BINARY offsets
+    return MAX_RECEIVE_SIZE;
+}
+
+//static
+QByteArray
+NdefTag::aid()
+{
+    return QByteArray((const char*)ndef_aid, sizeof(ndef_aid));
+}
+
+//static
+QByteArray
+NdefTag::legacyAid()
+{
+    // Type 4 tag mapping version 1.0
+    return QByteArray((const char*)ndef_aid_v1, sizeof(ndef_aid_v1));
+}
+
+bool
+NdefTag::isTooMuchData() const
+{
+    // Empty NDEF file means that the message is too large
+    return !iPrivate->iNdefFile->size();
+}
+
+bool
+NdefTag::isDone() const
+{
+    return iPrivate->iDone;
+}
+
+uint
+NdefTag::size() const
+{
+    return iPrivate->iNdefFile->size();
+}
+
+uint
+NdefTag::bytesRead() const
+{
+    return iPrivate->iNdefFile->bytesRead();
+}
+
+QByteArray
+NdefTag::received() const
+{
+    return iPrivate->iReceived;
+}
+
+void
+NdefTag::setLegacyAidEnabled(
+    bool aEnabled)
+{
+    iPrivate->iLegacyAid = aEnabled;
+}
+
+void
+NdefTag::replace(
+    const void* aNdefData,
+    uint aNdefSize)
+{
+    // Starts from scratch with a different message, nothing selected,
+    // read or written
+    const uint maxLe = iPrivate->iMaxLe;
+    const uint receiveSize = iPrivate->iReceiveSize;
+    const bool legacyAid = iPrivate->iLegacyAid;
+
+    delete iPrivate;
+    iPrivate = new Private(aNdefData, aNdefSize, maxLe, receiveSize);
+    iPrivate->iLegacyAid = legacyAid;
+}
+
+NdefTag::Response
+NdefTag::process(
+    uchar aCla,
+    uchar aIns,
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData,
+    uint aLe)
+{
+    Response response;
+
+    if (aCla != ISO_CLA) {
+        response = Response::error(RESP_CLA_NOT_SUPPORTED);
+    } else if (aIns == ISO_INS_SELECT) {
+        response = iPrivate->select(aP1, aP2, aData);
+    } else if (aIns == ISO_INS_READ_BINARY) {
+        response = iPrivate->readBinary(aP1, aP2, aLe);
+        iPrivate->iLastReadId = response.id();
+    } else if (aIns == ISO_INS_READ_BINARY_ODO) {
+        response = iPrivate->readBinaryOdo(aP1, aP2, aData, aLe);
+        iPrivate->iLastReadId = response.id();
+    } else if (aIns == ISO_INS_UPDATE_BINARY && iPrivate->iReceiveSize) {
+        response = iPrivate->updateBinary(aP1, aP2, aData);
+    } else {
+        response = Response::error(RESP_INS_NOT_SUPPORTED);
+    }
+    return response;
+}
+
+int
+NdefTag::responseStatus(
+    uint aResponseId,
+    bool aOk)
+{
+    File* file = iPrivate->iSelectedFile;
+
+    if (aOk && iPrivate->iLastWriteId && iPrivate->iLastWriteId == aResponseId) {
+        DBG("Write" << aResponseId << "confirmed");
+        iPrivate->commit();
+        return EventReceived;
+    } else if (aOk && iPrivate->iLastReadId == aResponseId && file) {
+        const uint prev = bytesRead();
+
+        DBG("Read" << aResponseId << "confirmed");
+        file->confirmRead();
+        if (bytesRead() > prev) {
+            return EventProgress;
+        }
+    }
+    return EventNone;
+}
+
+int
+NdefTag::start()
+{
+    return iPrivate->mayBeReset();
+}
+
+int
+NdefTag::stop()
+{
+    // Same thing for Restart and Stop
+    const int events = iPrivate->mayBeDone();
+
+    return events | iPrivate->mayBeReset();
+}
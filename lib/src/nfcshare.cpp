@@ -0,0 +1,736 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcshare.h"
+#include "ndefapp.h"
+#include "ndefcache.h"
+#include "ndefrecord.h"
+#include "nfcsharelog.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QLocale>
+#include <QtCore/QPointer>
+#include <QtCore/QUrl>
+
+#include <ndef_rec.h>
+
+#define DBG(x) qCDebug(nfcshareShare) << x
+#define WARN(x) qCWarning(nfcshareShare) << x
+#define TRACE(...) qCDebug(nfcshareTrace, __VA_ARGS__)
+
+// ==========================================================================
+// NfcShare::Private
+// ==========================================================================
+
+class NfcShare::Private :
+    public NdefGenerator
+{
+public:
+    Private();
+    ~Private();
+
+    static QByteArray cacheKey(const QString&);
+    static QByteArray encode(const QString&);
+    static uint encodedSize(const QString&, uint);
+    static uint textLangSize();
+
+    // NdefGenerator
+    QByteArray generate() Q_DECL_OVERRIDE;
+
+public:
+    NdefApp* iApp;
+    QString iText;
+    QPointer<NfcShareBearer> iBearer;
+    bool iHandover;
+    Transport iTransport;
+    bool iCompress;
+    int iIdleTimeout;
+    int iTechs;
+    QPointer<NfcShareGenerator> iGenerator;
+    uint iBytesEstimate;    // While the message is being encoded
+    uint iReceiveSize;
+};
+
+NfcShare::Private::Private() :
+    iApp(Q_NULLPTR),
+    iHandover(false),
+    iTransport(Type4Tag),
+    iCompress(false),
+    iIdleTimeout(0),
+    iTechs(NdefApp::defaultTechs()),
+    iBytesEstimate(0),
+    iReceiveSize(0)
+{}
+
+NfcShare::Private::~Private()
+{
+    delete iApp;
+}
+
+//static
+QByteArray
+NfcShare::Private::cacheKey(
+    const QString& aText)
+{
+    // Text records are tagged with the language of the current locale
+    QByteArray key(QLocale().name().toLatin1());
+
+    key.append('\0');
+    key.append((const char*)aText.constData(), aText.size() * sizeof(QChar));
+    return key;
+}
+
+//static
+QByteArray
+NfcShare::Private::encode(
+    const QString& aText)
+{
+    NdefRec* ndef = Q_NULLPTR;
+    QElapsedTimer timer;
+    qint64 utf8Ns = 0, detectNs = 0;
+
+    // Each step of the encoding pipeline gets timed separately (see
+    // the encode.record tracepoint below) if tracing is enabled. The
+    // generator calls this for every message, don't read the clock
+    // for nothing.
+    const bool trace = nfcshareTrace().isDebugEnabled();
+
+    if (trace) {
+        timer.start();
+    }
+    const QByteArray utf8(aText.toUtf8());
+    if (trace) {
+        utf8Ns = timer.nsecsElapsed();
+    }
+
+    // Transform URL into a URI record and everything else
+    // into a Text record
+    const bool isUri = (utf8.startsWith("http://") ||
+        utf8.startsWith("https://")) && QUrl(aText).isValid();
+    if (trace) {
+        detectNs = timer.nsecsElapsed();
+    }
+
+    if (isUri) {
+        NdefRecU* uri = ndef_rec_u_new(utf8.constData());
+
+        if (uri) {
+            ndef = &uri->rec;
+        }
+    } else {
+        NdefRecT* rec = ndef_rec_t_new(utf8.constData(), Q_NULLPTR);
+
+        if (rec) {
+            ndef = &rec->rec;
+        }
+    }
+
+    QByteArray msg;
+
+    if (ndef) {
+        msg = QByteArray((const char*)ndef->raw.bytes, ndef->raw.size);
+        ndef_rec_unref(ndef);
+    }
+    if (trace) {
+        TRACE("encode.record utf8=%d ndef=%d uri=%d utf8_us=%lld "
+            "detect_us=%lld record_us=%lld", utf8.size(), msg.size(), isUri,
+            utf8Ns / 1000, (detectNs - utf8Ns) / 1000,
+            (timer.nsecsElapsed() - detectNs) / 1000);
+    }
+    return msg;
+}
+
+//static
+uint
+NfcShare::Private::textLangSize()
+{
+    // Only changes with the locale, same as cacheKey() assumes
+    static QString locale;
+    static uint size = 0;
+    const QString name(QLocale().name());
+
+    if (locale != name) {
+        // The language is chosen by libnfcdef, an empty record tells
+        // how long its code is (low 6 bits of the status byte)
+        NdefRecT* rec = ndef_rec_t_new("", Q_NULLPTR);
+
+        size = 0;
+        if (rec) {
+            if (rec->rec.payload.size) {
+                size = rec->rec.payload.bytes[0] & 0x3f;
+            }
+            ndef_rec_unref(&rec->rec);
+        }
+        locale = name;
+    }
+    return size;
+}
+
+//static
+uint
+NfcShare::Private::encodedSize(
+    const QString& aText,
+    uint aLimit)
+{
+    // Prefixes abbreviated by the URI record, the longest first
+    static const char* const uriPrefixes[] = {
+        "https://www.", "http://www.", "https://", "http://"
+    };
+
+    // Must agree with encode() without doing any of its work. UTF-8
+    // bytes are counted straight from UTF-16 and counting stops once
+    // the limit is exceeded, the result is then a lower bound which
+    // is still over the limit.
+    uint prefixLen = 0;
+    for (uint i = 0; i < sizeof(uriPrefixes)/sizeof(uriPrefixes[0]); i++) {
+        const QLatin1String prefix(uriPrefixes[i]);
+
+        if (aText.startsWith(prefix)) {
+            prefixLen = prefix.size();
+            break;
+        }
+    }
+
+    // URI payload starts with the prefix code, Text payload with the
+    // status byte followed by the language code. Either way the type
+    // is a single character, "U" or "T".
+    const uint langLen = textLangSize();
+    const uint fixedLen = 1 + (prefixLen ? 0 : langLen);
+    const ushort* chars = aText.utf16();
+    const int n = aText.length();
+    uint bytes = 0;
+
+    for (int i = prefixLen; i < n && fixedLen + bytes <= aLimit; i++) {
+        const ushort c = chars[i];
+
+        if (c < 0x80) {
+            bytes += 1;
+        } else if (c < 0x800) {
+            bytes += 2;
+        } else if (QChar::isHighSurrogate(c) && (i + 1) < n &&
+            QChar::isLowSurrogate(chars[i + 1])) {
+            bytes += 4;
+            i++;
+        } else if (QChar::isSurrogate(c)) {
+            // Unpaired, QString::toUtf8() replaces it with '?'
+            bytes += 1;
+        } else {
+            bytes += 3;
+        }
+    }
+
+    uint size = NdefRecord::encodedSize(1, fixedLen + bytes);
+
+    if (prefixLen && size <= aLimit && !QUrl(aText).isValid()) {
+        // Not a URI after all (prefix is ASCII, one byte per char)
+        size = NdefRecord::encodedSize(1, 1 + langLen + prefixLen + bytes);
+    }
+    return size;
+}
+
+QByteArray
+NfcShare::Private::generate()
+{
+    // Invoked by NdefApp while no reader is around, except when
+    // the pool runs dry. Each text is unique, don't cache it.
+    const QString text(iGenerator ? iGenerator->generateText() : QString());
+    QByteArray ndef;
+
+    if (!text.isEmpty()) {
+        ndef = encode(text);
+        if (iCompress && !ndef.isEmpty()) {
+            const QByteArray compressed(NdefRecord::compress(ndef));
+
+            if (!compressed.isEmpty()) {
+                ndef = compressed;
+            }
+        }
+    }
+    return ndef;
+}
+
+// ==========================================================================
+// NfcShare
+// ==========================================================================
+
+NfcShare::NfcShare(
+    QObject* aParent) :
+    QObject(aParent),
+    iPrivate(new Private)
+{}
+
+NfcShare::~NfcShare()
+{
+    if (iPrivate->iHandover && iPrivate->iBearer) {
+        iPrivate->iBearer->withdraw();
+    }
+    delete iPrivate;
+}
+
+//static
+uint
+NfcShare::encodedSize(
+    const QString& aText)
+{
+    return Private::encodedSize(aText, NdefApp::maxMessageSize());
+}
+
+//static
+QByteArray
+NfcShare::encode(
+    const QString& aText)
+{
+    return Private::encode(aText);
+}
+
+QString
+NfcShare::getText() const
+{
+    return iPrivate->iText;
+}
+
+void
+NfcShare::setText(
+    QString aText)
+{
+    if (iPrivate->iText != aText) {
+        iPrivate->iText = aText;
+        updateApp();
+        Q_EMIT textChanged();
+    }
+}
+
+NfcShareBearer*
+NfcShare::getBearer() const
+{
+    return iPrivate->iBearer.data();
+}
+
+void
+NfcShare::setBearer(
+    NfcShareBearer* aBearer)
+{
+    NfcShareBearer* prev = iPrivate->iBearer.data();
+
+    if (prev != aBearer) {
+        if (prev) {
+            if (iPrivate->iHandover) {
+                prev->withdraw();
+            }
+            prev->disconnect(this);
+        }
+        iPrivate->iBearer = aBearer;
+        if (aBearer) {
+            connect(aBearer, SIGNAL(validChanged()), SLOT(onBearerChanged()));
+            connect(aBearer, SIGNAL(carrierTypeChanged()), SLOT(onBearerChanged()));
+            connect(aBearer, SIGNAL(carrierDataChanged()), SLOT(onBearerChanged()));
+            connect(aBearer, SIGNAL(uriChanged()), SLOT(onBearerChanged()));
+            connect(aBearer, SIGNAL(powerStateChanged()), SLOT(onBearerChanged()));
+        }
+        onBearerChanged();
+        Q_EMIT bearerChanged();
+    }
+}
+
+bool
+NfcShare::isHandover() const
+{
+    return iPrivate->iHandover;
+}
+
+NfcShare::Transport
+NfcShare::getTransport() const
+{
+    return iPrivate->iTransport;
+}
+
+void
+NfcShare::setTransport(
+    Transport aTransport)
+{
+    if (iPrivate->iTransport != aTransport) {
+        iPrivate->iTransport = aTransport;
+        updateApp();
+        Q_EMIT transportChanged();
+    }
+}
+
+bool
+NfcShare::getCompress() const
+{
+    return iPrivate->iCompress;
+}
+
+void
+NfcShare::setCompress(
+    bool aCompress)
+{
+    if (iPrivate->iCompress != aCompress) {
+        iPrivate->iCompress = aCompress;
+        updateApp();
+        Q_EMIT compressChanged();
+    }
+}
+
+NdefMetrics*
+NfcShare::getMetrics() const
+{
+    return iPrivate->iApp ? iPrivate->iApp->getMetrics() : Q_NULLPTR;
+}
+
+void
+NfcShare::onBearerChanged()
+{
+    // The bearer only matters if the content doesn't fit into the tag
+    if (iPrivate->iHandover || isTooMuchData()) {
+        updateApp();
+    }
+}
+
+void
+NfcShare::updateApp()
+{
+    const QString text(iPrivate->iText);
+    NfcShareBearer* bearer = iPrivate->iBearer.data();
+    const bool wasTooMuchData = isTooMuchData();
+    const bool wasReady = isReady();
+    const bool wasDone = isDone();
+    const bool wasHandover = isHandover();
+    uint prevBytesTotal = getBytesTotal();
+    const uint prevBytesTransferred = getBytesTransferred();
+    const NdefMetrics* prevMetrics = getMetrics();
+    const LeaseState prevLeaseState = getLeaseState();
+    const NdefApp::Transport transport =
+        (iPrivate->iTransport == SnepPush) ? NdefApp::TransportSnep :
+        (iPrivate->iTransport == AutoTransport) ? NdefApp::TransportAuto :
+        NdefApp::TransportType4;
+
+    delete iPrivate->iApp;
+    iPrivate->iApp = Q_NULLPTR;
+    if (iPrivate->iHandover) {
+        iPrivate->iHandover = false;
+        if (bearer) {
+            bearer->withdraw();
+        }
+    }
+
+    DBG(text);
+    if (iPrivate->iGenerator) {
+        // The generator takes precedence over the text and there's
+        // no handover, each message has to fit into the tag
+        const NfcShareGenerator* generator = iPrivate->iGenerator.data();
+
+        DBG("Generating up to" << generator->getPoolSize() << "messages");
+        iPrivate->iApp = new NdefApp(iPrivate, generator->getPoolSize(),
+            transport, this, iPrivate->iReceiveSize);
+        connect(iPrivate->iApp, SIGNAL(readyChanged()), SIGNAL(readyChanged()));
+        connect(iPrivate->iApp, SIGNAL(doneChanged()), SIGNAL(doneChanged()));
+        connect(iPrivate->iApp, SIGNAL(bytesTransferredChanged()), SIGNAL(bytesTransferredChanged()));
+        connect(iPrivate->iApp, SIGNAL(leaseStateChanged()), SIGNAL(leaseStateChanged()));
+        connect(iPrivate->iApp, SIGNAL(delivered()), SIGNAL(delivered()));
+        connect(iPrivate->iApp, SIGNAL(received(QByteArray)), SIGNAL(received(QByteArray)));
+        // SNEP push (and the idle timeout) still end the whole thing
+        connect(iPrivate->iApp, SIGNAL(done()), SIGNAL(done()));
+        iPrivate->iApp->setIdleTimeout(iPrivate->iIdleTimeout);
+        iPrivate->iApp->setTechs(iPrivate->iTechs);
+    } else if (!text.isEmpty()) {
+        QElapsedTimer timer;
+
+        // Re-sharing the same text doesn't need to encode it again
+        timer.start();
+        const QByteArray key(Private::cacheKey(text));
+        QByteArray ndef(NdefCache::lookup(key));
+        const bool cached = !ndef.isEmpty();
+        const uint maxSize = NdefApp::maxMessageSize();
+        uint size = ndef.size();
+
+        // Compression may squeeze the message into the tag, otherwise
+        // there's no point in encoding what's known not to fit
+        if (!cached && !iPrivate->iCompress) {
+            size = Private::encodedSize(text, maxSize);
+            TRACE("encode.estimate chars=%d ndef=%u estimate_us=%lld",
+                text.length(), size, timer.nsecsElapsed() / 1000);
+            if (size <= maxSize && size != prevBytesTotal) {
+                // The size is already known, no need to wait
+                iPrivate->iBytesEstimate = prevBytesTotal = size;
+                Q_EMIT bytesTotalChanged();
+            }
+        }
+
+        if (size > maxSize && !cached && !iPrivate->iCompress) {
+            DBG("Not encoding at least" << size << "bytes");
+        } else if (!cached) {
+            ndef = Private::encode(text);
+            NdefCache::insert(key, ndef);
+            size = ndef.size();
+        }
+
+        // Only our own readers can unpack it, hence opt-in. The cache
+        // keeps the plain message.
+        if (iPrivate->iCompress) {
+            const QByteArray compressed(NdefRecord::compress(ndef));
+
+            TRACE("encode.compress ndef=%d compressed=%d", ndef.size(),
+                compressed.size());
+            if (!compressed.isEmpty()) {
+                ndef = compressed;
+            }
+            size = ndef.size();
+        }
+
+        const qint64 encodeNs = timer.nsecsElapsed();
+
+        if (size) {
+            if (size > maxSize && bearer && bearer->isValid()) {
+                // Too large for the tag, carry a Handover Select
+                // message instead and let the bearer move the bulk
+                const QByteArray hs(bearer->handoverSelect());
+
+                DBG("Handing over" << size << "bytes");
+                iPrivate->iApp = new NdefApp(hs.constData(), hs.size(),
+                    transport, this, iPrivate->iReceiveSize);
+                iPrivate->iHandover = true;
+                bearer->offer(text);
+            } else {
+                // The message is not needed if it's too large
+                iPrivate->iApp = new NdefApp(ndef.isEmpty() ? Q_NULLPTR :
+                    ndef.constData(), size, transport, this,
+                    iPrivate->iReceiveSize);
+            }
+            connect(iPrivate->iApp, SIGNAL(readyChanged()), SIGNAL(readyChanged()));
+            connect(iPrivate->iApp, SIGNAL(doneChanged()), SIGNAL(doneChanged()));
+            connect(iPrivate->iApp, SIGNAL(bytesTransferredChanged()), SIGNAL(bytesTransferredChanged()));
+            connect(iPrivate->iApp, SIGNAL(leaseStateChanged()), SIGNAL(leaseStateChanged()));
+            connect(iPrivate->iApp, SIGNAL(received(QByteArray)), SIGNAL(received(QByteArray)));
+            connect(iPrivate->iApp, SIGNAL(done()), SIGNAL(done()));
+            iPrivate->iApp->setIdleTimeout(iPrivate->iIdleTimeout);
+            iPrivate->iApp->setTechs(iPrivate->iTechs);
+            TRACE("encode chars=%d ndef=%u cached=%d encode_us=%lld "
+                "app_us=%lld", text.length(), size, cached,
+                encodeNs / 1000, (timer.nsecsElapsed() - encodeNs) / 1000);
+        }
+        iPrivate->iBytesEstimate = 0;
+    }
+
+    if (wasTooMuchData != isTooMuchData()) {
+        Q_EMIT tooMuchDataChanged();
+    }
+    if (wasReady != isReady()) {
+        Q_EMIT readyChanged();
+    }
+    if (wasDone != isDone()) {
+        Q_EMIT doneChanged();
+    }
+    if (wasHandover != isHandover()) {
+        Q_EMIT handoverChanged();
+    }
+    if (prevBytesTotal != getBytesTotal()) {
+        Q_EMIT bytesTotalChanged();
+    }
+    if (prevBytesTransferred != getBytesTransferred()) {
+        Q_EMIT bytesTransferredChanged();
+    }
+    if (prevMetrics || getMetrics()) {
+        // The old metrics object (if any) is gone anyway
+        Q_EMIT metricsChanged();
+    }
+    if (prevLeaseState != getLeaseState()) {
+        Q_EMIT leaseStateChanged();
+    }
+}
+
+bool
+NfcShare::isTooMuchData() const
+{
+    return iPrivate->iApp && iPrivate->iApp->isTooMuchData();
+}
+
+bool
+NfcShare::isReady() const
+{
+    return iPrivate->iApp && iPrivate->iApp->isReady();
+}
+
+bool
+NfcShare::isDone() const
+{
+    return iPrivate->iApp && iPrivate->iApp->isDone();
+}
+
+uint
+NfcShare::getBytesTotal() const
+{
+    return iPrivate->iApp ? iPrivate->iApp->getBytesTotal() :
+        iPrivate->iBytesEstimate;
+}
+
+uint
+NfcShare::getBytesTransferred() const
+{
+    return iPrivate->iApp ? iPrivate->iApp->getBytesTransferred() : 0;
+}
+
+NfcShare::LeaseState
+NfcShare::getLeaseState() const
+{
+    return iPrivate->iApp ? (LeaseState)iPrivate->iApp->getLeaseState() :
+        LeaseNone;
+}
+
+int
+NfcShare::getIdleTimeout() const
+{
+    return iPrivate->iIdleTimeout;
+}
+
+void
+NfcShare::setIdleTimeout(
+    int aMsec)
+{
+    // Milliseconds, zero (or negative) to hold the lease until done
+    const int timeout = qMax(aMsec, 0);
+
+    if (iPrivate->iIdleTimeout != timeout) {
+        iPrivate->iIdleTimeout = timeout;
+        if (iPrivate->iApp) {
+            iPrivate->iApp->setIdleTimeout(timeout);
+        }
+        Q_EMIT idleTimeoutChanged();
+    }
+}
+
+int
+NfcShare::getTechs() const
+{
+    return iPrivate->iTechs;
+}
+
+void
+NfcShare::setTechs(
+    int aTechs)
+{
+    // Ignore values which have no supported technology in them
+    const int techs = aTechs & TechAB;
+
+    if (techs && iPrivate->iTechs != techs) {
+        iPrivate->iTechs = techs;
+        if (iPrivate->iApp) {
+            iPrivate->iApp->setTechs(techs);
+        }
+        Q_EMIT techsChanged();
+    }
+}
+
+NfcShareGenerator*
+NfcShare::getGenerator() const
+{
+    return iPrivate->iGenerator.data();
+}
+
+void
+NfcShare::setGenerator(
+    NfcShareGenerator* aGenerator)
+{
+    NfcShareGenerator* prev = iPrivate->iGenerator.data();
+
+    if (prev != aGenerator) {
+        if (prev) {
+            prev->disconnect(this);
+        }
+        iPrivate->iGenerator = aGenerator;
+        if (aGenerator) {
+            // The pool size is fixed when NdefApp gets created
+            connect(aGenerator, SIGNAL(poolSizeChanged()), SLOT(onGeneratorChanged()));
+            connect(aGenerator, SIGNAL(destroyed(QObject*)), SLOT(onGeneratorChanged()));
+        }
+        updateApp();
+        Q_EMIT generatorChanged();
+    }
+}
+
+int
+NfcShare::getReceiveSize() const
+{
+    return iPrivate->iReceiveSize;
+}
+
+void
+NfcShare::setReceiveSize(
+    int aSize)
+{
+    // Zero (the default) keeps the tag read-only
+    const uint size = qMin(uint(qMax(aSize, 0)), NdefApp::maxReceiveSize());
+
+    if (iPrivate->iReceiveSize != size) {
+        iPrivate->iReceiveSize = size;
+        updateApp();
+        Q_EMIT receiveSizeChanged();
+    }
+}
+
+void
+NfcShare::onGeneratorChanged()
+{
+    updateApp();
+    if (!iPrivate->iGenerator) {
+        // The generator has been destroyed
+        Q_EMIT generatorChanged();
+    }
+}
+
+void
+NfcShare::reacquire()
+{
+    // Mode and techs are released when the transfer is done, this
+    // brings them back if the user wants to share again
+    if (iPrivate->iApp) {
+        iPrivate->iApp->reacquire();
+    }
+}
+
+qreal
+NfcShare::getTransferRate() const
+{
+    return iPrivate->iApp ? iPrivate->iApp->getTransferRate() : 0;
+}
+
+qreal
+NfcShare::getEstimatedTimeRemaining() const
+{
+    return iPrivate->iApp ? iPrivate->iApp->getEstimatedTimeRemaining() : -1;
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcsharebearer.h"
+#include "ndefrecord.h"
+#include "nfcsharelog.h"
+
+#define DBG(x) qCDebug(nfcshareShare) << x
+
+// ==========================================================================
+//
+// [NFCForum-TS-ConnectionHandover_1.2]
+//
+// Handover Select Record (type "Hs"):
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 1    | Version (major/minor 4 bits each)                      |
+// | 1      | -    | NDEF message with Alternative Carrier records          |
+// +------------------------------------------------------------------------+
+//
+// Alternative Carrier Record (type "ac"):
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 1    | Carrier Power State (2 bits)                           |
+// | 1      | 1    | Carrier Data Reference length (N)                      |
+// | 2      | N    | Carrier Data Reference (ID of the carrier record)      |
+// | 2+N    | 1    | Auxiliary Data Reference count (0)                     |
+// +------------------------------------------------------------------------+
+//
+// The Handover Select record is followed by the carrier configuration
+// record identified by the Carrier Data Reference.
+//
+// ==========================================================================
+
+#define HANDOVER_VERSION (0x12)
+#define HANDOVER_CPS_MASK (0x03)
+
+static const char HANDOVER_SELECT_TYPE[] = "Hs";
+static const char ALTERNATIVE_CARRIER_TYPE[] = "ac";
+static const char URI_TYPE[] = "U";
+static const char CARRIER_ID[] = "0";
+
+NfcShareBearer::NfcShareBearer(
+    QObject* aParent) :
+    QObject(aParent),
+    iPowerState(Active),
+    iOffered(false)
+{}
+
+QString
+NfcShareBearer::carrierType() const
+{
+    return iCarrierType;
+}
+
+void
+NfcShareBearer::setCarrierType(
+    QString aType)
+{
+    if (iCarrierType != aType) {
+        const bool wasValid = isValid();
+
+        iCarrierType = aType;
+        Q_EMIT carrierTypeChanged();
+        if (wasValid != isValid()) {
+            Q_EMIT validChanged();
+        }
+    }
+}
+
+QByteArray
+NfcShareBearer::carrierData() const
+{
+    return iCarrierData;
+}
+
+void
+NfcShareBearer::setCarrierData(
+    QByteArray aData)
+{
+    if (iCarrierData != aData) {
+        iCarrierData = aData;
+        Q_EMIT carrierDataChanged();
+    }
+}
+
+QString
+NfcShareBearer::uri() const
+{
+    return iUri;
+}
+
+void
+NfcShareBearer::setUri(
+    QString aUri)
+{
+    if (iUri != aUri) {
+        const bool wasValid = isValid();
+
+        iUri = aUri;
+        Q_EMIT uriChanged();
+        if (wasValid != isValid()) {
+            Q_EMIT validChanged();
+        }
+    }
+}
+
+NfcShareBearer::PowerState
+NfcShareBearer::powerState() const
+{
+    return iPowerState;
+}
+
+void
+NfcShareBearer::setPowerState(
+    PowerState aPowerState)
+{
+    if (iPowerState != aPowerState) {
+        iPowerState = aPowerState;
+        Q_EMIT powerStateChanged();
+    }
+}
+
+bool
+NfcShareBearer::isValid() const
+{
+    // Either the carrier type (MIME type of the carrier configuration
+    // record) or the URI of the local endpoint must be set
+    return !iCarrierType.isEmpty() || !iUri.isEmpty();
+}
+
+QByteArray
+NfcShareBearer::handoverSelect() const
+{
+    QByteArray msg;
+
+    if (isValid()) {
+        const QByteArray id(CARRIER_ID);
+        QByteArray ac, hs, carrier;
+
+        // Alternative Carrier record
+        ac.append((char)(iPowerState & HANDOVER_CPS_MASK));
+        ac.append((char)(uchar)id.size());
+        ac.append(id);
+        ac.append((char)0); // No auxiliary data
+
+        // Handover Select record
+        hs.append((char)HANDOVER_VERSION);
+        hs.append(NdefRecord::encode(NdefRecord::TnfWellKnown,
+            QByteArray(ALTERNATIVE_CARRIER_TYPE), ac));
+
+        // Carrier configuration record
+        if (!iCarrierType.isEmpty()) {
+            carrier = NdefRecord::encode(NdefRecord::TnfMediaType,
+                iCarrierType.toLatin1(), iCarrierData, id,
+                NdefRecord::FlagMessageEnd);
+        } else {
+            // Well-known URI record with no abbreviation (0x00)
+            carrier = NdefRecord::encode(NdefRecord::TnfWellKnown,
+                QByteArray(URI_TYPE), QByteArray(1, 0) + iUri.toUtf8(), id,
+                NdefRecord::FlagMessageEnd);
+        }
+
+        msg = NdefRecord::encode(NdefRecord::TnfWellKnown,
+            QByteArray(HANDOVER_SELECT_TYPE), hs, QByteArray(),
+            NdefRecord::FlagMessageBegin);
+        msg.append(carrier);
+    }
+    return msg;
+}
+
+void
+NfcShareBearer::offer(
+    const QString& aText)
+{
+    DBG("Offering" << aText.size() << "characters");
+    iOffered = true;
+    Q_EMIT contentOffered(aText);
+}
+
+void
+NfcShareBearer::withdraw()
+{
+    if (iOffered) {
+        DBG("Withdrawing the content");
+        iOffered = false;
+        Q_EMIT contentWithdrawn();
+    }
+}
@@ -0,0 +1,501 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcshareservice.h"
+#include "ndefapp.h"
+#include "nfcshare.h"
+#include "nfcsharelog.h"
+
+#include <QtCore/QMap>
+#include <QtDBus/QDBusAbstractAdaptor>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusObjectPath>
+#include <QtDBus/QDBusServiceWatcher>
+#include <QtDBus/QDBusUnixFileDescriptor>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DBG(x) qCDebug(nfcshareShare) << x
+#define WARN(x) qCWarning(nfcshareShare) << x
+
+// Publish flags
+#define PUBLISH_TEXT (0x01)     // UTF-8 text rather than NDEF message
+#define PUBLISH_SNEP (0x02)     // SNEP push only
+#define PUBLISH_AUTO (0x04)     // Type 4 tag and SNEP push
+
+// Anything larger won't fit into the tag anyway (text gets encoded
+// into a slightly larger NDEF message)
+#define MAX_PAYLOAD_SIZE (0x10000)
+
+// The payload must not change while it's being shared
+#define REQUIRED_SEALS (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE)
+
+#define ERROR_INVALID_ARGS "org.sailfishos.nfcshare.Error.InvalidArgs"
+#define ERROR_ACCESS_DENIED "org.sailfishos.nfcshare.Error.AccessDenied"
+
+const QString NfcShareService::SERVICE("org.sailfishos.nfcshare");
+
+// ==========================================================================
+// NfcShareService::Handle
+// ==========================================================================
+
+class NfcShareService::Handle :
+    public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfcshare.Share")
+
+public:
+    Handle(QDBusConnection, const QString&, const QString&,
+        const QByteArray&, uint);
+    ~Handle();
+
+    bool isValid() const;
+    void start();
+    const QString& path() const;
+    const QString& owner() const;
+
+public Q_SLOTS:
+    uint GetBytesTotal();
+    uint GetBytesTransferred();
+    bool IsReady();
+    bool IsDone();
+    void Withdraw(const QDBusMessage&);
+
+Q_SIGNALS:
+    void Ready();
+    void Progress(uint, uint);
+    void Done();
+    void Withdrawn();
+
+private Q_SLOTS:
+    void onReadyChanged();
+    void onBytesTransferredChanged();
+
+private:
+    QDBusConnection iBus;
+    const QString iPath;
+    const QString iOwner;
+    const QByteArray iPayload;
+    const uint iFlags;
+    QString iString;    // Decoded iPayload, if it's text
+    bool iValid;
+    NfcShare* iText;
+    NdefApp* iNdef;
+};
+
+NfcShareService::Handle::Handle(
+    QDBusConnection aBus,
+    const QString& aPath,
+    const QString& aOwner,
+    const QByteArray& aPayload,
+    uint aFlags) :
+    iBus(aBus),
+    iPath(aPath),
+    iOwner(aOwner),
+    iPayload(aPayload),
+    iFlags(aFlags),
+    iValid(false),
+    iText(Q_NULLPTR),
+    iNdef(Q_NULLPTR)
+{
+    // Nothing gets registered with nfcd until start(), the previous
+    // share (if any) has to be gone by then
+    if (aFlags & PUBLISH_TEXT) {
+        iString = QString::fromUtf8(aPayload);
+        iValid = NfcShare::encodedSize(iString) <= NdefApp::maxMessageSize();
+    } else {
+        iValid = (uint)aPayload.size() <= NdefApp::maxMessageSize();
+    }
+}
+
+NfcShareService::Handle::~Handle()
+{
+    if (iText || iNdef) {
+        iBus.unregisterObject(iPath);
+    }
+}
+
+bool
+NfcShareService::Handle::isValid() const
+{
+    return iValid;
+}
+
+void
+NfcShareService::Handle::start()
+{
+    QObject* share;
+
+    if (iFlags & PUBLISH_TEXT) {
+        iText = new NfcShare(this);
+        iText->setTransport((iFlags & PUBLISH_SNEP) ? NfcShare::SnepPush :
+            (iFlags & PUBLISH_AUTO) ? NfcShare::AutoTransport :
+            NfcShare::Type4Tag);
+        iText->setText(iString);
+        share = iText;
+    } else {
+        iNdef = new NdefApp(iPayload.constData(), iPayload.size(),
+            (iFlags & PUBLISH_SNEP) ? NdefApp::TransportSnep :
+            (iFlags & PUBLISH_AUTO) ? NdefApp::TransportAuto :
+            NdefApp::TransportType4, this);
+        share = iNdef;
+    }
+    connect(share, SIGNAL(readyChanged()), SLOT(onReadyChanged()));
+    connect(share, SIGNAL(bytesTransferredChanged()),
+        SLOT(onBytesTransferredChanged()));
+    connect(share, SIGNAL(done()), SIGNAL(Done()));
+    iBus.registerObject(iPath, this, QDBusConnection::ExportAllSlots |
+        QDBusConnection::ExportAllSignals);
+}
+
+const QString&
+NfcShareService::Handle::path() const
+{
+    return iPath;
+}
+
+const QString&
+NfcShareService::Handle::owner() const
+{
+    return iOwner;
+}
+
+uint
+NfcShareService::Handle::GetBytesTotal()
+{
+    return iText ? iText->getBytesTotal() : iNdef ? iNdef->getBytesTotal() :
+        (uint)iPayload.size();
+}
+
+uint
+NfcShareService::Handle::GetBytesTransferred()
+{
+    return iText ? iText->getBytesTransferred() :
+        iNdef ? iNdef->getBytesTransferred() : 0;
+}
+
+bool
+NfcShareService::Handle::IsReady()
+{
+    return iText ? iText->isReady() : iNdef && iNdef->isReady();
+}
+
+bool
+NfcShareService::Handle::IsDone()
+{
+    return iText ? iText->isDone() : iNdef && iNdef->isDone();
+}
+
+void
+NfcShareService::Handle::Withdraw(
+    const QDBusMessage& aMessage)
+{
+    if (aMessage.service() == iOwner) {
+        DBG("Withdrawing" << iPath);
+        Q_EMIT Withdrawn();
+    } else {
+        aMessage.setDelayedReply(true);
+        iBus.send(aMessage.createErrorReply(ERROR_ACCESS_DENIED,
+            "Only the publisher can withdraw the share"));
+    }
+}
+
+void
+NfcShareService::Handle::onReadyChanged()
+{
+    if (IsReady()) {
+        Q_EMIT Ready();
+    }
+}
+
+void
+NfcShareService::Handle::onBytesTransferredChanged()
+{
+    Q_EMIT Progress(GetBytesTransferred(), GetBytesTotal());
+}
+
+// ==========================================================================
+// NfcShareService::Private
+// ==========================================================================
+
+class NfcShareService::Private :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfcshare")
+    Q_CLASSINFO("D-Bus Introspection",
+        "<interface name=\"org.sailfishos.nfcshare\">\n"
+        "  <method name=\"Publish\">\n"
+        "    <arg name=\"fd\" type=\"h\" direction=\"in\"/>\n"
+        "    <arg name=\"flags\" type=\"u\" direction=\"in\"/>\n"
+        "    <arg name=\"share\" type=\"o\" direction=\"out\"/>\n"
+        "  </method>\n"
+        "  <method name=\"PublishData\">\n"
+        "    <arg name=\"data\" type=\"ay\" direction=\"in\"/>\n"
+        "    <arg name=\"flags\" type=\"u\" direction=\"in\"/>\n"
+        "    <arg name=\"share\" type=\"o\" direction=\"out\"/>\n"
+        "  </method>\n"
+        "</interface>\n")
+
+    static const QString SERVICE_PATH;
+
+public:
+    Private(QDBusConnection, NfcShareService*);
+    ~Private();
+
+public Q_SLOTS:
+    QDBusObjectPath Publish(QDBusUnixFileDescriptor, uint, const QDBusMessage&);
+    QDBusObjectPath PublishData(QByteArray, uint, const QDBusMessage&);
+
+private Q_SLOTS:
+    void onServiceUnregistered(const QString&);
+    void onWithdrawn();
+
+private:
+    static bool readMemfd(int, QByteArray*);
+    QDBusObjectPath publish(const QByteArray&, uint, const QDBusMessage&);
+    QDBusObjectPath invalidArgs(const QDBusMessage&, const QString&);
+    void dropHandle();
+
+public:
+    QDBusConnection iBus;
+    QDBusServiceWatcher* iWatcher;
+    Handle* iHandle;
+    uint iLastId;
+    bool iRegistered;
+};
+
+const QString NfcShareService::Private::SERVICE_PATH("/");
+
+NfcShareService::Private::Private(
+    QDBusConnection aBus,
+    NfcShareService* aService) :
+    QDBusAbstractAdaptor(aService),
+    iBus(aBus),
+    iWatcher(new QDBusServiceWatcher(QString(), aBus,
+        QDBusServiceWatcher::WatchForUnregistration, this)),
+    iHandle(Q_NULLPTR),
+    iLastId(0),
+    iRegistered(false)
+{
+    connect(iWatcher, SIGNAL(serviceUnregistered(QString)),
+        SLOT(onServiceUnregistered(QString)));
+    if (iBus.registerObject(SERVICE_PATH, aService)) {
+        iRegistered = iBus.registerService(SERVICE);
+        if (!iRegistered) {
+            WARN("Failed to register" << SERVICE);
+        }
+    }
+}
+
+NfcShareService::Private::~Private()
+{
+    dropHandle();
+    if (iRegistered) {
+        iBus.unregisterService(SERVICE);
+    }
+    iBus.unregisterObject(SERVICE_PATH);
+}
+
+//static
+bool
+NfcShareService::Private::readMemfd(
+    int aFd,
+    QByteArray* aData)
+{
+    struct stat st;
+    const int seals = fcntl(aFd, F_GET_SEALS);
+
+    if ((seals & REQUIRED_SEALS) == REQUIRED_SEALS &&
+        fstat(aFd, &st) == 0 && st.st_size > 0 &&
+        st.st_size <= MAX_PAYLOAD_SIZE) {
+        // The mapping only lives until the payload is copied into
+        // the tag files, nothing goes through the bus daemon
+        void* map = mmap(Q_NULLPTR, st.st_size, PROT_READ, MAP_PRIVATE,
+            aFd, 0);
+
+        if (map != MAP_FAILED) {
+            *aData = QByteArray((const char*)map, st.st_size);
+            munmap(map, st.st_size);
+            return true;
+        }
+    }
+    return false;
+}
+
+QDBusObjectPath
+NfcShareService::Private::invalidArgs(
+    const QDBusMessage& aMessage,
+    const QString& aError)
+{
+    aMessage.setDelayedReply(true);
+    iBus.send(aMessage.createErrorReply(ERROR_INVALID_ARGS, aError));
+    return QDBusObjectPath();
+}
+
+void
+NfcShareService::Private::dropHandle()
+{
+    if (iHandle) {
+        iWatcher->removeWatchedService(iHandle->owner());
+        delete iHandle;
+        iHandle = Q_NULLPTR;
+    }
+}
+
+QDBusObjectPath
+NfcShareService::Private::publish(
+    const QByteArray& aPayload,
+    uint aFlags,
+    const QDBusMessage& aMessage)
+{
+    const QString owner(aMessage.service());
+
+    // There's only one emulated tag. Same as with Withdraw, only the
+    // owner of the current share can replace it, everyone else has to
+    // wait until it's withdrawn (or the owner leaves the bus).
+    if (iHandle && iHandle->owner() != owner) {
+        aMessage.setDelayedReply(true);
+        iBus.send(aMessage.createErrorReply(ERROR_ACCESS_DENIED,
+            "Another share is active"));
+        return QDBusObjectPath();
+    }
+
+    // Check the new one first, a bad payload leaves the old one alone
+    Handle* handle = new Handle(iBus, QString("/share/%1").arg(iLastId + 1),
+        owner, aPayload, aFlags);
+
+    if (!handle->isValid()) {
+        delete handle;
+        return invalidArgs(aMessage, "Too much data");
+    }
+
+    // The old one has to be gone before the new one registers
+    if (iHandle) {
+        iHandle->disconnect(this);
+        Q_EMIT iHandle->Withdrawn();
+        dropHandle();
+    }
+
+    iLastId++;
+    iHandle = handle;
+    iHandle->start();
+    DBG(owner << "published" << aPayload.size() << "bytes at" <<
+        iHandle->path());
+    connect(iHandle, SIGNAL(Withdrawn()), SLOT(onWithdrawn()));
+    iWatcher->addWatchedService(owner);
+    return QDBusObjectPath(iHandle->path());
+}
+
+// org.sailfishos.nfcshare implementation
+
+QDBusObjectPath
+NfcShareService::Private::Publish(
+    QDBusUnixFileDescriptor aFd,
+    uint aFlags,
+    const QDBusMessage& aMessage)
+{
+    QByteArray payload;
+
+    if (aFd.isValid() && readMemfd(aFd.fileDescriptor(), &payload)) {
+        return publish(payload, aFlags, aMessage);
+    } else {
+        return invalidArgs(aMessage, "Expecting a sealed memfd");
+    }
+}
+
+QDBusObjectPath
+NfcShareService::Private::PublishData(
+    QByteArray aData,
+    uint aFlags,
+    const QDBusMessage& aMessage)
+{
+    if (!aData.isEmpty() && aData.size() <= MAX_PAYLOAD_SIZE) {
+        return publish(aData, aFlags, aMessage);
+    } else {
+        return invalidArgs(aMessage, "Invalid payload size");
+    }
+}
+
+void
+NfcShareService::Private::onServiceUnregistered(
+    const QString& aService)
+{
+    if (iHandle && iHandle->owner() == aService) {
+        DBG(aService << "has left, withdrawing" << iHandle->path());
+        dropHandle();
+    }
+}
+
+void
+NfcShareService::Private::onWithdrawn()
+{
+    if (iHandle && iHandle == sender()) {
+        // Called from the handle's signal, can't delete it right away
+        iWatcher->removeWatchedService(iHandle->owner());
+        iHandle->deleteLater();
+        iHandle = Q_NULLPTR;
+    }
+}
+
+// ==========================================================================
+// NfcShareService
+// ==========================================================================
+
+NfcShareService::NfcShareService(
+    QDBusConnection aBus,
+    QObject* aParent) :
+    QObject(aParent),
+    iPrivate(new Private(aBus, this))
+{}
+
+NfcShareService::~NfcShareService()
+{
+    delete iPrivate;
+}
+
+bool
+NfcShareService::isRegistered() const
+{
+    return iPrivate->iRegistered;
+}
+
+#include "nfcshareservice.moc"
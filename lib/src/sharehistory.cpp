@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "sharehistory.h"
+#include "nfcsharelog.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QList>
+
+#define WARN(x) qCWarning(nfcshareApp) << x
+
+// Record format (tab separated, one record per line):
+//
+// 1. Format version (2)
+// 2. Timestamp, seconds since the epoch
+// 3. NDEF message size
+// 4. TNF:type of the first NDEF record
+// 5. Transport (tag, static, snep, auto)
+// 6. Reader (nfcd host path, - if unknown)
+// 7. Time to ready, ms
+// 8. Time to first APDU, ms
+// 9. Transfer time (first APDU to done), ms
+// 10. Retries
+// 11. Resets
+// 12. Outcome
+// 13. Technology of the last reader session (a, b, f) since version 2
+//
+// Times which haven't been reached are written as -
+
+#define HISTORY_VERSION "2"
+#define HISTORY_FIELDS (13)
+#define HISTORY_VERSION_1 "1"
+#define HISTORY_FIELDS_1 (12)
+#define HISTORY_SEPARATOR '\t'
+#define HISTORY_NONE "-"
+
+// NDEF record header flags
+#define NDEF_SR (0x10)
+#define NDEF_IL (0x08)
+#define NDEF_TNF_MASK (0x07)
+
+// ==========================================================================
+// ShareHistory::Record
+// ==========================================================================
+
+ShareHistory::Record::Record() :
+    iTimestamp(0),
+    iBytes(0),
+    iReadyMs(-1),
+    iFirstApduMs(-1),
+    iTransferMs(-1),
+    iRetries(0),
+    iResets(0)
+{}
+
+static
+QByteArray
+timeField(
+    qreal aMs)
+{
+    return (aMs < 0) ? QByteArray(HISTORY_NONE) :
+        QByteArray::number(aMs, 'f', 1);
+}
+
+static
+qreal
+parseTime(
+    const QByteArray& aField)
+{
+    bool ok = false;
+    const qreal ms = aField.toDouble(&ok);
+
+    return ok ? ms : -1;
+}
+
+static
+QByteArray
+textField(
+    const QByteArray& aText)
+{
+    // Separators would break the record
+    QByteArray field(aText);
+
+    field.replace(HISTORY_SEPARATOR, ' ').replace('\n', ' ');
+    return field.isEmpty() ? QByteArray(HISTORY_NONE) : field;
+}
+
+QByteArray
+ShareHistory::Record::toLine() const
+{
+    QList<QByteArray> fields;
+
+    fields.append(HISTORY_VERSION);
+    fields.append(QByteArray::number(iTimestamp));
+    fields.append(QByteArray::number(iBytes));
+    fields.append(textField(iType));
+    fields.append(textField(iTransport));
+    fields.append(textField(iReader.toUtf8()));
+    fields.append(timeField(iReadyMs));
+    fields.append(timeField(iFirstApduMs));
+    fields.append(timeField(iTransferMs));
+    fields.append(QByteArray::number(iRetries));
+    fields.append(QByteArray::number(iResets));
+    fields.append(textField(iOutcome));
+    fields.append(textField(iTech));
+    return fields.join(HISTORY_SEPARATOR) + '\n';
+}
+
+//static
+bool
+ShareHistory::Record::parse(
+    const QByteArray& aLine,
+    Record& aRecord)
+{
+    const QList<QByteArray> fields(aLine.trimmed().split(HISTORY_SEPARATOR));
+
+    const bool v1 = (fields.size() == HISTORY_FIELDS_1 &&
+        fields.at(0) == HISTORY_VERSION_1);
+
+    if (v1 || (fields.size() == HISTORY_FIELDS &&
+        fields.at(0) == HISTORY_VERSION)) {
+        const QByteArray reader(fields.at(5));
+
+        aRecord.iTimestamp = fields.at(1).toLongLong();
+        aRecord.iBytes = fields.at(2).toUInt();
+        aRecord.iType = fields.at(3);
+        aRecord.iTransport = fields.at(4);
+        aRecord.iReader = (reader == HISTORY_NONE) ? QString() :
+            QString::fromUtf8(reader);
+        aRecord.iReadyMs = parseTime(fields.at(6));
+        aRecord.iFirstApduMs = parseTime(fields.at(7));
+        aRecord.iTransferMs = parseTime(fields.at(8));
+        aRecord.iRetries = fields.at(9).toUInt();
+        aRecord.iResets = fields.at(10).toUInt();
+        aRecord.iOutcome = fields.at(11);
+        aRecord.iTech = (v1 || fields.at(12) == HISTORY_NONE) ?
+            QByteArray() : fields.at(12);
+        return true;
+    }
+    return false;
+}
+
+//static
+QByteArray
+ShareHistory::Record::recordType(
+    const QByteArray& aNdef)
+{
+    // Header, type length, payload length (1 or 4 bytes), optional
+    // id length and then the type
+    if (aNdef.size() >= 3) {
+        const uchar hdr = aNdef.at(0);
+        const uint typeLen = (uchar)aNdef.at(1);
+        const uint typeOffset = 2 + ((hdr & NDEF_SR) ? 1 : 4) +
+            ((hdr & NDEF_IL) ? 1 : 0);
+
+        if (typeOffset + typeLen <= (uint)aNdef.size()) {
+            return QByteArray::number(hdr & NDEF_TNF_MASK) + ':' +
+                aNdef.mid(typeOffset, typeLen);
+        }
+    }
+    return QByteArray();
+}
+
+// ==========================================================================
+// ShareHistory
+// ==========================================================================
+
+//static
+QString
+ShareHistory::rotatedFileName(
+    const QString& aFileName)
+{
+    return aFileName + QLatin1String(".1");
+}
+
+//static
+bool
+ShareHistory::append(
+    const QString& aFileName,
+    const Record& aRecord,
+    qint64 aMaxSize)
+{
+    const QByteArray line(aRecord.toLine());
+    QFile file(aFileName);
+
+    // Keep one previous generation around
+    if (file.exists() && file.size() + line.size() > aMaxSize) {
+        const QString rotated(rotatedFileName(aFileName));
+
+        QFile::remove(rotated);
+        if (!file.rename(rotated)) {
+            WARN("Failed to rotate" << aFileName);
+        }
+        file.setFileName(aFileName);
+    }
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return file.write(line) == line.size();
+    } else {
+        WARN("Failed to open" << aFileName);
+        return false;
+    }
+}
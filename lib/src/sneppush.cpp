@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "sneppush.h"
+#include "nfcsharelog.h"
+
+#include <QtCore/QSocketNotifier>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusUnixFileDescriptor>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DBG(x) qCDebug(nfcshareSnep) << x
+#define WARN(x) qCWarning(nfcshareSnep) << x
+
+// ==========================================================================
+//
+// [NFCForum-TS-SNEP_1.0]
+//
+// SNEP request/response message:
+//
+// +------------------------------------------------------------------------+
+// | Offset | Size | Description                                            |
+// +--------+------+--------------------------------------------------------+
+// | 0      | 1    | Version (major/minor 4 bits each)                      |
+// | 1      | 1    | Request or response code                               |
+// | 2      | 4    | Length of the information field (big-endian)           |
+// | 6      | -    | Information (NDEF message for PUT request)             |
+// +------------------------------------------------------------------------+
+//
+// If the request doesn't fit into a single LLCP information PDU, the
+// client sends the first fragment and waits for Continue response.
+//
+// ==========================================================================
+
+#define SNEP_VERSION (0x10)
+#define SNEP_HEADER_SIZE (6)
+#define SNEP_REQUEST_PUT (0x02)
+#define SNEP_RESPONSE_CONTINUE (0x80)
+#define SNEP_RESPONSE_SUCCESS (0x81)
+
+// Default LLCP MIU
+#define SNEP_FIRST_FRAGMENT_SIZE (128)
+
+static const QString NFC_SERVICE_NAME("org.sailfishos.nfc.daemon");
+static const QString NFC_DAEMON_INTERFACE("org.sailfishos.nfc.Daemon");
+static const QString NFC_ADAPTER_INTERFACE("org.sailfishos.nfc.Adapter");
+static const QString NFC_PEER_INTERFACE("org.sailfishos.nfc.Peer");
+static const QString SNEP_SERVICE_NAME("urn:nfc:sn:snep");
+
+SnepPush::SnepPush(
+    QDBusConnection aBus,
+    const QByteArray& aNdef,
+    QObject* aParent) :
+    QObject(aParent),
+    iBus(aBus),
+    iFd(-1),
+    iReadNotifier(Q_NULLPTR),
+    iWriteNotifier(Q_NULLPTR),
+    iBytesWritten(0),
+    iWriteLimit(0),
+    iDone(false)
+{
+    const uint len = aNdef.size();
+
+    iRequest.reserve(SNEP_HEADER_SIZE + len);
+    iRequest.append((char)SNEP_VERSION);
+    iRequest.append((char)SNEP_REQUEST_PUT);
+    iRequest.append((char)(uchar)(len >> 24)); // big-endian
+    iRequest.append((char)(uchar)(len >> 16));
+    iRequest.append((char)(uchar)(len >> 8));
+    iRequest.append((char)(uchar)len);
+    iRequest.append(aNdef);
+
+    // <method name="GetAdapters">
+    //   <arg name="adapters" type="ao" direction="out"/>
+    // </method>
+    connect(new QDBusPendingCallWatcher(iBus.asyncCall(QDBusMessage::
+        createMethodCall(NFC_SERVICE_NAME, "/", NFC_DAEMON_INTERFACE,
+        "GetAdapters")), this),
+        SIGNAL(finished(QDBusPendingCallWatcher*)),
+        SLOT(onGetAdaptersFinished(QDBusPendingCallWatcher*)));
+}
+
+SnepPush::~SnepPush()
+{
+    disconnectPeer();
+}
+
+bool
+SnepPush::isDone() const
+{
+    return iDone;
+}
+
+uint
+SnepPush::bytesSent() const
+{
+    // Only count the NDEF payload
+    return (iBytesWritten > SNEP_HEADER_SIZE) ?
+        (iBytesWritten - SNEP_HEADER_SIZE) : 0;
+}
+
+void
+SnepPush::onGetAdaptersFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<QList<QDBusObjectPath> > reply(*aWatcher);
+
+    if (reply.isValid()) {
+        const QList<QDBusObjectPath> adapters(reply.value());
+
+        for (int i = 0; i < adapters.count(); i++) {
+            watchAdapter(adapters.at(i).path());
+        }
+    } else {
+        WARN(reply.error());
+    }
+    aWatcher->deleteLater();
+}
+
+void
+SnepPush::watchAdapter(
+    QString aPath)
+{
+    DBG("Watching peers on" << aPath);
+
+    // <signal name="PeersChanged">
+    //   <arg name="peers" type="ao"/>
+    // </signal>
+    iBus.connect(NFC_SERVICE_NAME, aPath, NFC_ADAPTER_INTERFACE,
+        "PeersChanged", this, SLOT(onPeersChanged(QList<QDBusObjectPath>)));
+    iAdapters.append(aPath);
+    getPeers(aPath);
+}
+
+void
+SnepPush::getPeers(
+    QString aPath)
+{
+    // <method name="GetPeers">
+    //   <arg name="peers" type="ao" direction="out"/>
+    // </method>
+    connect(new QDBusPendingCallWatcher(iBus.asyncCall(QDBusMessage::
+        createMethodCall(NFC_SERVICE_NAME, aPath, NFC_ADAPTER_INTERFACE,
+        "GetPeers")), this),
+        SIGNAL(finished(QDBusPendingCallWatcher*)),
+        SLOT(onGetPeersFinished(QDBusPendingCallWatcher*)));
+}
+
+void
+SnepPush::retry()
+{
+    // PeersChanged won't come if the peer has stayed in the field
+    if (iPeer.isEmpty() && !iDone) {
+        for (int i = 0; i < iAdapters.count(); i++) {
+            getPeers(iAdapters.at(i));
+        }
+    }
+}
+
+void
+SnepPush::onGetPeersFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<QList<QDBusObjectPath> > reply(*aWatcher);
+
+    if (reply.isValid()) {
+        onPeersChanged(reply.value());
+    } else {
+        WARN(reply.error());
+    }
+    aWatcher->deleteLater();
+}
+
+void
+SnepPush::onPeersChanged(
+    QList<QDBusObjectPath> aPeers)
+{
+    if (!iPeer.isEmpty() && !aPeers.contains(QDBusObjectPath(iPeer))) {
+        DBG("Peer" << iPeer << "is gone");
+        fail();
+    }
+    if (iPeer.isEmpty() && !iDone && !aPeers.isEmpty()) {
+        connectPeer(aPeers.first().path());
+    }
+}
+
+void
+SnepPush::connectPeer(
+    QString aPath)
+{
+    DBG("Connecting to" << SNEP_SERVICE_NAME << "at" << aPath);
+    iPeer = aPath;
+
+    // <method name="ConnectServiceName">
+    //   <arg name="sn" type="s" direction="in"/>
+    //   <arg name="fd" type="h" direction="out"/>
+    // </method>
+    QDBusMessage msg(QDBusMessage::createMethodCall(NFC_SERVICE_NAME, aPath,
+        NFC_PEER_INTERFACE, "ConnectServiceName"));
+    msg << SNEP_SERVICE_NAME;
+    connect(new QDBusPendingCallWatcher(iBus.asyncCall(msg), this),
+        SIGNAL(finished(QDBusPendingCallWatcher*)),
+        SLOT(onConnectFinished(QDBusPendingCallWatcher*)));
+}
+
+void
+SnepPush::onConnectFinished(
+    QDBusPendingCallWatcher* aWatcher)
+{
+    QDBusPendingReply<QDBusUnixFileDescriptor> reply(*aWatcher);
+
+    if (reply.isValid() && !iPeer.isEmpty() && iFd < 0) {
+        // QDBusUnixFileDescriptor closes its descriptor, keep a copy
+        iFd = dup(reply.value().fileDescriptor());
+        if (iFd >= 0) {
+            DBG("Connected to" << iPeer);
+            fcntl(iFd, F_SETFL, fcntl(iFd, F_GETFL) | O_NONBLOCK);
+            iReadNotifier = new QSocketNotifier(iFd, QSocketNotifier::Read, this);
+            iWriteNotifier = new QSocketNotifier(iFd, QSocketNotifier::Write, this);
+            connect(iReadNotifier, SIGNAL(activated(int)), SLOT(onReadyRead()));
+            connect(iWriteNotifier, SIGNAL(activated(int)), SLOT(onReadyWrite()));
+            iResponse.clear();
+            iBytesWritten = 0;
+            send(qMin(iRequest.size(), SNEP_FIRST_FRAGMENT_SIZE));
+        } else {
+            WARN("Failed to dup SNEP socket:" << strerror(errno));
+            fail();
+        }
+    } else if (!reply.isValid() && !iPeer.isEmpty() && iFd < 0) {
+        // Peer is there but didn't let us in
+        WARN(reply.error());
+        fail();
+    } else if (iFd < 0) {
+        iPeer.clear();
+    }
+    aWatcher->deleteLater();
+}
+
+void
+SnepPush::send(
+    uint aLimit)
+{
+    iWriteLimit = aLimit;
+    iWriteNotifier->setEnabled(true);
+}
+
+void
+SnepPush::onReadyWrite()
+{
+    if (iBytesWritten < iWriteLimit) {
+        const uint prevSent = bytesSent();
+        const ssize_t n = write(iFd, iRequest.constData() + iBytesWritten,
+            iWriteLimit - iBytesWritten);
+
+        if (n > 0) {
+            iBytesWritten += n;
+            if (bytesSent() != prevSent) {
+                Q_EMIT bytesSentChanged();
+            }
+        } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            WARN("SNEP write error:" << strerror(errno));
+            fail();
+            return;
+        }
+    }
+    if (iBytesWritten >= iWriteLimit) {
+        // Wait for the response
+        iWriteNotifier->setEnabled(false);
+    }
+}
+
+void
+SnepPush::onReadyRead()
+{
+    char buf[64];
+    const ssize_t n = read(iFd, buf, sizeof(buf));
+
+    if (n > 0) {
+        iResponse.append(buf, n);
+        if (iResponse.size() >= SNEP_HEADER_SIZE) {
+            const uchar* hdr = (const uchar*)iResponse.constData();
+            const uint len = ((uint)hdr[2] << 24) | ((uint)hdr[3] << 16) |
+                ((uint)hdr[4] << 8) | hdr[5];
+
+            if (uint(iResponse.size()) >= SNEP_HEADER_SIZE + len) {
+                const uchar code = hdr[1];
+
+                iResponse.remove(0, SNEP_HEADER_SIZE + len);
+                handleResponse(code);
+            }
+        }
+    } else if (!n || (errno != EAGAIN && errno != EINTR)) {
+        DBG("SNEP connection closed");
+        fail();
+    }
+}
+
+void
+SnepPush::handleResponse(
+    uchar aCode)
+{
+    DBG("SNEP response" << hex << aCode);
+    if (aCode == SNEP_RESPONSE_CONTINUE && iWriteLimit < uint(iRequest.size())) {
+        send(iRequest.size());
+    } else if (aCode == SNEP_RESPONSE_SUCCESS && iBytesWritten == uint(iRequest.size())) {
+        disconnectPeer();
+        iDone = true;
+        Q_EMIT done();
+    } else {
+        WARN("SNEP PUT failed:" << hex << aCode);
+        fail();
+    }
+}
+
+void
+SnepPush::disconnectPeer()
+{
+    // This may be invoked by the notifier itself
+    if (iReadNotifier) {
+        iReadNotifier->setEnabled(false);
+        iReadNotifier->deleteLater();
+        iReadNotifier = Q_NULLPTR;
+    }
+    if (iWriteNotifier) {
+        iWriteNotifier->setEnabled(false);
+        iWriteNotifier->deleteLater();
+        iWriteNotifier = Q_NULLPTR;
+    }
+    if (iFd >= 0) {
+        close(iFd);
+        iFd = -1;
+    }
+    iPeer.clear();
+}
+
+void
+SnepPush::fail()
+{
+    // Wait for the next peer
+    disconnectPeer();
+    if (iBytesWritten) {
+        iBytesWritten = 0;
+        Q_EMIT bytesSentChanged();
+    }
+    Q_EMIT failed();
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef SNEP_PUSH_H
+#define SNEP_PUSH_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusObjectPath>
+
+class QDBusPendingCallWatcher;
+class QSocketNotifier;
+
+// Pushes NDEF message to the NFC peer over SNEP (LLCP) as soon as
+// the peer shows up. After failed() it waits for the next peer, unless
+// retry() is called to try the one which is still around (if any).
+class SnepPush :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    SnepPush(QDBusConnection, const QByteArray&, QObject*);
+    ~SnepPush();
+
+    bool isDone() const;
+    uint bytesSent() const;
+
+public Q_SLOTS:
+    void retry();
+
+Q_SIGNALS:
+    void bytesSentChanged();
+    void failed();
+    void done();
+
+private Q_SLOTS:
+    void onGetAdaptersFinished(QDBusPendingCallWatcher*);
+    void onGetPeersFinished(QDBusPendingCallWatcher*);
+    void onPeersChanged(QList<QDBusObjectPath>);
+    void onConnectFinished(QDBusPendingCallWatcher*);
+    void onReadyRead();
+    void onReadyWrite();
+
+private:
+    void watchAdapter(QString);
+    void getPeers(QString);
+    void connectPeer(QString);
+    void send(uint);
+    void handleResponse(uchar);
+    void disconnectPeer();
+    void fail();
+
+private:
+    QDBusConnection iBus;
+    QStringList iAdapters;
+    QByteArray iRequest;
+    QByteArray iResponse;
+    QString iPeer;
+    int iFd;
+    QSocketNotifier* iReadNotifier;
+    QSocketNotifier* iWriteNotifier;
+    uint iBytesWritten;
+    uint iWriteLimit;
+    bool iDone;
+};
+
+#endif // SNEP_PUSH_H
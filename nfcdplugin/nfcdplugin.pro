@@ -0,0 +1,22 @@
+TEMPLATE = lib
+TARGET = ndefshare
+CONFIG += plugin link_pkgconfig
+CONFIG -= qt
+PKGCONFIG += nfcd-plugin libglibutil libdbusaccess gio-2.0 gio-unix-2.0
+
+QMAKE_CFLAGS += -Wno-unused-parameter -fvisibility=hidden
+QMAKE_LFLAGS += -fvisibility=hidden
+
+CONFIG(debug, debug|release) {
+    DEFINES += DEBUG
+}
+
+HEADERS += \
+    type4tag.h
+
+SOURCES += \
+    plugin.c \
+    type4tag.c
+
+target.path = $$[QT_INSTALL_LIBS]/nfcd/plugins
+INSTALLS += target
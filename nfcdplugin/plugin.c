@@ -0,0 +1,680 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "type4tag.h"
+
+#include <nfc_apdu.h>
+#include <nfc_host_app_impl.h>
+#include <nfc_manager.h>
+#include <nfc_plugin_impl.h>
+
+#include <dbusaccess_peer.h>
+#include <dbusaccess_policy.h>
+
+#include <gutil_log.h>
+#include <gutil_macros.h>
+
+#include <gio/gio.h>
+#include <gio/gunixfdlist.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Serves a static NDEF tag right inside nfcd, so that C-APDUs don't
+ * have to travel over D-Bus. The NDEF message is uploaded once (in a
+ * sealed memfd) by the share plugin and withdrawn when the publisher
+ * calls Withdraw or leaves the bus. Publishing is subject to the same
+ * access policy as RegisterLocalHostApp, only the publisher can replace
+ * or withdraw its tag and Progress/Done signals are only sent to it:
+ *
+ * <interface name="org.sailfishos.nfc.StaticTag">
+ *   <method name="Publish">
+ *     <arg name="fd" type="h" direction="in"/>
+ *     <arg name="id" type="u" direction="out"/>
+ *   </method>
+ *   <method name="Withdraw">
+ *     <arg name="id" type="u" direction="in"/>
+ *   </method>
+ *   <signal name="Progress">
+ *     <arg name="id" type="u"/>
+ *     <arg name="bytes" type="u"/>
+ *     <arg name="total" type="u"/>
+ *   </signal>
+ *   <signal name="Done">
+ *     <arg name="id" type="u"/>
+ *   </signal>
+ * </interface>
+ */
+
+#define STATIC_TAG_PATH "/ndefshare"
+#define STATIC_TAG_INTERFACE "org.sailfishos.nfc.StaticTag"
+#define STATIC_TAG_ERROR_FAILED "org.sailfishos.nfc.Error.Failed"
+#define STATIC_TAG_ERROR_NOT_FOUND "org.sailfishos.nfc.Error.NotFound"
+#define STATIC_TAG_ERROR_ACCESS_DENIED "org.sailfishos.nfc.Error.AccessDenied"
+#define STATIC_TAG_APP_NAME "NfcShare"
+#define STATIC_TAG_MAX_SIZE (0xfffc)
+#define STATIC_TAG_MAX_LE_ENV "NFCSHARE_MAX_LE"
+
+static const char static_tag_introspection_xml[] =
+    "<node>"
+    "  <interface name='" STATIC_TAG_INTERFACE "'>"
+    "    <method name='Publish'>"
+    "      <arg name='fd' type='h' direction='in'/>"
+    "      <arg name='id' type='u' direction='out'/>"
+    "    </method>"
+    "    <method name='Withdraw'>"
+    "      <arg name='id' type='u' direction='in'/>"
+    "    </method>"
+    "    <signal name='Progress'>"
+    "      <arg name='id' type='u'/>"
+    "      <arg name='bytes' type='u'/>"
+    "      <arg name='total' type='u'/>"
+    "    </signal>"
+    "    <signal name='Done'>"
+    "      <arg name='id' type='u'/>"
+    "    </signal>"
+    "  </interface>"
+    "</node>";
+
+/*
+ * nfcd doesn't export the access check it does for RegisterLocalHostApp
+ * to plugins, this is the same libdbusaccess check with the same default
+ * policy: privileged callers only.
+ */
+enum static_tag_action {
+    STATIC_TAG_ACTION_PUBLISH = 1
+};
+
+static const DA_ACTION static_tag_policy_actions[] = {
+    { "Publish", STATIC_TAG_ACTION_PUBLISH, 0 },
+    { NULL }
+};
+
+static const char static_tag_default_policy[] =
+    DA_POLICY_VERSION ";*=deny;group(privileged)=allow";
+
+static const guint8 static_tag_aid[] = {
+    0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01
+};
+
+typedef struct static_tag_plugin StaticTagPlugin;
+
+/*==========================================================================*
+ * StaticTagApp
+ *==========================================================================*/
+
+typedef NfcHostAppClass StaticTagAppClass;
+typedef struct static_tag_app {
+    NfcHostApp app;
+    StaticTagPlugin* plugin;
+    Type4Tag* tag;
+    guint id;
+    gboolean done;
+} StaticTagApp;
+
+G_DEFINE_TYPE(StaticTagApp, static_tag_app, NFC_TYPE_HOST_APP)
+#define THIS_TYPE static_tag_app_get_type()
+#define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, StaticTagApp)
+
+static
+void
+static_tag_plugin_emit_progress(
+    StaticTagPlugin* self,
+    StaticTagApp* app);
+
+static
+void
+static_tag_plugin_emit_done(
+    StaticTagPlugin* self,
+    StaticTagApp* app);
+
+static
+void
+static_tag_app_may_be_reset(
+    StaticTagApp* self)
+{
+    Type4Tag* tag = self->tag;
+
+    if (!self->done && !type4_tag_fully_read(tag) &&
+        type4_tag_bytes_read(tag)) {
+        type4_tag_reset(tag);
+        static_tag_plugin_emit_progress(self->plugin, self);
+    }
+}
+
+static
+void
+static_tag_app_may_be_done(
+    StaticTagApp* self)
+{
+    if (type4_tag_fully_read(self->tag)) {
+        self->done = TRUE;
+        static_tag_plugin_emit_done(self->plugin, self);
+    }
+}
+
+static
+guint
+static_tag_app_complete(
+    NfcHostApp* app,
+    NfcHostAppBoolFunc complete,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    if (complete) {
+        complete(app, TRUE, user_data);
+    }
+    if (destroy) {
+        destroy(user_data);
+    }
+    return NFCD_ID_SYNC;
+}
+
+static
+guint
+static_tag_app_start(
+    NfcHostApp* app,
+    NfcHost* host,
+    NfcHostAppBoolFunc complete,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    GDEBUG("Host %s has started", host->name);
+    static_tag_app_may_be_reset(THIS(app));
+    return static_tag_app_complete(app, complete, user_data, destroy);
+}
+
+static
+guint
+static_tag_app_select(
+    NfcHostApp* app,
+    NfcHost* host,
+    NfcHostAppBoolFunc complete,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    return static_tag_app_complete(app, complete, user_data, destroy);
+}
+
+static
+void
+static_tag_app_response_sent(
+    NfcHostApp* app,
+    gboolean ok,
+    void* user_data)
+{
+    StaticTagApp* self = THIS(app);
+    const gsize prev = type4_tag_bytes_read(self->tag);
+
+    if (ok) {
+        type4_tag_confirm_read(self->tag);
+        if (type4_tag_bytes_read(self->tag) > prev) {
+            static_tag_plugin_emit_progress(self->plugin, self);
+        }
+    }
+}
+
+static
+guint
+static_tag_app_process(
+    NfcHostApp* app,
+    NfcHost* host,
+    const NfcApdu* apdu,
+    NfcHostAppResponseFunc resp,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    StaticTagApp* self = THIS(app);
+    NfcHostAppResponse response;
+
+    memset(&response, 0, sizeof(response));
+    response.sw = type4_tag_process(self->tag, apdu->cla, apdu->ins,
+        apdu->p1, apdu->p2, &apdu->data, apdu->le, &response.data);
+    response.sent = static_tag_app_response_sent;
+    if (resp) {
+        resp(app, &response, user_data);
+    }
+    if (destroy) {
+        destroy(user_data);
+    }
+    return NFCD_ID_SYNC;
+}
+
+static
+void
+static_tag_app_stop(
+    NfcHostApp* app,
+    NfcHost* host)
+{
+    StaticTagApp* self = THIS(app);
+
+    GDEBUG("Host %s left", host->name);
+    static_tag_app_may_be_done(self);
+    static_tag_app_may_be_reset(self);
+}
+
+static
+StaticTagApp*
+static_tag_app_new(
+    StaticTagPlugin* plugin,
+    Type4Tag* tag,
+    guint id)
+{
+    StaticTagApp* self = g_object_new(THIS_TYPE, NULL);
+    GUtilData aid;
+
+    aid.bytes = static_tag_aid;
+    aid.size = sizeof(static_tag_aid);
+    nfc_host_app_init_base(&self->app, &aid, STATIC_TAG_APP_NAME,
+        NFC_HOST_APP_FLAG_ALLOW_IMPLICIT_SELECTION);
+    self->plugin = plugin;
+    self->tag = tag;
+    self->id = id;
+    return self;
+}
+
+static
+void
+static_tag_app_init(
+    StaticTagApp* self)
+{
+}
+
+static
+void
+static_tag_app_finalize(
+    GObject* object)
+{
+    type4_tag_free(THIS(object)->tag);
+    G_OBJECT_CLASS(static_tag_app_parent_class)->finalize(object);
+}
+
+static
+void
+static_tag_app_class_init(
+    StaticTagAppClass* klass)
+{
+    klass->start = static_tag_app_start;
+    klass->implicit_select = static_tag_app_select;
+    klass->select = static_tag_app_select;
+    klass->process = static_tag_app_process;
+    klass->stop = static_tag_app_stop;
+    G_OBJECT_CLASS(klass)->finalize = static_tag_app_finalize;
+}
+
+/*==========================================================================*
+ * StaticTagPlugin
+ *==========================================================================*/
+
+typedef NfcPluginClass StaticTagPluginClass;
+struct static_tag_plugin {
+    NfcPlugin parent;
+    NfcManager* manager;
+    GDBusConnection* bus;
+    GDBusNodeInfo* node;
+    guint object_id;
+    StaticTagApp* app;
+    DAPolicy* policy;
+    char* owner;
+    guint owner_watch;
+    guint last_id;
+};
+
+G_DEFINE_TYPE(StaticTagPlugin, static_tag_plugin, NFC_TYPE_PLUGIN)
+#define PARENT_CLASS static_tag_plugin_parent_class
+#define PLUGIN_TYPE static_tag_plugin_get_type()
+#define PLUGIN(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, PLUGIN_TYPE, StaticTagPlugin)
+
+static
+void
+static_tag_plugin_emit_progress(
+    StaticTagPlugin* self,
+    StaticTagApp* app)
+{
+    g_dbus_connection_emit_signal(self->bus, self->owner, STATIC_TAG_PATH,
+        STATIC_TAG_INTERFACE, "Progress", g_variant_new("(uuu)", app->id,
+        (guint)type4_tag_bytes_read(app->tag),
+        (guint)type4_tag_size(app->tag)), NULL);
+}
+
+static
+void
+static_tag_plugin_emit_done(
+    StaticTagPlugin* self,
+    StaticTagApp* app)
+{
+    g_dbus_connection_emit_signal(self->bus, self->owner, STATIC_TAG_PATH,
+        STATIC_TAG_INTERFACE, "Done", g_variant_new("(u)", app->id), NULL);
+}
+
+static
+void
+static_tag_plugin_withdraw(
+    StaticTagPlugin* self)
+{
+    if (self->owner_watch) {
+        g_bus_unwatch_name(self->owner_watch);
+        self->owner_watch = 0;
+    }
+    if (self->owner) {
+        da_peer_flush(DA_BUS_SYSTEM, self->owner);
+        g_free(self->owner);
+        self->owner = NULL;
+    }
+    if (self->app) {
+        GDEBUG("Withdrawing static tag %u", self->app->id);
+        nfc_manager_unregister_host_app(self->manager, &self->app->app);
+        g_object_unref(self->app);
+        self->app = NULL;
+    }
+}
+
+static
+void
+static_tag_plugin_owner_vanished(
+    GDBusConnection* bus,
+    const gchar* name,
+    gpointer user_data)
+{
+    /* Don't leave the tag behind if the publisher has crashed */
+    GDEBUG("Publisher %s has left the bus", name);
+    static_tag_plugin_withdraw(PLUGIN(user_data));
+}
+
+static
+guint
+static_tag_plugin_max_le(
+    void)
+{
+    /*
+     * Same as NdefApp's NFCSHARE_MAX_LE (but in nfcd's environment),
+     * caps the MLe advertised in the CC for links which can't carry
+     * 64K responses. Zero (the default) means no limit.
+     */
+    const char* env = getenv(STATIC_TAG_MAX_LE_ENV);
+
+    return env ? (guint)strtoul(env, NULL, 0) : 0;
+}
+
+static
+gboolean
+static_tag_plugin_access_allowed(
+    StaticTagPlugin* self,
+    const char* sender)
+{
+    DAPeer* peer = sender ? da_peer_get(DA_BUS_SYSTEM, sender) : NULL;
+    const gboolean allowed = peer && da_policy_check(self->policy,
+        &peer->cred, STATIC_TAG_ACTION_PUBLISH, NULL, DA_ACCESS_DENY) ==
+        DA_ACCESS_ALLOW;
+
+    if (peer && g_strcmp0(sender, self->owner)) {
+        /* Only the owner's credentials are worth keeping */
+        da_peer_flush(DA_BUS_SYSTEM, sender);
+    }
+    return allowed;
+}
+
+static
+Type4Tag*
+static_tag_plugin_read_fd(
+    int fd)
+{
+    Type4Tag* tag = NULL;
+    struct stat st;
+
+#ifdef F_GET_SEALS
+    /* The memfd must not change under our feet */
+    const int seals = fcntl(fd, F_GET_SEALS);
+
+    if (seals < 0 || (seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) !=
+        (F_SEAL_WRITE | F_SEAL_SHRINK)) {
+        GWARN("NDEF memfd is not sealed");
+        return NULL;
+    }
+#endif
+
+    if (!fstat(fd, &st) && st.st_size > 0 &&
+        st.st_size <= STATIC_TAG_MAX_SIZE) {
+        void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+        if (map != MAP_FAILED) {
+            tag = type4_tag_new(map, st.st_size,
+                static_tag_plugin_max_le());
+            munmap(map, st.st_size);
+        } else {
+            GWARN("Failed to map NDEF memfd: %s", strerror(errno));
+        }
+    } else {
+        GWARN("Invalid NDEF memfd");
+    }
+    return tag;
+}
+
+static
+void
+static_tag_plugin_publish(
+    StaticTagPlugin* self,
+    GDBusMethodInvocation* call,
+    GVariant* args)
+{
+    GUnixFDList* fds = g_dbus_message_get_unix_fd_list
+        (g_dbus_method_invocation_get_message(call));
+    const char* sender = g_dbus_method_invocation_get_sender(call);
+    Type4Tag* tag = NULL;
+    gint32 index = -1;
+
+    if (!static_tag_plugin_access_allowed(self, sender)) {
+        GDEBUG("Publish from %s is not allowed", sender);
+        g_dbus_method_invocation_return_dbus_error(call,
+            STATIC_TAG_ERROR_ACCESS_DENIED, "Access denied");
+        return;
+    } else if (self->app && g_strcmp0(sender, self->owner)) {
+        /* Only one static tag at a time, first come first served */
+        GDEBUG("Static tag %u is owned by %s", self->app->id, self->owner);
+        g_dbus_method_invocation_return_dbus_error(call,
+            STATIC_TAG_ERROR_FAILED, "Another tag is published");
+        return;
+    }
+
+    g_variant_get(args, "(h)", &index);
+    if (fds && index >= 0 && index < g_unix_fd_list_get_length(fds)) {
+        const int fd = g_unix_fd_list_get(fds, index, NULL);
+
+        if (fd >= 0) {
+            tag = static_tag_plugin_read_fd(fd);
+            close(fd);
+        }
+    }
+
+    if (tag) {
+        StaticTagApp* app;
+
+        /* Replaces the caller's previous tag, if any */
+        static_tag_plugin_withdraw(self);
+        while (!++self->last_id);
+        app = static_tag_app_new(self, tag, self->last_id);
+        if (nfc_manager_register_host_app(self->manager, &app->app)) {
+            GDEBUG("Published static tag %u (%u bytes)", app->id,
+                (guint)type4_tag_size(tag));
+            self->app = app;
+            if (sender) {
+                self->owner = g_strdup(sender);
+                self->owner_watch = g_bus_watch_name_on_connection(self->bus,
+                    sender, G_BUS_NAME_WATCHER_FLAGS_NONE, NULL,
+                    static_tag_plugin_owner_vanished, self, NULL);
+            }
+            g_dbus_method_invocation_return_value(call,
+                g_variant_new("(u)", app->id));
+        } else {
+            g_object_unref(app);
+            g_dbus_method_invocation_return_dbus_error(call,
+                STATIC_TAG_ERROR_FAILED, "Failed to register host app");
+        }
+    } else {
+        g_dbus_method_invocation_return_dbus_error(call,
+            STATIC_TAG_ERROR_FAILED, "Invalid NDEF data");
+    }
+}
+
+static
+void
+static_tag_plugin_method_call(
+    GDBusConnection* bus,
+    const char* sender,
+    const char* path,
+    const char* iface,
+    const char* method,
+    GVariant* args,
+    GDBusMethodInvocation* call,
+    gpointer user_data)
+{
+    StaticTagPlugin* self = PLUGIN(user_data);
+
+    if (!g_strcmp0(method, "Publish")) {
+        static_tag_plugin_publish(self, call, args);
+    } else if (!g_strcmp0(method, "Withdraw")) {
+        guint id = 0;
+
+        g_variant_get(args, "(u)", &id);
+        if (self->app && self->app->id == id &&
+            !g_strcmp0(sender, self->owner)) {
+            static_tag_plugin_withdraw(self);
+            g_dbus_method_invocation_return_value(call, NULL);
+        } else {
+            g_dbus_method_invocation_return_dbus_error(call,
+                STATIC_TAG_ERROR_NOT_FOUND, "No such tag");
+        }
+    }
+}
+
+static const GDBusInterfaceVTable static_tag_plugin_vtable = {
+    static_tag_plugin_method_call, NULL, NULL
+};
+
+static
+gboolean
+static_tag_plugin_start(
+    NfcPlugin* plugin,
+    NfcManager* manager)
+{
+    StaticTagPlugin* self = PLUGIN(plugin);
+    GError* error = NULL;
+
+    self->bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    if (self->bus) {
+        self->node = g_dbus_node_info_new_for_xml
+            (static_tag_introspection_xml, NULL);
+        self->object_id = g_dbus_connection_register_object(self->bus,
+            STATIC_TAG_PATH, self->node->interfaces[0],
+            &static_tag_plugin_vtable, self, NULL, &error);
+        if (self->object_id) {
+            self->manager = nfc_manager_ref(manager);
+            self->policy = da_policy_new_full(static_tag_default_policy,
+                static_tag_policy_actions);
+            return TRUE;
+        }
+        g_dbus_node_info_unref(self->node);
+        self->node = NULL;
+        g_object_unref(self->bus);
+        self->bus = NULL;
+    }
+    GERR("%s", GERRMSG(error));
+    g_error_free(error);
+    return FALSE;
+}
+
+static
+void
+static_tag_plugin_stop(
+    NfcPlugin* plugin)
+{
+    StaticTagPlugin* self = PLUGIN(plugin);
+
+    static_tag_plugin_withdraw(self);
+    if (self->object_id) {
+        g_dbus_connection_unregister_object(self->bus, self->object_id);
+        self->object_id = 0;
+    }
+    if (self->node) {
+        g_dbus_node_info_unref(self->node);
+        self->node = NULL;
+    }
+    if (self->bus) {
+        g_object_unref(self->bus);
+        self->bus = NULL;
+    }
+    if (self->policy) {
+        da_policy_unref(self->policy);
+        self->policy = NULL;
+    }
+    nfc_manager_unref(self->manager);
+    self->manager = NULL;
+}
+
+static
+void
+static_tag_plugin_init(
+    StaticTagPlugin* self)
+{
+}
+
+static
+void
+static_tag_plugin_class_init(
+    NfcPluginClass* klass)
+{
+    klass->start = static_tag_plugin_start;
+    klass->stop = static_tag_plugin_stop;
+}
+
+static
+NfcPlugin*
+static_tag_plugin_create(
+    void)
+{
+    return g_object_new(PLUGIN_TYPE, NULL);
+}
+
+NFC_PLUGIN_DEFINE(ndefshare, "Static NDEF tag for NFC share",
+    static_tag_plugin_create)
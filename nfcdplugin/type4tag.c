@@ -0,0 +1,528 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "type4tag.h"
+
+#include <gutil_macros.h>
+
+#include <string.h>
+
+/*
+ * Same layout as the one served by NdefApp, see lib/src/ndeftag.cpp
+ * for the description of the CC and NDEF files.
+ */
+
+#define ISO_CLA (0x00)
+#define ISO_INS_SELECT (0xa4)
+#define ISO_INS_READ_BINARY (0xb0)
+#define ISO_INS_READ_BINARY_ODO (0xb1)
+#define ISO_TAG_OFFSET (0x54)       /* Offset data object */
+#define ISO_TAG_DISCRETIONARY (0x53)
+
+/*
+ * Ne as decoded by nfcd: 256 for short Le=00, 65536 for extended
+ * Le=0000, zero if there's no Le at all.
+ */
+#define ISO_SHORT_NE_MAX (0x100)
+
+/* SELECT P1 (how the file is identified) */
+#define ISO_P1_SELECT_BY_ID (0x00)      /* MF, DF or EF identifier */
+#define ISO_P1_SELECT_CHILD_EF (0x02)   /* EF under the current DF */
+#define ISO_P1_SELECT_BY_NAME (0x04)    /* DF name (AID) */
+#define ISO_P1_SELECT_PATH_MF (0x08)    /* Path from the MF */
+#define ISO_P1_SELECT_PATH_DF (0x09)    /* Path from the current DF */
+
+/* SELECT P2 (which occurrence and what to return) */
+#define ISO_P2_OCCURRENCE_MASK (0x03)
+#define ISO_P2_SELECT_FILE_FIRST (0x00)
+#define ISO_P2_SELECT_FILE_LAST (0x01)
+#define ISO_P2_RESPONSE_MASK (0x0c)
+#define ISO_P2_RESPONSE_FCI (0x00)
+#define ISO_P2_RESPONSE_FCP (0x04)
+#define ISO_P2_RESPONSE_FMD (0x08)
+#define ISO_P2_RESPONSE_NONE (0x0c)
+
+/* Control parameter templates */
+#define ISO_TAG_FCP (0x62)
+#define ISO_TAG_FMD (0x64)
+#define ISO_TAG_FCI (0x6f)
+#define FCP_SIZE (13)
+
+#define SW_OK (0x9000)
+#define SW_END_OF_FILE (0x6282)         /* End of file before Ne bytes */
+#define SW_WRONG_LENGTH (0x6700)        /* Wrong length */
+#define SW_NO_CURRENT_EF (0x6986)       /* Command not allowed */
+#define SW_WRONG_DATA (0x6a80)          /* Incorrect data field */
+#define SW_FUNC_NOT_SUPPORTED (0x6a81)  /* Function not supported */
+#define SW_NOT_FOUND (0x6a82)           /* File or application not found */
+#define SW_WRONG_P1P2 (0x6a86)          /* Incorrect parameters P1-P2 */
+#define SW_WRONG_OFFSET (0x6b00)        /* Offset outside the EF */
+#define SW_INS_NOT_SUPPORTED (0x6d00)   /* Instruction not supported */
+#define SW_CLA_NOT_SUPPORTED (0x6e00)   /* Class not supported */
+
+#define CC_SIZE (15)
+#define CC_MLE_OFFSET (3)
+#define CC_NDEF_SIZE_OFFSET (11)
+#define MAX_NDEF_FILE_SIZE (0xfffe)
+#define MAX_LE (0xffff)             /* Largest MLe that fits into the CC */
+#define MIN_LE (0x000f)
+
+static const guint8 ndef_aid[] = { 0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01 };
+static const guint8 mf_fid[] = { 0x3f, 0x00 };
+static const guint8 cc_fid[] = { 0xe1, 0x03 };
+static const guint8 ndef_fid[] = { 0xe1, 0x04 };
+static const guint8 cc_template[CC_SIZE] = {
+    0x00, 0x0f, 0x20, 0xff, 0xff, 0xff, 0xff,
+    0x04, 0x06, 0xe1, 0x04, 0x00, 0x00, 0x00, 0xff
+};
+
+typedef struct type4_tag_file {
+    const guint8* fid;
+    guint8* data;
+    gsize size;
+} Type4TagFile;
+
+struct type4_tag {
+    Type4TagFile cc;
+    Type4TagFile ndef;
+    Type4TagFile* selected;
+    guint8* read_map; /* One byte per NDEF file byte */
+    gsize bytes_read;
+    gsize last_read_start;
+    gsize last_read_end;
+    guint max_le;
+    guint8 fcp[FCP_SIZE]; /* SELECT response */
+    guint8* odo_resp;     /* B1 response, allocated when needed */
+    gsize odo_resp_size;
+};
+
+Type4Tag*
+type4_tag_new(
+    const void* ndef,
+    gsize size,
+    guint max_le)
+{
+    const gsize file_size = size + 2;
+
+    if (file_size <= MAX_NDEF_FILE_SIZE) {
+        Type4Tag* tag = g_new0(Type4Tag, 1);
+
+        tag->cc.fid = cc_fid;
+        tag->cc.size = CC_SIZE;
+        tag->cc.data = g_malloc(CC_SIZE);
+        memcpy(tag->cc.data, cc_template, CC_SIZE);
+        /* Readers are not supposed to ask for more than that */
+        tag->max_le = max_le ? CLAMP(max_le, MIN_LE, MAX_LE) : MAX_LE;
+        tag->cc.data[CC_MLE_OFFSET] = (guint8)(tag->max_le >> 8);
+        tag->cc.data[CC_MLE_OFFSET + 1] = (guint8)tag->max_le;
+        tag->cc.data[CC_NDEF_SIZE_OFFSET] = (guint8)(file_size >> 8);
+        tag->cc.data[CC_NDEF_SIZE_OFFSET + 1] = (guint8)file_size;
+
+        tag->ndef.fid = ndef_fid;
+        tag->ndef.size = file_size;
+        tag->ndef.data = g_malloc(file_size);
+        tag->ndef.data[0] = (guint8)(size >> 8);
+        tag->ndef.data[1] = (guint8)size;
+        memcpy(tag->ndef.data + 2, ndef, size);
+        tag->read_map = g_malloc0(file_size);
+        return tag;
+    }
+    return NULL;
+}
+
+void
+type4_tag_free(
+    Type4Tag* tag)
+{
+    if (tag) {
+        g_free(tag->cc.data);
+        g_free(tag->ndef.data);
+        g_free(tag->read_map);
+        g_free(tag->odo_resp);
+        g_free(tag);
+    }
+}
+
+static
+Type4TagFile*
+type4_tag_find_file(
+    Type4Tag* tag,
+    const guint8* fid)
+{
+    if (fid) {
+        if (!memcmp(fid, cc_fid, 2)) {
+            return &tag->cc;
+        } else if (!memcmp(fid, ndef_fid, 2)) {
+            return &tag->ndef;
+        }
+    }
+    return NULL;
+}
+
+static
+const guint8*
+type4_tag_file_path(
+    guint8 p1,
+    const GUtilData* path)
+{
+    /*
+     * Everything lives right under the MF, so the path can only consist
+     * of the file id, optionally preceded by the MF id (which isn't
+     * supposed to be there for P1=08 but some readers include it).
+     */
+    if (path->size == 2) {
+        return path->bytes;
+    } else if (path->size == 4 && p1 == ISO_P1_SELECT_PATH_MF &&
+        !memcmp(path->bytes, mf_fid, 2)) {
+        return path->bytes + 2;
+    }
+    return NULL;
+}
+
+static
+guint
+type4_tag_select_file(
+    Type4Tag* tag,
+    guint8 p2,
+    const guint8* fid,
+    GUtilData* resp)
+{
+    Type4TagFile* file = type4_tag_find_file(tag, fid);
+
+    if (file) {
+        const guint8 what = p2 & ISO_P2_RESPONSE_MASK;
+        guint8* fcp = tag->fcp;
+
+        tag->selected = file;
+        if (what == ISO_P2_RESPONSE_FMD) {
+            fcp[0] = ISO_TAG_FMD;
+            fcp[1] = 0;
+            resp->bytes = fcp;
+            resp->size = 2;
+        } else if (what != ISO_P2_RESPONSE_NONE) {
+            fcp[0] = (what == ISO_P2_RESPONSE_FCI) ? ISO_TAG_FCI : ISO_TAG_FCP;
+            fcp[1] = FCP_SIZE - 2;
+            fcp[2] = 0x80;          /* Data size */
+            fcp[3] = 2;
+            fcp[4] = (guint8)(file->size >> 8);
+            fcp[5] = (guint8)file->size;
+            fcp[6] = 0x82;          /* Working EF, transparent */
+            fcp[7] = 1;
+            fcp[8] = 0x01;
+            fcp[9] = 0x83;          /* File identifier */
+            fcp[10] = 2;
+            fcp[11] = file->fid[0];
+            fcp[12] = file->fid[1];
+            resp->bytes = fcp;
+            resp->size = FCP_SIZE;
+        }
+        return SW_OK;
+    }
+    return SW_NOT_FOUND;
+}
+
+static
+guint
+type4_tag_select(
+    Type4Tag* tag,
+    guint8 p1,
+    guint8 p2,
+    const GUtilData* data,
+    GUtilData* resp)
+{
+    const gsize size = data ? data->size : 0;
+    const guint8 occurrence = p2 & ISO_P2_OCCURRENCE_MASK;
+
+    /*
+     * Type 4 tag spec only needs P1=00 P2=0C (v2) and P1=04 P2=00 (v1)
+     * but rejecting other sane variants only makes readers retry.
+     * Same rules as in NdefTag.
+     */
+    if (p2 & ~(ISO_P2_OCCURRENCE_MASK | ISO_P2_RESPONSE_MASK)) {
+        return SW_WRONG_P1P2;
+    } else if (occurrence != ISO_P2_SELECT_FILE_FIRST &&
+        occurrence != ISO_P2_SELECT_FILE_LAST) {
+        /* Each file occurs once, there's no next or previous */
+        return SW_NOT_FOUND;
+    }
+
+    switch (p1) {
+    case ISO_P1_SELECT_BY_ID:
+    case ISO_P1_SELECT_CHILD_EF:
+        if (size != 2) {
+            return SW_WRONG_LENGTH;
+        } else if (p1 == ISO_P1_SELECT_BY_ID &&
+            !memcmp(data->bytes, mf_fid, 2)) {
+            /* Some readers start from the MF */
+            tag->selected = NULL;
+            return SW_OK;
+        }
+        return type4_tag_select_file(tag, p2, data->bytes, resp);
+    case ISO_P1_SELECT_PATH_MF:
+    case ISO_P1_SELECT_PATH_DF:
+        if (!size || (size & 1)) {
+            return SW_WRONG_LENGTH;
+        }
+        return type4_tag_select_file(tag, p2,
+            type4_tag_file_path(p1, data), resp);
+    case ISO_P1_SELECT_BY_NAME:
+        /* nfcd normally handles this one but may pass it through */
+        if (size == sizeof(ndef_aid) &&
+            !memcmp(data->bytes, ndef_aid, sizeof(ndef_aid))) {
+            tag->selected = NULL;
+            return SW_OK;
+        }
+        return SW_NOT_FOUND;
+    }
+    return SW_WRONG_P1P2;
+}
+
+static
+gsize
+type4_tag_do_header_size(
+    gsize len)
+{
+    /* BER-TLV tag and length of a data object up to 64K */
+    return (len < 0x80) ? 2 : (len < 0x100) ? 3 : 4;
+}
+
+static
+guint
+type4_tag_read_file(
+    Type4Tag* tag,
+    gsize off,
+    guint le,
+    gboolean wrap,
+    GUtilData* resp)
+{
+    /*
+     * Same as NdefTag: absent Le is treated as a short Le=00, Ne is
+     * capped by MLe, reading past the end is an error and a short
+     * read is a warning (the data are still there).
+     */
+    const Type4TagFile* file = tag->selected;
+    const gsize requested = le ? le : ISO_SHORT_NE_MAX;
+    const gsize ne = MIN(requested, tag->max_le);
+    gsize avail, len;
+
+    if (off >= file->size) {
+        return SW_WRONG_OFFSET;
+    }
+
+    avail = file->size - off;
+    len = MIN(avail, ne);
+    if (wrap) {
+        gsize head;
+        guint8* ptr;
+
+        /* The data object header (53 L) takes up to 4 bytes of Ne */
+        while (len && type4_tag_do_header_size(len) + len > ne) {
+            len--;
+        }
+        if (!len) {
+            return SW_WRONG_LENGTH;
+        }
+
+        head = type4_tag_do_header_size(len);
+        if (tag->odo_resp_size < head + len) {
+            g_free(tag->odo_resp);
+            tag->odo_resp_size = head + len;
+            tag->odo_resp = g_malloc(tag->odo_resp_size);
+        }
+        ptr = tag->odo_resp;
+        *ptr++ = ISO_TAG_DISCRETIONARY;
+        if (head > 2) {
+            *ptr++ = (guint8)(0x80 + head - 2);
+            if (head > 3) {
+                *ptr++ = (guint8)(len >> 8);
+            }
+        }
+        *ptr++ = (guint8)len;
+        memcpy(ptr, file->data + off, len);
+        resp->bytes = tag->odo_resp;
+        resp->size = head + len;
+    } else {
+        resp->bytes = file->data + off;
+        resp->size = len;
+    }
+
+    if (file == &tag->ndef) {
+        tag->last_read_start = off;
+        tag->last_read_end = off + len;
+    }
+    return (len == avail && resp->size < requested) ? SW_END_OF_FILE : SW_OK;
+}
+
+static
+guint
+type4_tag_read_binary(
+    Type4Tag* tag,
+    guint8 p1,
+    guint8 p2,
+    guint le,
+    GUtilData* resp)
+{
+    /* P1-P2 (fifteen bits) encodes an offset from zero to 32767 */
+    if (!tag->selected) {
+        return SW_NO_CURRENT_EF;
+    } else if (p1 & 0x80) {
+        /* Short EF identifiers aren't supported */
+        return SW_FUNC_NOT_SUPPORTED;
+    }
+    return type4_tag_read_file(tag, (((gsize)p1) << 8) | p2, le, FALSE, resp);
+}
+
+static
+guint
+type4_tag_read_binary_odo(
+    Type4Tag* tag,
+    guint8 p1,
+    guint8 p2,
+    const GUtilData* data,
+    guint le,
+    GUtilData* resp)
+{
+    /*
+     * The offset comes in the offset data object (tag 54) which allows
+     * offsets beyond 32767. P1-P2 is either zero (current EF) or the
+     * file identifier.
+     */
+    const guint p1p2 = (((guint)p1) << 8) | p2;
+    const guint8* odo = data ? data->bytes : NULL;
+    const gsize size = data ? data->size : 0;
+    gsize off = 0;
+    guint i;
+
+    if (p1p2) {
+        const guint8 fid[2] = { p1, p2 };
+        Type4TagFile* file;
+
+        if (!(p1p2 & 0xffe0)) {
+            /* Short EF identifiers aren't supported */
+            return SW_FUNC_NOT_SUPPORTED;
+        } else if (!(file = type4_tag_find_file(tag, fid))) {
+            return SW_NOT_FOUND;
+        }
+        tag->selected = file;
+    } else if (!tag->selected) {
+        return SW_NO_CURRENT_EF;
+    }
+
+    if (size < 3 || odo[0] != ISO_TAG_OFFSET || odo[1] < 1 || odo[1] > 3 ||
+        size != (gsize)odo[1] + 2) {
+        return SW_WRONG_DATA;
+    }
+
+    for (i = 0; i < odo[1]; i++) {
+        off = (off << 8) | odo[2 + i];
+    }
+    return type4_tag_read_file(tag, off, le, TRUE, resp);
+}
+
+guint
+type4_tag_process(
+    Type4Tag* tag,
+    guint8 cla,
+    guint8 ins,
+    guint8 p1,
+    guint8 p2,
+    const GUtilData* data,
+    guint le,
+    GUtilData* resp)
+{
+    resp->bytes = NULL;
+    resp->size = 0;
+    tag->last_read_start = tag->last_read_end = 0;
+    if (cla != ISO_CLA) {
+        return SW_CLA_NOT_SUPPORTED;
+    }
+    switch (ins) {
+    case ISO_INS_SELECT:
+        return type4_tag_select(tag, p1, p2, data, resp);
+    case ISO_INS_READ_BINARY:
+        return type4_tag_read_binary(tag, p1, p2, le, resp);
+    case ISO_INS_READ_BINARY_ODO:
+        return type4_tag_read_binary_odo(tag, p1, p2, data, le, resp);
+    }
+    return SW_INS_NOT_SUPPORTED;
+}
+
+void
+type4_tag_confirm_read(
+    Type4Tag* tag)
+{
+    gsize i;
+
+    for (i = tag->last_read_start; i < tag->last_read_end; i++) {
+        if (!tag->read_map[i]) {
+            tag->read_map[i] = TRUE;
+            tag->bytes_read++;
+        }
+    }
+    tag->last_read_start = tag->last_read_end = 0;
+}
+
+void
+type4_tag_reset(
+    Type4Tag* tag)
+{
+    memset(tag->read_map, 0, tag->ndef.size);
+    tag->bytes_read = 0;
+    tag->last_read_start = tag->last_read_end = 0;
+}
+
+gsize
+type4_tag_size(
+    const Type4Tag* tag)
+{
+    return tag->ndef.size;
+}
+
+gsize
+type4_tag_bytes_read(
+    const Type4Tag* tag)
+{
+    return tag->bytes_read;
+}
+
+gboolean
+type4_tag_fully_read(
+    const Type4Tag* tag)
+{
+    return tag->bytes_read == tag->ndef.size;
+}
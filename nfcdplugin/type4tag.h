@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef TYPE4_TAG_H
+#define TYPE4_TAG_H
+
+#include <gutil_types.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Static Type 4 NDEF tag file system (CC and NDEF files), independent
+ * of nfcd and D-Bus.
+ */
+
+typedef struct type4_tag Type4Tag;
+
+/* Zero max_le means the largest MLe the CC can advertise (0xffff) */
+Type4Tag*
+type4_tag_new(
+    const void* ndef,
+    gsize size,
+    guint max_le);
+
+void
+type4_tag_free(
+    Type4Tag* tag);
+
+/* Returns the status word (SW1 << 8 | SW2), response data points
+ * to the internal buffer and stays valid until the next call. */
+guint
+type4_tag_process(
+    Type4Tag* tag,
+    guint8 cla,
+    guint8 ins,
+    guint8 p1,
+    guint8 p2,
+    const GUtilData* data,
+    guint le,
+    GUtilData* resp);
+
+/* Confirms that the last READ BINARY response has been delivered */
+void
+type4_tag_confirm_read(
+    Type4Tag* tag);
+
+void
+type4_tag_reset(
+    Type4Tag* tag);
+
+gsize
+type4_tag_size(
+    const Type4Tag* tag);
+
+gsize
+type4_tag_bytes_read(
+    const Type4Tag* tag);
+
+gboolean
+type4_tag_fully_read(
+    const Type4Tag* tag);
+
+G_END_DECLS
+
+#endif /* TYPE4_TAG_H */
@@ -36,11 +36,15 @@
  * any official policies, either expressed or implied.
  */
 
+#include "ndefmetrics.h"
 #include "nfcshare.h"
+#include "nfcsharebearer.h"
+#include "nfcsharegenerator.h"
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QLocale>
 #include <QtCore/QTranslator>
+#include <QtQml/QJSValue>
 #include <QtQml/QQmlEngine>
 #include <QtQml/QQmlExtensionPlugin>
 #include <QtQml/qqml.h>
@@ -70,6 +74,68 @@ NfcSharePluginTranslator::~NfcSharePluginTranslator()
     qApp->removeTranslator(this);
 }
 
+// ==========================================================================
+// NfcShareScriptGenerator
+// ==========================================================================
+
+class NfcShareScriptGenerator:
+    public NfcShareGenerator
+{
+    Q_OBJECT
+    Q_PROPERTY(QJSValue callback READ getCallback WRITE setCallback NOTIFY callbackChanged)
+
+public:
+    NfcShareScriptGenerator(QObject* aParent = Q_NULLPTR);
+
+    QJSValue getCallback() const;
+    void setCallback(QJSValue);
+
+    QString generateText() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void callbackChanged();
+
+private:
+    QJSValue iCallback;
+};
+
+NfcShareScriptGenerator::NfcShareScriptGenerator(
+    QObject* aParent) :
+    NfcShareGenerator(aParent)
+{}
+
+QJSValue
+NfcShareScriptGenerator::getCallback() const
+{
+    return iCallback;
+}
+
+void
+NfcShareScriptGenerator::setCallback(
+    QJSValue aCallback)
+{
+    if (!iCallback.strictlyEquals(aCallback)) {
+        iCallback = aCallback;
+        Q_EMIT callbackChanged();
+    }
+}
+
+QString
+NfcShareScriptGenerator::generateText()
+{
+    // The callback returns the text to share with the next reader.
+    // It runs on the GUI thread (the only one that may touch the JS
+    // engine) and blocks it, so it'd better not take long.
+    if (iCallback.isCallable()) {
+        const QJSValue result(iCallback.call());
+
+        if (!result.isError()) {
+            return result.toString();
+        }
+    }
+    return QString();
+}
+
 // ==========================================================================
 // NfcShareQmlExtensionPlugin
 // ==========================================================================
@@ -91,6 +157,10 @@ NfcShareQmlExtensionPlugin::registerTypes(
     const char* aUri)
 {
     qmlRegisterType<NfcShare>(aUri, V1, V2, "NfcShare");
+    qmlRegisterType<NfcShareBearer>(aUri, V1, V2, "NfcShareBearer");
+    qmlRegisterType<NfcShareScriptGenerator>(aUri, V1, V2, "NfcShareGenerator");
+    qmlRegisterUncreatableType<NdefMetrics>(aUri, V1, V2, "NdefMetrics",
+        "NdefMetrics is provided by NfcShare");
 }
 
 void
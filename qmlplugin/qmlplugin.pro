@@ -1,25 +1,23 @@
 TEMPLATE = lib
 TARGET = nfcshareqmlplugin
-CONFIG += plugin link_pkgconfig
-PKGCONFIG += libnfcdef
+CONFIG += plugin
 QT += dbus qml
 
 QMAKE_CXXFLAGS += -Wno-unused-parameter -fvisibility=hidden
 QMAKE_LFLAGS += -fvisibility=hidden
 
+DEFINES += QT_NO_KEYWORDS
+
 CONFIG(debug, debug|release) {
     DEFINES += DEBUG
 }
 
 include(../config.pri)
 
-HEADERS += \
-    ndefapp.h \
-    nfcshare.h
+INCLUDEPATH += ../lib/include
+LIBS += -L$$OUT_PWD/../lib -lnfcshare
 
 SOURCES += \
-    ndefapp.cpp \
-    nfcshare.cpp \
     plugin.cpp
 
 OTHER_FILES += \
@@ -8,12 +8,18 @@ Source0:    %{name}-%{version}.tar.gz
 
 Requires: sailfishshare-components
 Requires: nfcd >= 1.2
+Requires: libnfcshare = %{version}
 
 BuildRequires:  pkgconfig(Qt5Core)
 BuildRequires:  pkgconfig(Qt5DBus)
 BuildRequires:  pkgconfig(Qt5Qml)
 BuildRequires:  pkgconfig(Qt5Quick)
 BuildRequires:  pkgconfig(libnfcdef)
+BuildRequires:  pkgconfig(libglibutil)
+BuildRequires:  pkgconfig(libdbusaccess)
+BuildRequires:  pkgconfig(nfcd-plugin) >= 1.2
+BuildRequires:  pkgconfig(gio-unix-2.0)
+BuildRequires:  pkgconfig(zlib)
 BuildRequires:  pkgconfig(nemotransferengine-qt5) >= 2
 BuildRequires:  qt5-qttools
 BuildRequires:  qt5-qttools-linguist
@@ -32,6 +38,47 @@ BuildRequires:  sailfish-svg2png
 %description
 %{summary}.
 
+%package -n libnfcshare
+Summary: NFC sharing library
+Requires: nfcd >= 1.2
+
+%description -n libnfcshare
+Type 4 tag emulation and SNEP push of NDEF messages over nfcd.
+
+%package -n libnfcshare-devel
+Summary: Development files for libnfcshare
+Requires: libnfcshare = %{version}
+
+%description -n libnfcshare-devel
+Headers and pkg-config file for libnfcshare.
+
+%package -n libnfcsharez
+Summary: Decoder for compressed NfcShare messages
+
+%description -n libnfcsharez
+Unpacks NDEF messages compressed by libnfcshare.
+
+%package -n libnfcsharez-devel
+Summary: Development files for libnfcsharez
+Requires: libnfcsharez = %{version}
+
+%description -n libnfcsharez-devel
+Header and pkg-config file for libnfcsharez.
+
+%package -n nfcshare-cli
+Summary: Command line NFC sharing tool
+Requires: libnfcshare = %{version}
+
+%description -n nfcshare-cli
+Shares text or files over NFC from scripts and system services.
+
+%package -n nfcd-ndefshare-plugin
+Summary: Static NDEF tag plugin for nfcd
+Requires: nfcd >= 1.2
+
+%description -n nfcd-ndefshare-plugin
+Serves the NDEF tag shared by %{name} right inside nfcd.
+
 %package ts-devel
 Summary: Translation source for %{name}
 
@@ -42,7 +89,7 @@ Translation source for %{name}
 %setup -q -n %{name}-%{version}
 
 %build
-%qmake5 \
+%qmake5 CONFIG+=nfcd_plugin CONFIG+=use_gio \
 %if %{?use_svg}
   CONFIG+=use_svg
 %endif
@@ -62,5 +109,38 @@ Translation source for %{name}
 %{_datadir}/themes/sailfish-default/silica/*/icons/*.png
 %endif
 
+%post -n libnfcshare -p /sbin/ldconfig
+
+%postun -n libnfcshare -p /sbin/ldconfig
+
+%files -n libnfcshare
+%license LICENSE
+%{_libdir}/libnfcshare.so.*
+
+%files -n libnfcshare-devel
+%{_libdir}/libnfcshare.so
+%{_libdir}/pkgconfig/libnfcshare.pc
+%{_includedir}/nfcshare
+
+%post -n libnfcsharez -p /sbin/ldconfig
+
+%postun -n libnfcsharez -p /sbin/ldconfig
+
+%files -n libnfcsharez
+%license LICENSE
+%{_libdir}/libnfcsharez.so.*
+
+%files -n libnfcsharez-devel
+%{_libdir}/libnfcsharez.so
+%{_libdir}/pkgconfig/libnfcsharez.pc
+%{_includedir}/nfcsharez
+
+%files -n nfcshare-cli
+%{_bindir}/nfcshare
+%{_datadir}/dbus-1/services/org.sailfishos.nfcshare.service
+
+%files -n nfcd-ndefshare-plugin
+%{_libdir}/nfcd/plugins/libndefshare.so
+
 %files ts-devel
 %{_datadir}/translations/source/*.ts
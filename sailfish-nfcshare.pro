@@ -1,3 +1,22 @@
 TEMPLATE = subdirs
-SUBDIRS = qmlplugin shareplugin translations icons
+SUBDIRS = lib decoder qmlplugin cli shareplugin translations icons
+
+qmlplugin.depends = lib
+cli.depends = lib
+
+CONFIG(nfcd_plugin) {
+    SUBDIRS += nfcdplugin
+}
+
+# Developer tools, not packaged
+CONFIG(tools) {
+    SUBDIRS += tools
+    tools.depends = lib
+}
+
+# Unit tests and benchmarks, not packaged either (make check)
+CONFIG(tests) {
+    SUBDIRS += tests
+    tests.depends = lib
+}
 OTHER_FILES += LICENSE README rpm/*
@@ -29,6 +29,11 @@ Item {
             anchors.centerIn: parent
             source: "image://theme/icon-l-nfc"
         }
+
+        MouseArea {
+            anchors.fill: parent
+            onClicked: nfcShare.reacquire()
+        }
     }
 
     ProgressBar {
@@ -12,7 +12,8 @@ QMAKE_CFLAGS += -fvisibility=hidden
 QMAKE_LFLAGS += -fvisibility=hidden
 
 INCLUDEPATH += \
-    ../shareplugin
+    ../shareplugin \
+    ../lib/src
 
 DEFINES += \
     NFCSHARE_UI_DIR=\\\"$$NFCSHARE_UI_DIR\\\" \
@@ -26,8 +27,10 @@ CONFIG(use_svg) {
     DEFINES += USE_SVG
 }
 
+# The plugin doesn't link libnfcshare, only shares its logging categories
 SOURCES += \
-    src/nfcshareplugin.cpp
+    src/nfcshareplugin.cpp \
+    ../lib/src/nfcsharelog.cpp
 
 UI_FILES = \
     qml/$${NFCSHARE_UI_FILE}
@@ -37,18 +37,14 @@
  */
 
 #include "sharingplugininterface.h"
+#include "nfcsharelog.h"
 
-#include <QtCore/QDebug>
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusInterface>
 #include <QtDBus/QDBusReply>
 
-#ifdef DEBUG
-#  define DBG(x) qDebug() << x
-#else
-#  define DBG(x) ((void)0)
-#endif
-#define WARN(x) qWarning() << x
+#define DBG(x) qCDebug(nfcsharePlugin) << x
+#define WARN(x) qCWarning(nfcsharePlugin) << x
 
 // org.sailfishos.nfc.Daemon version 4 (or later) is required
 #define NFCD_MIN_INTERFACE_VERSION 4
@@ -119,7 +115,12 @@ NfcSharePlugin::PluginInfo::query()
 
     // Interface version 4 (or later) is required
     // NFC must be enabled
-    QDBusConnection bus(QDBusConnection::systemBus());
+    // NFCSHARE_DBUS_ADDRESS may point to a private bus with a stand-in
+    // nfcd, otherwise it's the system bus
+    const QByteArray address(qgetenv("NFCSHARE_DBUS_ADDRESS"));
+    QDBusConnection bus(address.isEmpty() ? QDBusConnection::systemBus() :
+        QDBusConnection::connectToBus(QString::fromLatin1(address),
+            QStringLiteral("nfcshare")));
     QDBusInterface daemon("org.sailfishos.nfc.daemon", "/",
         "org.sailfishos.nfc.Daemon", bus);
     QDBusInterface settings("org.sailfishos.nfc.settings", "/",
@@ -0,0 +1,16 @@
+# Settings shared by all Qt based tests
+TEMPLATE = app
+CONFIG += console testcase no_testcase_installs
+CONFIG -= app_bundle
+QT = core testlib
+
+QMAKE_CXXFLAGS += -Wno-unused-parameter
+
+DEFINES += QT_NO_KEYWORDS
+
+CONFIG(debug, debug|release) {
+    DEFINES += DEBUG
+}
+
+LIB_DIR = $$PWD/../../lib
+INCLUDEPATH += $${LIB_DIR}/include
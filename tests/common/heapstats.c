@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "heapstats.h"
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The real thing, exported by glibc */
+extern void* __libc_malloc(size_t);
+extern void* __libc_calloc(size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void* __libc_memalign(size_t, size_t);
+extern void __libc_free(void*);
+
+static size_t heap_stats_current = 0;
+static size_t heap_stats_peak = 0;
+static unsigned long heap_stats_allocs = 0;
+
+static
+void*
+heap_stats_alloced(
+    void* ptr)
+{
+    if (ptr) {
+        const size_t size = malloc_usable_size(ptr);
+        const size_t current = __atomic_add_fetch(&heap_stats_current,
+            size, __ATOMIC_RELAXED);
+        size_t peak = __atomic_load_n(&heap_stats_peak, __ATOMIC_RELAXED);
+
+        while (current > peak && !__atomic_compare_exchange_n(
+            &heap_stats_peak, &peak, current, 1, __ATOMIC_RELAXED,
+            __ATOMIC_RELAXED));
+        __atomic_add_fetch(&heap_stats_allocs, 1, __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+static
+void
+heap_stats_freeing(
+    void* ptr)
+{
+    if (ptr) {
+        __atomic_sub_fetch(&heap_stats_current, malloc_usable_size(ptr),
+            __ATOMIC_RELAXED);
+    }
+}
+
+void*
+malloc(
+    size_t size)
+{
+    return heap_stats_alloced(__libc_malloc(size));
+}
+
+void*
+calloc(
+    size_t nmemb,
+    size_t size)
+{
+    return heap_stats_alloced(__libc_calloc(nmemb, size));
+}
+
+void*
+realloc(
+    void* ptr,
+    size_t size)
+{
+    void* ret;
+
+    heap_stats_freeing(ptr);
+    ret = __libc_realloc(ptr, size);
+    if (ret) {
+        heap_stats_alloced(ret);
+    } else if (ptr && size) {
+        /* Failed, the old block is still there */
+        heap_stats_alloced(ptr);
+    }
+    return ret;
+}
+
+void*
+memalign(
+    size_t alignment,
+    size_t size)
+{
+    return heap_stats_alloced(__libc_memalign(alignment, size));
+}
+
+void*
+aligned_alloc(
+    size_t alignment,
+    size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int
+posix_memalign(
+    void** memptr,
+    size_t alignment,
+    size_t size)
+{
+    void* ptr;
+
+    if (!alignment || (alignment & (alignment - 1)) ||
+        (alignment % sizeof(void*))) {
+        return EINVAL;
+    }
+    ptr = memalign(alignment, size);
+    if (!ptr && size) {
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+void
+free(
+    void* ptr)
+{
+    heap_stats_freeing(ptr);
+    __libc_free(ptr);
+}
+
+static
+size_t
+heap_stats_rss(
+    void)
+{
+    FILE* f = fopen("/proc/self/statm", "r");
+    size_t rss = 0;
+
+    if (f) {
+        unsigned long size, resident;
+
+        if (fscanf(f, "%lu %lu", &size, &resident) == 2) {
+            rss = (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+        }
+        fclose(f);
+    }
+    return rss;
+}
+
+void
+heap_stats_get(
+    HeapStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->rss = heap_stats_rss();
+    stats->current = __atomic_load_n(&heap_stats_current, __ATOMIC_RELAXED);
+    stats->peak = __atomic_load_n(&heap_stats_peak, __ATOMIC_RELAXED);
+    stats->allocs = __atomic_load_n(&heap_stats_allocs, __ATOMIC_RELAXED);
+}
+
+void
+heap_stats_reset_peak(
+    void)
+{
+    __atomic_store_n(&heap_stats_peak, __atomic_load_n(&heap_stats_current,
+        __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
@@ -0,0 +1,12 @@
+# Heap accounting, replaces malloc() and friends (glibc only)
+INCLUDEPATH += $$PWD
+
+# Otherwise the compiler may pair up and drop malloc() and free()
+QMAKE_CFLAGS += -fno-builtin
+QMAKE_CXXFLAGS += -fno-builtin-malloc -fno-builtin-free
+
+HEADERS += \
+    $$PWD/heapstats.h
+
+SOURCES += \
+    $$PWD/heapstats.c
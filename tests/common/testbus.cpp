@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "testbus.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QProcess>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusArgument>
+#include <QtDBus/QDBusConnectionInterface>
+#include <QtDBus/QDBusPendingCallWatcher>
+
+#define NFCSHARE_DBUS_ADDRESS_ENV "NFCSHARE_DBUS_ADDRESS"
+#define TEST_BUS_CONNECTION "testbus"
+
+#define START_TIMEOUT_MS (5000)
+#define CALL_TIMEOUT_MS (10000)
+#define READ_TIMEOUT_MS (60000)
+#define PUSH_TIMEOUT_MS (60000)
+
+static const QString MOCK_SERVICE("org.sailfishos.nfc.daemon");
+static const QString MOCK_PATH("/mock");
+static const QString MOCK_INTERFACE("org.sailfishos.nfc.Mock");
+
+// ==========================================================================
+// TestBus::Registrations
+// ==========================================================================
+
+TestBus::Registrations::Registrations() :
+    iApps(0),
+    iModes(0),
+    iTechs(0),
+    iDropped(0)
+{
+}
+
+bool
+TestBus::Registrations::isEmpty() const
+{
+    return !iApps && !iModes && !iTechs && !iDropped;
+}
+
+// ==========================================================================
+// TestBus::Read
+// ==========================================================================
+
+TestBus::Read::Read() :
+    iTotal(0)
+{
+}
+
+// ==========================================================================
+// TestBus::Push
+// ==========================================================================
+
+TestBus::Push::Push() :
+    iConnections(0),
+    iContinues(0)
+{
+}
+
+// ==========================================================================
+// TestBus
+// ==========================================================================
+
+TestBus::TestBus(
+    QObject* aParent) :
+    QObject(aParent),
+    iDaemon(Q_NULLPTR),
+    iMock(Q_NULLPTR)
+{
+}
+
+TestBus::~TestBus()
+{
+    stop();
+}
+
+bool
+TestBus::start()
+{
+    stop();
+    iDaemon = new QProcess(this);
+    iDaemon->start("dbus-daemon", QStringList() << "--session" <<
+        "--nofork" << "--print-address");
+    if (!iDaemon->waitForStarted(START_TIMEOUT_MS)) {
+        qWarning() << "Failed to start dbus-daemon";
+        return false;
+    }
+
+    // The first line it prints is the address
+    QElapsedTimer timer;
+
+    timer.start();
+    while (!iDaemon->canReadLine() && timer.elapsed() < START_TIMEOUT_MS) {
+        iDaemon->waitForReadyRead(START_TIMEOUT_MS);
+    }
+    iAddress = QString::fromLatin1(iDaemon->readLine().trimmed());
+    if (iAddress.isEmpty()) {
+        qWarning() << "dbus-daemon didn't print its address";
+        return false;
+    }
+
+    iMock = new QProcess(this);
+    iMock->setProcessChannelMode(QProcess::ForwardedChannels);
+    iMock->start(MOCKNFCD, QStringList() << iAddress);
+    if (!iMock->waitForStarted(START_TIMEOUT_MS)) {
+        qWarning() << "Failed to start" << MOCKNFCD;
+        return false;
+    }
+
+    // Nothing else is running yet, blocking calls are fine
+    QDBusConnection bus(QDBusConnection::connectToBus(iAddress,
+        TEST_BUS_CONNECTION));
+
+    timer.restart();
+    while (!bus.interface()->isServiceRegistered(MOCK_SERVICE) &&
+        timer.elapsed() < START_TIMEOUT_MS) {
+        QThread::msleep(10);
+    }
+    if (!bus.interface()->isServiceRegistered(MOCK_SERVICE)) {
+        qWarning() << "mocknfcd didn't show up on" << iAddress;
+        return false;
+    }
+    qputenv(NFCSHARE_DBUS_ADDRESS_ENV, iAddress.toLatin1());
+    return true;
+}
+
+void
+TestBus::stop()
+{
+    if (iMock) {
+        iMock->terminate();
+        iMock->waitForFinished(START_TIMEOUT_MS);
+        delete iMock;
+        iMock = Q_NULLPTR;
+    }
+    if (iDaemon) {
+        iDaemon->terminate();
+        iDaemon->waitForFinished(START_TIMEOUT_MS);
+        delete iDaemon;
+        iDaemon = Q_NULLPTR;
+    }
+    if (!iAddress.isEmpty()) {
+        QDBusConnection::disconnectFromBus(TEST_BUS_CONNECTION);
+        qunsetenv(NFCSHARE_DBUS_ADDRESS_ENV);
+        iAddress.clear();
+    }
+}
+
+QString
+TestBus::address() const
+{
+    return iAddress;
+}
+
+QDBusMessage
+TestBus::call(
+    const QString& aMethod,
+    const QVariantList& aArgs,
+    int aTimeout)
+{
+    QDBusMessage msg(QDBusMessage::createMethodCall(MOCK_SERVICE,
+        MOCK_PATH, MOCK_INTERFACE, aMethod));
+    QDBusConnection bus(QDBusConnection::connectToBus(iAddress,
+        TEST_BUS_CONNECTION));
+
+    msg.setArguments(aArgs);
+
+    // Keep the event loop running, the mock may be calling us back
+    QDBusPendingCallWatcher watcher(bus.asyncCall(msg, aTimeout));
+    QEventLoop loop;
+
+    connect(&watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+        &loop, SLOT(quit()));
+    if (!watcher.isFinished()) {
+        loop.exec();
+    }
+    if (watcher.isError()) {
+        qWarning() << aMethod << watcher.error().message();
+    }
+    return watcher.reply();
+}
+
+bool
+TestBus::setReplyDelay(
+    uint aMs)
+{
+    return call("SetReplyDelay", QVariantList() << aMs, CALL_TIMEOUT_MS).
+        type() == QDBusMessage::ReplyMessage;
+}
+
+bool
+TestBus::getRegistrations(
+    Registrations& aRegistrations)
+{
+    const QDBusMessage reply(call("GetRegistrations", QVariantList(),
+        CALL_TIMEOUT_MS));
+    const QVariantList args(reply.arguments());
+
+    if (reply.type() == QDBusMessage::ReplyMessage && args.count() == 4) {
+        aRegistrations.iApps = args.at(0).toUInt();
+        aRegistrations.iModes = args.at(1).toUInt();
+        aRegistrations.iTechs = args.at(2).toUInt();
+        aRegistrations.iDropped = args.at(3).toUInt();
+        return true;
+    }
+    return false;
+}
+
+bool
+TestBus::waitForRegistrations(
+    Registrations& aRegistrations,
+    int aTimeout)
+{
+    // Undoing the registration steps takes a few round trips, let
+    // them settle before looking at what's left in the mock
+    QElapsedTimer timer;
+
+    timer.start();
+    while (getRegistrations(aRegistrations)) {
+        if (aRegistrations.isEmpty() || timer.elapsed() >= aTimeout) {
+            return true;
+        }
+
+        QEventLoop loop;
+
+        QTimer::singleShot(10, &loop, SLOT(quit()));
+        loop.exec();
+    }
+    return false;
+}
+
+bool
+TestBus::read(
+    uint aLe,
+    Read& aRead)
+{
+    const QDBusMessage reply(call("Read", QVariantList() << aLe,
+        READ_TIMEOUT_MS));
+    const QVariantList args(reply.arguments());
+
+    if (reply.type() == QDBusMessage::ReplyMessage && args.count() == 3) {
+        const QDBusArgument latencies(args.at(1).value<QDBusArgument>());
+
+        aRead.iNdef = args.at(0).toByteArray();
+        aRead.iLatencies.clear();
+        latencies >> aRead.iLatencies;
+        aRead.iTotal = args.at(2).toUInt();
+        aRead.iError.clear();
+        return true;
+    } else {
+        aRead.iError = reply.errorMessage();
+        return false;
+    }
+}
+
+bool
+TestBus::push(
+    const QByteArray& aResponses,
+    Push& aPush)
+{
+    const QDBusMessage reply(call("Push", QVariantList() << aResponses,
+        PUSH_TIMEOUT_MS));
+    const QVariantList args(reply.arguments());
+
+    if (reply.type() == QDBusMessage::ReplyMessage && args.count() == 3) {
+        aPush.iNdef = args.at(0).toByteArray();
+        aPush.iConnections = args.at(1).toUInt();
+        aPush.iContinues = args.at(2).toUInt();
+        aPush.iError.clear();
+        return true;
+    } else {
+        aPush.iError = reply.errorMessage();
+        return false;
+    }
+}
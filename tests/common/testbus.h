@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef TEST_BUS_H
+#define TEST_BUS_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+
+class QProcess;
+
+// Private dbus-daemon with the stand-in nfcd (tests/mocknfcd) on it.
+// NFCSHARE_DBUS_ADDRESS gets pointed at it, which makes libnfcshare
+// talk to the mock rather than the real nfcd. That has to happen
+// before the first NdefApp is created, libnfcshare keeps reusing the
+// same connection after that.
+//
+// Calls to the mock don't block the event loop, the app has to keep
+// serving the reader while the mock is reading the tag.
+class TestBus :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    class Registrations {
+    public:
+        Registrations();
+        bool isEmpty() const;
+
+        uint iApps;
+        uint iModes;
+        uint iTechs;
+        uint iDropped;  // Left behind by the clients which have exited
+    };
+
+    class Read {
+    public:
+        Read();
+
+        QByteArray iNdef;
+        QList<uint> iLatencies; // Microseconds per C-APDU
+        uint iTotal;            // Microseconds
+        QString iError;
+    };
+
+    class Push {
+    public:
+        Push();
+
+        QByteArray iNdef;       // The last one received with Success
+        uint iConnections;
+        uint iContinues;
+        QString iError;
+    };
+
+    TestBus(QObject* aParent = Q_NULLPTR);
+    ~TestBus();
+
+    bool start();
+    QString address() const;
+
+    bool setReplyDelay(uint);
+    bool getRegistrations(Registrations&);
+    bool waitForRegistrations(Registrations&, int);
+    bool read(uint, Read&);
+    bool push(const QByteArray&, Push&);
+
+private:
+    QDBusMessage call(const QString&, const QVariantList&, int);
+    void stop();
+
+private:
+    QProcess* iDaemon;
+    QProcess* iMock;
+    QString iAddress;
+};
+
+#endif // TEST_BUS_H
@@ -0,0 +1,17 @@
+# Tests running libnfcshare against the stand-in nfcd on a private bus
+include(common.pri)
+
+QT += dbus
+
+LIBS += -L$$OUT_PWD/../../lib -lnfcshare
+QMAKE_RPATHDIR += $$OUT_PWD/../../lib
+
+DEFINES += MOCKNFCD=\\\"$$OUT_PWD/../mocknfcd/mocknfcd\\\"
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/testbus.h
+
+SOURCES += \
+    $$PWD/testbus.cpp
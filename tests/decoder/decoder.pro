@@ -0,0 +1,20 @@
+TARGET = test_decoder
+
+include(../common/common.pri)
+
+CONFIG += link_pkgconfig
+PKGCONFIG += zlib
+
+# Compressed messages come from libnfcshare, the decoder is compiled in
+LIBS += -L$$OUT_PWD/../../lib -lnfcshare
+QMAKE_RPATHDIR += $$OUT_PWD/../../lib
+
+DECODER_DIR = $$PWD/../../decoder
+INCLUDEPATH += $${DECODER_DIR}/include
+
+HEADERS += \
+    $${DECODER_DIR}/include/nfcsharez.h
+
+SOURCES += \
+    test_decoder.cpp \
+    $${DECODER_DIR}/src/nfcsharez.c
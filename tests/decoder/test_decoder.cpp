@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// libnfcsharez against what libnfcshare produces: compressed messages
+// must come back intact, anything truncated, mistyped or claiming to
+// unpack into more than the decoder allows must be rejected.
+
+#include "ndefrecord.h"
+#include "nfcsharez.h"
+
+#include <QtTest/QtTest>
+
+#include <stdlib.h>
+
+#define Z_METHOD_ZLIB (0x01)
+#define Z_HEADER_SIZE (5)
+#define Z_MAX_SIZE (0x1000000)  // Same as in nfcsharez.c
+
+class TestDecoder :
+    public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void type();
+    void roundTrip_data();
+    void roundTrip();
+    void notCompressed();
+    void truncated();
+    void wrongType_data();
+    void wrongType();
+    void wrongMethod();
+    void wrongSize_data();
+    void wrongSize();
+
+private:
+    static QByteArray text(int);
+    static QByteArray textRecord(int);
+    static QByteArray record(const QByteArray&,
+        NdefRecord::Tnf aTnf = NdefRecord::TnfExternal,
+        const QByteArray& aType = QByteArray(NFCSHARE_Z_TYPE));
+    static QByteArray payload(const QByteArray&, uint);
+    static QByteArray decode(const QByteArray&, bool* aOk = Q_NULLPTR);
+};
+
+//static
+QByteArray
+TestDecoder::text(
+    int aSize)
+{
+    // Repetitive enough to compress well
+    static const char words[] = "lorem ipsum dolor sit amet ";
+    QByteArray data;
+
+    data.reserve(aSize);
+    for (int i = 0; i < aSize; i++) {
+        data.append(words[(i * 7 / 5) % (sizeof(words) - 1)]);
+    }
+    return data;
+}
+
+//static
+QByteArray
+TestDecoder::textRecord(
+    int aSize)
+{
+    // Status byte, "en" and UTF-8 text
+    return NdefRecord::encode(NdefRecord::TnfWellKnown, QByteArray("T"),
+        QByteArray("\x02" "en") + text(aSize));
+}
+
+//static
+QByteArray
+TestDecoder::record(
+    const QByteArray& aPayload,
+    NdefRecord::Tnf aTnf,
+    const QByteArray& aType)
+{
+    return NdefRecord::encode(aTnf, aType, aPayload);
+}
+
+//static
+QByteArray
+TestDecoder::payload(
+    const QByteArray& aNdef,
+    uint aSize)
+{
+    // Method, big-endian size of the original, zlib stream. qCompress
+    // puts the size in front of the stream, it gets replaced here.
+    QByteArray data(qCompress(aNdef));
+
+    data[0] = (uchar)(aSize >> 24);
+    data[1] = (uchar)(aSize >> 16);
+    data[2] = (uchar)(aSize >> 8);
+    data[3] = (uchar)aSize;
+    data.prepend((char)Z_METHOD_ZLIB);
+    return data;
+}
+
+//static
+QByteArray
+TestDecoder::decode(
+    const QByteArray& aNdef,
+    bool* aOk)
+{
+    size_t size = 0;
+    void* data = nfcshare_z_decode(aNdef.constData(), aNdef.size(), &size);
+    QByteArray out;
+
+    if (data) {
+        out = QByteArray((const char*)data, (int)size);
+        free(data);
+    }
+    if (aOk) {
+        *aOk = (data != Q_NULLPTR);
+    }
+    return out;
+}
+
+void
+TestDecoder::type()
+{
+    // Both sides must agree on it
+    QCOMPARE(QByteArray(NdefRecord::COMPRESSED_TYPE),
+        QByteArray(NFCSHARE_Z_TYPE));
+}
+
+void
+TestDecoder::roundTrip_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("short") << 200;
+    QTest::newRow("medium") << 4096;
+    QTest::newRow("large") << 60000;
+}
+
+void
+TestDecoder::roundTrip()
+{
+    QFETCH(int, size);
+
+    const QByteArray ndef(textRecord(size));
+    const QByteArray z(NdefRecord::compress(ndef));
+    bool ok;
+
+    QVERIFY(!z.isEmpty());
+    QVERIFY(z.size() < ndef.size());
+    QVERIFY(nfcshare_z_detect(z.constData(), z.size()));
+    QCOMPARE(decode(z, &ok), ndef);
+    QVERIFY(ok);
+
+    // Output size is optional
+    void* data = nfcshare_z_decode(z.constData(), z.size(), Q_NULLPTR);
+
+    QVERIFY(data);
+    QVERIFY(!memcmp(data, ndef.constData(), ndef.size()));
+    free(data);
+}
+
+void
+TestDecoder::notCompressed()
+{
+    const QByteArray ndef(textRecord(200));
+    bool ok;
+
+    QVERIFY(!nfcshare_z_detect(ndef.constData(), ndef.size()));
+    QVERIFY(decode(ndef, &ok).isEmpty());
+    QVERIFY(!ok);
+    QVERIFY(!nfcshare_z_detect(Q_NULLPTR, 0));
+    QVERIFY(!nfcshare_z_decode(Q_NULLPTR, 0, Q_NULLPTR));
+}
+
+void
+TestDecoder::truncated()
+{
+    const QByteArray ndef(textRecord(4096));
+    const QByteArray z(NdefRecord::compress(ndef));
+    const QByteArray stream(payload(ndef, ndef.size()));
+    bool ok;
+
+    // Every prefix of the message, down to nothing
+    QVERIFY(!z.isEmpty());
+    for (int i = 0; i < z.size(); i++) {
+        QVERIFY(decode(z.left(i), &ok).isEmpty());
+        QVERIFY(!ok);
+    }
+
+    // A well-formed record with the zlib stream cut short
+    QCOMPARE(decode(record(stream)), ndef);
+    for (int i = 0; i < stream.size(); i += 7) {
+        QVERIFY(decode(record(stream.left(i)), &ok).isEmpty());
+        QVERIFY(!ok);
+    }
+}
+
+void
+TestDecoder::wrongType_data()
+{
+    QTest::addColumn<int>("tnf");
+    QTest::addColumn<QByteArray>("type");
+    QTest::addColumn<bool>("ok");
+
+    QTest::newRow("ok") << int(NdefRecord::TnfExternal) <<
+        QByteArray(NFCSHARE_Z_TYPE) << true;
+    QTest::newRow("case") << int(NdefRecord::TnfExternal) <<
+        QByteArray(NFCSHARE_Z_TYPE).toUpper() << true;
+    QTest::newRow("type") << int(NdefRecord::TnfExternal) <<
+        QByteArray("sailfishos.org:ndefx") << false;
+    QTest::newRow("shorter") << int(NdefRecord::TnfExternal) <<
+        QByteArray("sailfishos.org:ndef") << false;
+    QTest::newRow("longer") << int(NdefRecord::TnfExternal) <<
+        QByteArray("sailfishos.org:ndefzz") << false;
+    QTest::newRow("media") << int(NdefRecord::TnfMediaType) <<
+        QByteArray(NFCSHARE_Z_TYPE) << false;
+    QTest::newRow("well-known") << int(NdefRecord::TnfWellKnown) <<
+        QByteArray("T") << false;
+}
+
+void
+TestDecoder::wrongType()
+{
+    QFETCH(int, tnf);
+    QFETCH(QByteArray, type);
+    QFETCH(bool, ok);
+
+    const QByteArray ndef(textRecord(1024));
+    const QByteArray z(record(payload(ndef, ndef.size()),
+        (NdefRecord::Tnf)tnf, type));
+    bool decoded;
+
+    QCOMPARE(bool(nfcshare_z_detect(z.constData(), z.size())), ok);
+    QCOMPARE(decode(z, &decoded), ok ? ndef : QByteArray());
+    QCOMPARE(decoded, ok);
+}
+
+void
+TestDecoder::wrongMethod()
+{
+    const QByteArray ndef(textRecord(1024));
+    QByteArray data(payload(ndef, ndef.size()));
+    bool ok;
+
+    data[0] = (char)(Z_METHOD_ZLIB + 1);
+    QVERIFY(decode(record(data), &ok).isEmpty());
+    QVERIFY(!ok);
+}
+
+void
+TestDecoder::wrongSize_data()
+{
+    const int size = textRecord(1024).size();
+
+    QTest::addColumn<uint>("claimed");
+
+    QTest::newRow("zero") << 0u;
+    QTest::newRow("smaller") << uint(size - 1);
+    QTest::newRow("larger") << uint(size + 1);
+    QTest::newRow("cap") << uint(Z_MAX_SIZE);
+    QTest::newRow("inflated") << uint(Z_MAX_SIZE + 1);
+    QTest::newRow("max") << 0xffffffffu;
+}
+
+void
+TestDecoder::wrongSize()
+{
+    QFETCH(uint, claimed);
+
+    // The stream is fine, the size in front of it isn't
+    const QByteArray ndef(textRecord(1024));
+    bool ok;
+
+    QVERIFY(decode(record(payload(ndef, claimed)), &ok).isEmpty());
+    QVERIFY(!ok);
+}
+
+QTEST_GUILESS_MAIN(TestDecoder)
+#include "test_decoder.moc"
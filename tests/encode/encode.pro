@@ -0,0 +1,7 @@
+TARGET = test_encode
+
+include(../common/testbus.pri)
+include(../common/heapstats.pri)
+
+SOURCES += \
+    test_encode.cpp
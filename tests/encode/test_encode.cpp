@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// Encoding pipeline benchmark: NfcShare::setText() from the text to
+// NdefApp holding the NDEF file, i.e. URI detection, UTF-8 conversion,
+// libnfcdef record creation and the copy into the file buffer. The
+// D-Bus side is the stand-in nfcd, registration with it isn't waited
+// for. Reports time per setText() and the peak heap (on top of what
+// was allocated before the call) and number of allocations it takes.
+//
+// Each case cycles through more variants of its text than NdefCache
+// keeps in memory, so that every call goes through the encoder.
+
+#include "heapstats.h"
+#include "ndefapp.h"
+#include "nfcshare.h"
+#include "testbus.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtTest/QtTest>
+
+#define VARIANTS (16)               // More than NdefCache::MAX_ENTRIES
+#define SETTLE_TIMEOUT_MS (5000)
+#define CALIBRATION_CHARS (1000)    // Long enough for a long record
+
+#define NFCSHARE_CACHE_DIR_ENV "NFCSHARE_CACHE_DIR"
+
+static const char URL_PREFIX[] = "https://www.example.com/";
+
+class TestEncode :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Script {
+        ScriptAscii,
+        ScriptLatin1,
+        ScriptCjk,
+        ScriptEmoji,
+        ScriptMixed,
+        ScriptUrl
+    };
+
+private:
+    class Result {
+    public:
+        QString iName;
+        int iChars;
+        uint iNdefSize;
+        bool iTooMuchData;
+        qreal iMicroseconds;
+        size_t iPeakHeap;
+        unsigned long iAllocs;
+    };
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+    void encode_data();
+    void encode();
+
+private:
+    static QString text(Script, int, int);
+    static uint ndefSize(const QString&);
+
+private:
+    TestBus iBus;
+    int iTextOverhead;  // NDEF bytes on top of ASCII chars, Text record
+    int iUrlOverhead;   // Same for the URI record
+    QList<Result> iResults;
+};
+
+//static
+QString
+TestEncode::text(
+    Script aScript,
+    int aChars,
+    int aSeed)
+{
+    // The seed changes the characters but not the byte count
+    static const uint mixed[] = {
+        0x0041,     // Latin
+        0x00c0,     // Latin-1 Supplement
+        0x0410,     // Cyrillic
+        0x0391,     // Greek
+        0x0627,     // Arabic
+        0x4e00,     // CJK
+        0x1f600     // Emoji
+    };
+    static const int nmixed = sizeof(mixed)/sizeof(mixed[0]);
+    QString s;
+    int i = 0;
+
+    s.reserve(2 * aChars);
+    if (aScript == ScriptUrl) {
+        s.append(QLatin1String(URL_PREFIX));
+        i = s.length();
+    }
+    for (; i < aChars; i++) {
+        const int k = i + aSeed;
+        uint c;
+
+        switch (aScript) {
+        case ScriptLatin1:
+            c = 0xc0 + k % 0x40;
+            break;
+        case ScriptCjk:
+            c = 0x4e00 + (k * 7) % 0x5000;
+            break;
+        case ScriptEmoji:
+            c = 0x1f600 + k % 0x50;
+            break;
+        case ScriptMixed:
+            // Blocks of 8 characters of each script
+            c = mixed[(i / 8) % nmixed] + aSeed % 8;
+            break;
+        case ScriptUrl:
+        case ScriptAscii:
+        default:
+            c = (i % 8 == 7 && aScript == ScriptAscii) ? ' ' :
+                ('a' + k % 26);
+            break;
+        }
+        s.append(QString::fromUcs4(&c, 1));
+    }
+    return s;
+}
+
+//static
+uint
+TestEncode::ndefSize(
+    const QString& aText)
+{
+    NfcShare share;
+
+    share.setText(aText);
+    return share.getBytesTotal();
+}
+
+void
+TestEncode::initTestCase()
+{
+    // Nothing but the in-memory cache
+    qunsetenv(NFCSHARE_CACHE_DIR_ENV);
+    QVERIFY(iBus.start());
+
+    // The language code depends on the locale, measure the overhead
+    // rather than assuming it
+    iTextOverhead = ndefSize(text(ScriptAscii, CALIBRATION_CHARS, 0)) -
+        CALIBRATION_CHARS;
+    iUrlOverhead = ndefSize(text(ScriptUrl, CALIBRATION_CHARS, 0)) -
+        CALIBRATION_CHARS;
+    QVERIFY(iTextOverhead > 0);
+}
+
+void
+TestEncode::cleanupTestCase()
+{
+    QTextStream out(stdout);
+
+    out << "\ncase                     chars   NDEF  fits   setText,us"
+        "  peak heap,KiB  allocs\n";
+    for (int i = 0; i < iResults.count(); i++) {
+        const Result& r = iResults.at(i);
+
+        out << qSetFieldWidth(22) << left << r.iName << right <<
+            qSetFieldWidth(8) << r.iChars <<
+            qSetFieldWidth(7) << r.iNdefSize <<
+            qSetFieldWidth(6) << (r.iTooMuchData ? "no" : "yes") <<
+            qSetFieldWidth(13) << QString::number(r.iMicroseconds, 'f', 1) <<
+            qSetFieldWidth(15) << QString::number(r.iPeakHeap / 1024.0,
+                'f', 1) <<
+            qSetFieldWidth(8) << (qulonglong)r.iAllocs <<
+            qSetFieldWidth(0) << "\n";
+    }
+}
+
+void
+TestEncode::cleanup()
+{
+    // Let the mock forget the apps created by the case
+    TestBus::Registrations left;
+
+    QVERIFY(iBus.waitForRegistrations(left, SETTLE_TIMEOUT_MS));
+    QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+}
+
+void
+TestEncode::encode_data()
+{
+    static const struct {
+        Script script;
+        const char* name;
+    } scripts[] = {
+        { ScriptAscii, "ascii" },
+        { ScriptLatin1, "latin1" },
+        { ScriptCjk, "cjk" },
+        { ScriptEmoji, "emoji" },
+        { ScriptMixed, "mixed" }
+    };
+    static const int lengths[] = { 16, 256, 4096, 16384, 32768 };
+    static const int urls[] = { 32, 64, 128, 255, 256, 1024, 4096, 32768 };
+    const int max = NdefApp::maxMessageSize();
+
+    QTest::addColumn<int>("script");
+    QTest::addColumn<int>("chars");
+    for (uint i = 0; i < sizeof(scripts)/sizeof(scripts[0]); i++) {
+        for (uint k = 0; k < sizeof(lengths)/sizeof(lengths[0]); k++) {
+            QTest::newRow(QString("%1/%2").arg(scripts[i].name).
+                arg(lengths[k]).toLatin1()) << int(scripts[i].script) <<
+                lengths[k];
+        }
+    }
+    for (uint k = 0; k < sizeof(urls)/sizeof(urls[0]); k++) {
+        QTest::newRow(QString("url/%1").arg(urls[k]).toLatin1()) <<
+            int(ScriptUrl) << urls[k];
+    }
+
+    // Around the largest message that still fits into the tag
+    for (int d = -1; d <= 1; d++) {
+        const QString suffix(d ? QString::number(d) : QString());
+
+        QTest::newRow(QString("ascii/max%1").arg(suffix).toLatin1()) <<
+            int(ScriptAscii) << (max - iTextOverhead + d);
+        QTest::newRow(QString("url/max%1").arg(suffix).toLatin1()) <<
+            int(ScriptUrl) << (max - iUrlOverhead + d);
+    }
+}
+
+void
+TestEncode::encode()
+{
+    QFETCH(int, script);
+    QFETCH(int, chars);
+
+    const Script s = (Script)script;
+    const uint max = NdefApp::maxMessageSize();
+    QStringList variants;
+    NfcShare share;
+    HeapStats before, after;
+    Result result;
+
+    for (int i = 0; i < VARIANTS; i++) {
+        variants.append(text(s, chars, i));
+    }
+
+    // One call, measured for memory
+    heap_stats_get(&before);
+    heap_stats_reset_peak();
+    share.setText(variants.at(0));
+    heap_stats_get(&after);
+
+    result.iName = QString(QTest::currentDataTag());
+    result.iChars = chars;
+    result.iNdefSize = share.getBytesTotal();
+    result.iTooMuchData = share.isTooMuchData();
+    result.iPeakHeap = after.peak - before.current;
+    result.iAllocs = after.allocs - before.allocs;
+
+    // The boundary cases must land where they are supposed to
+    QVERIFY(result.iTooMuchData == (result.iNdefSize > max));
+    if (QByteArray(QTest::currentDataTag()).endsWith("/max")) {
+        QCOMPARE(result.iNdefSize, max);
+    }
+
+    // And then for time
+    QElapsedTimer timer;
+    int n = 0;
+
+    timer.start();
+    QBENCHMARK {
+        share.setText(variants.at(++n % VARIANTS));
+    }
+    result.iMicroseconds = timer.nsecsElapsed() / 1e3 / n;
+    iResults.append(result);
+}
+
+QTEST_GUILESS_MAIN(TestEncode)
+#include "test_encode.moc"
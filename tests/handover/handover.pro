@@ -0,0 +1,6 @@
+TARGET = test_handover
+
+include(../common/testbus.pri)
+
+SOURCES += \
+    test_handover.cpp
@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// Connection handover: the Handover Select message NfcShareBearer
+// builds, and NfcShare switching from tooMuchData to handover once a
+// valid bearer is set, with the stand-in nfcd reading the tag.
+
+#include "ndefapp.h"
+#include "nfcshare.h"
+#include "nfcsharebearer.h"
+#include "testbus.h"
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+#define WAIT_TIMEOUT_MS (10000)
+#define CLEANUP_TIMEOUT_MS (2000)
+
+#define NDEF_FLAG_MB (0x80)
+#define NDEF_FLAG_ME (0x40)
+#define NDEF_FLAG_SR (0x10)
+#define NDEF_FLAG_IL (0x08)
+#define NDEF_TNF_MASK (0x07)
+#define NDEF_TNF_WELL_KNOWN (0x01)
+#define NDEF_TNF_MEDIA_TYPE (0x02)
+
+#define HANDOVER_VERSION (0x12)
+#define CARRIER_ID "0"
+
+// Stand-in for a Bluetooth OOB or HTTP service, only keeps track
+// of what it's been offered
+class TestBearer :
+    public NfcShareBearer
+{
+    Q_OBJECT
+
+public:
+    TestBearer(QObject* aParent = Q_NULLPTR);
+
+private Q_SLOTS:
+    void onContentOffered(QString);
+    void onContentWithdrawn();
+
+public:
+    QStringList iOffered;
+    int iWithdrawn;
+};
+
+TestBearer::TestBearer(
+    QObject* aParent) :
+    NfcShareBearer(aParent),
+    iWithdrawn(0)
+{
+    connect(this, SIGNAL(contentOffered(QString)),
+        SLOT(onContentOffered(QString)));
+    connect(this, SIGNAL(contentWithdrawn()), SLOT(onContentWithdrawn()));
+}
+
+void
+TestBearer::onContentOffered(
+    QString aText)
+{
+    iOffered.append(aText);
+}
+
+void
+TestBearer::onContentWithdrawn()
+{
+    iWithdrawn++;
+}
+
+class TestHandover :
+    public QObject
+{
+    Q_OBJECT
+
+private:
+    class Record {
+    public:
+        Record();
+
+        uchar iFlags;   // Without TNF
+        uchar iTnf;
+        QByteArray iType;
+        QByteArray iId;
+        QByteArray iPayload;
+    };
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void invalid();
+    void handoverSelect_data();
+    void handoverSelect();
+    void share();
+
+private:
+    static QList<Record> parse(const QByteArray&);
+
+private:
+    TestBus iBus;
+};
+
+TestHandover::Record::Record() :
+    iFlags(0),
+    iTnf(0)
+{
+}
+
+//static
+QList<TestHandover::Record>
+TestHandover::parse(
+    const QByteArray& aNdef)
+{
+    // Empty list if anything is wrong with it
+    const uchar* p = (const uchar*)aNdef.constData();
+    const int n = aNdef.size();
+    QList<Record> records;
+    int off = 0;
+
+    while (off < n) {
+        Record rec;
+        const uchar hdr = p[off++];
+        uint typeLen, idLen = 0, payloadLen = 0;
+
+        rec.iFlags = hdr & ~NDEF_TNF_MASK;
+        rec.iTnf = hdr & NDEF_TNF_MASK;
+        if (off >= n) {
+            return QList<Record>();
+        }
+        typeLen = p[off++];
+        if (hdr & NDEF_FLAG_SR) {
+            if (off + 1 > n) {
+                return QList<Record>();
+            }
+            payloadLen = p[off++];
+        } else {
+            if (off + 4 > n) {
+                return QList<Record>();
+            }
+            for (int i = 0; i < 4; i++) {
+                payloadLen = (payloadLen << 8) | p[off++];
+            }
+        }
+        if (hdr & NDEF_FLAG_IL) {
+            if (off >= n) {
+                return QList<Record>();
+            }
+            idLen = p[off++];
+        }
+        if (uint(n - off) < typeLen + idLen + payloadLen) {
+            return QList<Record>();
+        }
+        rec.iType = aNdef.mid(off, typeLen);
+        off += typeLen;
+        rec.iId = aNdef.mid(off, idLen);
+        off += idLen;
+        rec.iPayload = aNdef.mid(off, payloadLen);
+        off += payloadLen;
+        records.append(rec);
+    }
+    return records;
+}
+
+void
+TestHandover::initTestCase()
+{
+    QVERIFY(iBus.start());
+}
+
+void
+TestHandover::cleanup()
+{
+    TestBus::Registrations left;
+
+    QVERIFY(iBus.waitForRegistrations(left, CLEANUP_TIMEOUT_MS));
+    QVERIFY(left.isEmpty());
+}
+
+void
+TestHandover::invalid()
+{
+    TestBearer bearer;
+    QSignalSpy validSpy(&bearer, SIGNAL(validChanged()));
+
+    // Needs either the carrier type or the URI
+    QVERIFY(!bearer.isValid());
+    QVERIFY(bearer.handoverSelect().isEmpty());
+    bearer.setCarrierData(QByteArray("data"));
+    QVERIFY(!bearer.isValid());
+    QCOMPARE(validSpy.count(), 0);
+    bearer.setUri("http://localhost/");
+    QVERIFY(bearer.isValid());
+    QCOMPARE(validSpy.count(), 1);
+    bearer.setUri(QString());
+    QVERIFY(!bearer.isValid());
+    QCOMPARE(validSpy.count(), 2);
+}
+
+void
+TestHandover::handoverSelect_data()
+{
+    QTest::addColumn<QString>("carrierType");
+    QTest::addColumn<QByteArray>("carrierData");
+    QTest::addColumn<QString>("uri");
+    QTest::addColumn<int>("powerState");
+
+    QTest::newRow("carrier") <<
+        QString("application/vnd.bluetooth.ep.oob") <<
+        QByteArray::fromHex("0800112233445566") << QString() <<
+        int(NfcShareBearer::Active);
+    QTest::newRow("carrier/activating") <<
+        QString("application/vnd.wfa.p2p") << QByteArray() << QString() <<
+        int(NfcShareBearer::Activating);
+    QTest::newRow("uri") << QString() << QByteArray() <<
+        QString("http://192.168.1.2:8080/share") <<
+        int(NfcShareBearer::Active);
+    QTest::newRow("uri/inactive") << QString() << QByteArray() <<
+        QString::fromUtf8("http://localhost/päth") <<
+        int(NfcShareBearer::Inactive);
+}
+
+void
+TestHandover::handoverSelect()
+{
+    QFETCH(QString, carrierType);
+    QFETCH(QByteArray, carrierData);
+    QFETCH(QString, uri);
+    QFETCH(int, powerState);
+
+    TestBearer bearer;
+
+    bearer.setCarrierType(carrierType);
+    bearer.setCarrierData(carrierData);
+    bearer.setUri(uri);
+    bearer.setPowerState((NfcShareBearer::PowerState)powerState);
+    QVERIFY(bearer.isValid());
+
+    // Handover Select record followed by the carrier record
+    const QList<Record> records(parse(bearer.handoverSelect()));
+
+    QCOMPARE(records.count(), 2);
+
+    const Record& hs = records.at(0);
+
+    QCOMPARE(int(hs.iFlags & (NDEF_FLAG_MB | NDEF_FLAG_ME)),
+        NDEF_FLAG_MB);
+    QCOMPARE(int(hs.iTnf), NDEF_TNF_WELL_KNOWN);
+    QCOMPARE(hs.iType, QByteArray("Hs"));
+    QVERIFY(!hs.iPayload.isEmpty());
+    QCOMPARE(int((uchar)hs.iPayload.at(0)), HANDOVER_VERSION);
+
+    // Exactly one Alternative Carrier record pointing to the carrier
+    const QList<Record> acs(parse(hs.iPayload.mid(1)));
+
+    QCOMPARE(acs.count(), 1);
+
+    const Record& ac = acs.at(0);
+    QByteArray acPayload;
+
+    acPayload.append((char)powerState);
+    acPayload.append((char)1);
+    acPayload.append(CARRIER_ID);
+    acPayload.append((char)0);
+    QCOMPARE(int(ac.iFlags & (NDEF_FLAG_MB | NDEF_FLAG_ME)),
+        NDEF_FLAG_MB | NDEF_FLAG_ME);
+    QCOMPARE(int(ac.iTnf), NDEF_TNF_WELL_KNOWN);
+    QCOMPARE(ac.iType, QByteArray("ac"));
+    QCOMPARE(ac.iPayload, acPayload);
+
+    // The carrier record itself, identified by the reference
+    const Record& carrier = records.at(1);
+
+    QCOMPARE(int(carrier.iFlags & (NDEF_FLAG_MB | NDEF_FLAG_ME)),
+        NDEF_FLAG_ME);
+    QCOMPARE(carrier.iId, QByteArray(CARRIER_ID));
+    if (carrierType.isEmpty()) {
+        QCOMPARE(int(carrier.iTnf), NDEF_TNF_WELL_KNOWN);
+        QCOMPARE(carrier.iType, QByteArray("U"));
+        QCOMPARE(carrier.iPayload, QByteArray(1, 0) + uri.toUtf8());
+    } else {
+        QCOMPARE(int(carrier.iTnf), NDEF_TNF_MEDIA_TYPE);
+        QCOMPARE(carrier.iType, carrierType.toLatin1());
+        QCOMPARE(carrier.iPayload, carrierData);
+    }
+}
+
+void
+TestHandover::share()
+{
+    const QString text(NdefApp::maxMessageSize() + 1, QChar('a'));
+    TestBearer bearer;
+    NfcShare share;
+    QSignalSpy tooMuchDataSpy(&share, SIGNAL(tooMuchDataChanged()));
+    QSignalSpy handoverSpy(&share, SIGNAL(handoverChanged()));
+    QSignalSpy readySpy(&share, SIGNAL(readyChanged()));
+
+    // Doesn't fit and there's nowhere to hand it over
+    share.setText(text);
+    QVERIFY(share.isTooMuchData());
+    QVERIFY(!share.isHandover());
+    QCOMPARE(tooMuchDataSpy.count(), 1);
+
+    // The bearer has to be valid to make a difference
+    share.setBearer(&bearer);
+    QVERIFY(share.isTooMuchData());
+    QVERIFY(!share.isHandover());
+    QVERIFY(bearer.iOffered.isEmpty());
+
+    bearer.setUri("http://192.168.1.2:8080/share");
+    QVERIFY(!share.isTooMuchData());
+    QVERIFY(share.isHandover());
+    QCOMPARE(tooMuchDataSpy.count(), 2);
+    QCOMPARE(handoverSpy.count(), 1);
+
+    // The bearer may get the content offered again as its properties
+    // change, but the previous offer is always withdrawn first
+    QVERIFY(!bearer.iOffered.isEmpty());
+    QCOMPARE(bearer.iOffered.last(), text);
+    QCOMPARE(bearer.iWithdrawn, bearer.iOffered.count() - 1);
+
+    // What the reader gets is the Handover Select message
+    QVERIFY(share.isReady() || readySpy.wait(WAIT_TIMEOUT_MS));
+    QCOMPARE(share.getBytesTotal(), uint(bearer.handoverSelect().size() + 2));
+
+    TestBus::Read read;
+
+    QVERIFY2(iBus.read(0, read), qPrintable(read.iError));
+    QCOMPARE(read.iNdef, bearer.handoverSelect());
+
+    // Text which fits goes straight into the tag
+    share.setText("short");
+    QVERIFY(!share.isTooMuchData());
+    QVERIFY(!share.isHandover());
+    QCOMPARE(handoverSpy.count(), 2);
+    QCOMPARE(bearer.iWithdrawn, bearer.iOffered.count());
+}
+
+QTEST_GUILESS_MAIN(TestHandover)
+#include "test_handover.moc"
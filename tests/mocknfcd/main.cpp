@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// Stand-in nfcd for tests and benchmarks. Runs until the bus goes away.
+
+#include "mocknfcd.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+
+#define RET_OK (0)
+#define RET_ERR (2)
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args(app.arguments());
+
+    // Same variable as libnfcshare looks at, unless given explicitly
+    const QString address(args.count() > 1 ? args.at(1) :
+        QString::fromLocal8Bit(qgetenv("NFCSHARE_DBUS_ADDRESS")));
+
+    if (address.isEmpty()) {
+        QTextStream(stderr) << "Usage: mocknfcd ADDRESS\n";
+        return RET_ERR;
+    }
+
+    QDBusConnection bus(QDBusConnection::connectToBus(address,
+        QStringLiteral("mocknfcd")));
+
+    if (!bus.isConnected()) {
+        QTextStream(stderr) << "Failed to connect to " << address << "\n";
+        return RET_ERR;
+    }
+
+    MockNfcd mock(bus);
+
+    if (!mock.start()) {
+        QTextStream(stderr) << "Failed to register nfcd services\n";
+        return RET_ERR;
+    }
+
+    bus.connect(QString(), "/org/freedesktop/DBus/Local",
+        "org.freedesktop.DBus.Local", "Disconnected", &app, SLOT(quit()));
+    return app.exec() ? RET_ERR : RET_OK;
+}
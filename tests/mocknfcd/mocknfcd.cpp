@@ -0,0 +1,1010 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mocknfcd.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+#include <QtCore/QVariant>
+#include <QtDBus/QDBusAbstractAdaptor>
+#include <QtDBus/QDBusObjectPath>
+#include <QtDBus/QDBusUnixFileDescriptor>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define ERROR_FAILED "org.sailfishos.nfc.Error.Failed"
+#define ERROR_NOT_FOUND "org.sailfishos.nfc.Error.NotFound"
+#define ERROR_ACCESS_DENIED "org.sailfishos.nfc.Error.AccessDenied"
+
+#define NFCD_INTERFACE_VERSION (4)
+#define APP_FLAG_IMPLICIT_SELECTION (0x01)
+#define HOST_TECHNOLOGY_NFC_A (0x01)
+
+#define ISO_CLA (0x00)
+#define ISO_INS_SELECT (0xa4)
+#define ISO_INS_READ_BINARY (0xb0)
+#define ISO_INS_READ_BINARY_ODO (0xb1)
+#define ISO_TAG_OFFSET (0x54)
+#define ISO_TAG_DISCRETIONARY (0x53)
+#define ISO_MAX_P1P2_OFFSET (0x7fff)
+#define SW_OK (0x9000)
+#define SW_END_OF_FILE (0x6282)
+
+#define CC_SIZE (15)
+#define CC_MLE_OFFSET (3)
+#define CC_NDEF_FID_OFFSET (9)
+
+#define SNEP_VERSION (0x10)
+#define SNEP_HEADER_SIZE (6)
+#define SNEP_RESPONSE_CONTINUE (0x80)
+#define SNEP_RESPONSE_SUCCESS (0x81)
+#define SNEP_FIRST_FRAGMENT_SIZE (128)
+#define SNEP_MAX_PACKET_SIZE (0x10000)
+
+#define CALL_TIMEOUT_MS (5000)
+
+static const uchar ndef_aid[] = { 0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01 };
+static const uchar cc_fid[] = { 0xe1, 0x03 };
+
+const QString MockNfcd::DAEMON_SERVICE("org.sailfishos.nfc.daemon");
+const QString MockNfcd::SETTINGS_SERVICE("org.sailfishos.nfc.settings");
+const QString MockNfcd::CONTROL_PATH("/mock");
+const QString MockNfcd::CONTROL_INTERFACE("org.sailfishos.nfc.Mock");
+
+static const QString ADAPTER_PATH("/nfc0");
+static const QString HOST_PATH("/nfc0/host0");
+static const QString PEER_PATH("/nfc0/peer0");
+static const QString SNEP_SERVICE_NAME("urn:nfc:sn:snep");
+static const QString LOCAL_HOST_APP_INTERFACE("org.sailfishos.nfc.LocalHostApp");
+
+// ==========================================================================
+// MockNfcd::DaemonAdaptor
+// ==========================================================================
+
+class MockNfcd::DaemonAdaptor :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfc.Daemon")
+
+public:
+    DaemonAdaptor(MockNfcd*, QObject*);
+
+public Q_SLOTS:
+    int GetInterfaceVersion();
+    QList<QDBusObjectPath> GetAdapters();
+    void RegisterLocalHostApp(QDBusObjectPath, QString, QByteArray, uint,
+        const QDBusMessage&);
+    void UnregisterLocalHostApp(QDBusObjectPath, const QDBusMessage&);
+    void RequestMode(uint, uint, const QDBusMessage&);
+    void ReleaseMode(uint, const QDBusMessage&);
+    void RequestTechs(uint, uint, const QDBusMessage&);
+    void ReleaseTechs(uint, const QDBusMessage&);
+
+private:
+    MockNfcd* iMock;
+};
+
+MockNfcd::DaemonAdaptor::DaemonAdaptor(
+    MockNfcd* aMock,
+    QObject* aParent) :
+    QDBusAbstractAdaptor(aParent),
+    iMock(aMock)
+{
+}
+
+int
+MockNfcd::DaemonAdaptor::GetInterfaceVersion()
+{
+    return NFCD_INTERFACE_VERSION;
+}
+
+QList<QDBusObjectPath>
+MockNfcd::DaemonAdaptor::GetAdapters()
+{
+    return QList<QDBusObjectPath>() << QDBusObjectPath(ADAPTER_PATH);
+}
+
+void
+MockNfcd::DaemonAdaptor::RegisterLocalHostApp(
+    QDBusObjectPath aPath,
+    QString,
+    QByteArray aAid,
+    uint aFlags,
+    const QDBusMessage& aMessage)
+{
+    iMock->registerApp(aPath.path(), aAid, aFlags, aMessage);
+}
+
+void
+MockNfcd::DaemonAdaptor::UnregisterLocalHostApp(
+    QDBusObjectPath aPath,
+    const QDBusMessage& aMessage)
+{
+    iMock->unregisterApp(aPath.path(), aMessage);
+}
+
+void
+MockNfcd::DaemonAdaptor::RequestMode(
+    uint,
+    uint,
+    const QDBusMessage& aMessage)
+{
+    iMock->request(iMock->iModes, aMessage);
+}
+
+void
+MockNfcd::DaemonAdaptor::ReleaseMode(
+    uint aId,
+    const QDBusMessage& aMessage)
+{
+    iMock->release(iMock->iModes, aId, aMessage);
+}
+
+void
+MockNfcd::DaemonAdaptor::RequestTechs(
+    uint,
+    uint,
+    const QDBusMessage& aMessage)
+{
+    iMock->request(iMock->iTechs, aMessage);
+}
+
+void
+MockNfcd::DaemonAdaptor::ReleaseTechs(
+    uint aId,
+    const QDBusMessage& aMessage)
+{
+    iMock->release(iMock->iTechs, aId, aMessage);
+}
+
+// ==========================================================================
+// MockNfcd::SettingsAdaptor
+// ==========================================================================
+
+class MockNfcd::SettingsAdaptor :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfc.Settings")
+
+public:
+    SettingsAdaptor(QObject*);
+
+public Q_SLOTS:
+    int GetInterfaceVersion();
+    bool GetEnabled();
+};
+
+MockNfcd::SettingsAdaptor::SettingsAdaptor(
+    QObject* aParent) :
+    QDBusAbstractAdaptor(aParent)
+{
+}
+
+int
+MockNfcd::SettingsAdaptor::GetInterfaceVersion()
+{
+    return 1;
+}
+
+bool
+MockNfcd::SettingsAdaptor::GetEnabled()
+{
+    return true;
+}
+
+// ==========================================================================
+// MockNfcd::AdapterAdaptor
+// ==========================================================================
+
+class MockNfcd::AdapterAdaptor :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfc.Adapter")
+
+public:
+    AdapterAdaptor(MockNfcd*, QObject*);
+
+public Q_SLOTS:
+    bool GetEnabled();
+    bool GetPowered();
+    QList<QDBusObjectPath> GetPeers();
+
+Q_SIGNALS:
+    void PeersChanged(QList<QDBusObjectPath>);
+
+private:
+    MockNfcd* iMock;
+};
+
+MockNfcd::AdapterAdaptor::AdapterAdaptor(
+    MockNfcd* aMock,
+    QObject* aParent) :
+    QDBusAbstractAdaptor(aParent),
+    iMock(aMock)
+{
+}
+
+bool
+MockNfcd::AdapterAdaptor::GetEnabled()
+{
+    return true;
+}
+
+bool
+MockNfcd::AdapterAdaptor::GetPowered()
+{
+    return true;
+}
+
+QList<QDBusObjectPath>
+MockNfcd::AdapterAdaptor::GetPeers()
+{
+    // The peer is only there while Push is in progress
+    return iMock->peers();
+}
+
+// ==========================================================================
+// MockNfcd::HostAdaptor
+// ==========================================================================
+
+class MockNfcd::HostAdaptor :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfc.Host")
+
+public:
+    HostAdaptor(QObject*);
+
+public Q_SLOTS:
+    uint GetTechnology();
+};
+
+MockNfcd::HostAdaptor::HostAdaptor(
+    QObject* aParent) :
+    QDBusAbstractAdaptor(aParent)
+{
+}
+
+uint
+MockNfcd::HostAdaptor::GetTechnology()
+{
+    return HOST_TECHNOLOGY_NFC_A;
+}
+
+// ==========================================================================
+// MockNfcd::PeerAdaptor
+// ==========================================================================
+
+class MockNfcd::PeerAdaptor :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfc.Peer")
+
+public:
+    PeerAdaptor(MockNfcd*, QObject*);
+
+public Q_SLOTS:
+    void ConnectServiceName(QString, const QDBusMessage&);
+
+private:
+    MockNfcd* iMock;
+};
+
+MockNfcd::PeerAdaptor::PeerAdaptor(
+    MockNfcd* aMock,
+    QObject* aParent) :
+    QDBusAbstractAdaptor(aParent),
+    iMock(aMock)
+{
+}
+
+void
+MockNfcd::PeerAdaptor::ConnectServiceName(
+    QString aServiceName,
+    const QDBusMessage& aMessage)
+{
+    iMock->connectServiceName(aServiceName, aMessage);
+}
+
+// ==========================================================================
+// MockNfcd::ControlAdaptor
+// ==========================================================================
+
+class MockNfcd::ControlAdaptor :
+    public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.sailfishos.nfc.Mock")
+
+public:
+    ControlAdaptor(MockNfcd*, QObject*);
+
+public Q_SLOTS:
+    void SetReplyDelay(uint);
+    void GetRegistrations(const QDBusMessage&);
+    void Read(uint, const QDBusMessage&);
+    void Push(QByteArray, const QDBusMessage&);
+
+private:
+    MockNfcd* iMock;
+};
+
+MockNfcd::ControlAdaptor::ControlAdaptor(
+    MockNfcd* aMock,
+    QObject* aParent) :
+    QDBusAbstractAdaptor(aParent),
+    iMock(aMock)
+{
+}
+
+void
+MockNfcd::ControlAdaptor::SetReplyDelay(
+    uint aMs)
+{
+    iMock->iReplyDelay = aMs;
+}
+
+void
+MockNfcd::ControlAdaptor::GetRegistrations(
+    const QDBusMessage& aMessage)
+{
+    iMock->registrations(aMessage);
+}
+
+void
+MockNfcd::ControlAdaptor::Read(
+    uint aLe,
+    const QDBusMessage& aMessage)
+{
+    iMock->read(aLe, aMessage);
+}
+
+void
+MockNfcd::ControlAdaptor::Push(
+    QByteArray aResponses,
+    const QDBusMessage& aMessage)
+{
+    iMock->push(aResponses, aMessage);
+}
+
+// ==========================================================================
+// MockNfcd::Reader
+//
+// Scripted NFC Forum Type 4 tag reader. Makes blocking calls, nothing
+// else happens in the mock while the tag is being read.
+// ==========================================================================
+
+class MockNfcd::Reader
+{
+public:
+    Reader(QDBusConnection, const App&);
+
+    bool readNdef(uint, QByteArray&);
+
+private:
+    bool call(const QString&, const QVariantList& aArgs = QVariantList());
+    bool hostCall(const QString&);
+    uint apdu(uchar, uchar, uchar, const QByteArray&, uint, QByteArray*);
+    bool selectFile(const QByteArray&);
+    bool readBinary(uint, uint, QByteArray&);
+
+public:
+    QList<uint> iLatencies;     // Microseconds
+    QString iError;
+
+private:
+    QDBusConnection iBus;
+    const App iApp;
+};
+
+MockNfcd::Reader::Reader(
+    QDBusConnection aBus,
+    const App& aApp) :
+    iBus(aBus),
+    iApp(aApp)
+{
+}
+
+bool
+MockNfcd::Reader::call(
+    const QString& aMethod,
+    const QVariantList& aArgs)
+{
+    QDBusMessage msg(QDBusMessage::createMethodCall(iApp.iOwner,
+        iApp.iPath, LOCAL_HOST_APP_INTERFACE, aMethod));
+
+    msg.setArguments(aArgs);
+    const QDBusMessage reply(iBus.call(msg, QDBus::Block, CALL_TIMEOUT_MS));
+
+    if (reply.type() == QDBusMessage::ReplyMessage) {
+        return true;
+    } else {
+        iError = aMethod + ": " + reply.errorMessage();
+        return false;
+    }
+}
+
+bool
+MockNfcd::Reader::hostCall(
+    const QString& aMethod)
+{
+    return call(aMethod, QVariantList() <<
+        QVariant::fromValue(QDBusObjectPath(HOST_PATH)));
+}
+
+uint
+MockNfcd::Reader::apdu(
+    uchar aIns,
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData,
+    uint aLe,
+    QByteArray* aResponse)
+{
+    QDBusMessage msg(QDBusMessage::createMethodCall(iApp.iOwner,
+        iApp.iPath, LOCAL_HOST_APP_INTERFACE, "Process"));
+    QElapsedTimer timer;
+
+    msg << QVariant::fromValue(QDBusObjectPath(HOST_PATH))
+        << QVariant::fromValue((uchar)ISO_CLA)
+        << QVariant::fromValue(aIns)
+        << QVariant::fromValue(aP1)
+        << QVariant::fromValue(aP2)
+        << aData
+        << aLe;
+    timer.start();
+    const QDBusMessage reply(iBus.call(msg, QDBus::Block, CALL_TIMEOUT_MS));
+    const QVariantList args(reply.arguments());
+
+    iLatencies.append(timer.nsecsElapsed() / 1000);
+    if (reply.type() != QDBusMessage::ReplyMessage || args.size() != 4) {
+        iError = QString("Process: ") + reply.errorMessage();
+        return 0;
+    }
+
+    const uint sw = ((uint)args.at(1).value<uchar>() << 8) |
+        args.at(2).value<uchar>();
+    const uint id = args.at(3).toUInt();
+
+    if (aResponse) {
+        *aResponse = args.at(0).toByteArray();
+    }
+    if (id) {
+        // nfcd tells the app whether the response has made it
+        call("ResponseStatus", QVariantList() << id << true);
+    }
+    if (sw != SW_OK && sw != SW_END_OF_FILE) {
+        iError = QString("INS %1 P1-P2 %2 failed with %3").
+            arg(aIns, 2, 16, QChar('0')).
+            arg(((uint)aP1 << 8) | aP2, 4, 16, QChar('0')).
+            arg(sw, 4, 16, QChar('0'));
+    }
+    return sw;
+}
+
+bool
+MockNfcd::Reader::selectFile(
+    const QByteArray& aFid)
+{
+    return apdu(ISO_INS_SELECT, 0x00, 0x0c, aFid, 0, Q_NULLPTR) == SW_OK;
+}
+
+bool
+MockNfcd::Reader::readBinary(
+    uint aOffset,
+    uint aLe,
+    QByteArray& aData)
+{
+    uint sw;
+
+    if (aOffset <= ISO_MAX_P1P2_OFFSET) {
+        sw = apdu(ISO_INS_READ_BINARY, (uchar)(aOffset >> 8),
+            (uchar)aOffset, QByteArray(), aLe, &aData);
+    } else {
+        // The offset doesn't fit into P1-P2
+        QByteArray odo;
+
+        odo.append((char)ISO_TAG_OFFSET);
+        odo.append((char)2);
+        odo.append((uchar)(aOffset >> 8));
+        odo.append((uchar)aOffset);
+        sw = apdu(ISO_INS_READ_BINARY_ODO, 0, 0, odo, aLe, &aData);
+
+        // Unwrap the discretionary data object
+        const uchar* p = (const uchar*)aData.constData();
+        const int n = aData.size();
+        int head = 0;
+
+        if (n >= 2 && p[0] == ISO_TAG_DISCRETIONARY) {
+            head = (p[1] < 0x80) ? 2 : (p[1] == 0x81) ? 3 :
+                (p[1] == 0x82) ? 4 : 0;
+        }
+        if (head && n >= head) {
+            aData.remove(0, head);
+        } else {
+            iError = "Invalid READ BINARY (B1) response";
+            return false;
+        }
+    }
+    return sw == SW_OK || sw == SW_END_OF_FILE;
+}
+
+bool
+MockNfcd::Reader::readNdef(
+    uint aLe,
+    QByteArray& aNdef)
+{
+    // nfcd starts the app and handles SELECT by AID on its own
+    bool ok = hostCall("Start") && hostCall((iApp.iFlags &
+        APP_FLAG_IMPLICIT_SELECTION) ? "ImplicitSelect" : "Select");
+    QByteArray cc;
+
+    // NDEF detection procedure
+    ok = ok && selectFile(QByteArray((const char*)cc_fid, sizeof(cc_fid))) &&
+        readBinary(0, CC_SIZE, cc);
+    if (ok && cc.size() < CC_SIZE) {
+        iError = "Invalid CC";
+        ok = false;
+    }
+
+    // NDEF read procedure
+    if (ok) {
+        const uchar* p = (const uchar*)cc.constData();
+        const uint mle = ((uint)p[CC_MLE_OFFSET] << 8) | p[CC_MLE_OFFSET + 1];
+        const uint chunk = aLe ? qMin(aLe, mle) : mle;
+        QByteArray nlen;
+
+        ok = selectFile(cc.mid(CC_NDEF_FID_OFFSET, 2)) &&
+            readBinary(0, 2, nlen) && nlen.size() == 2;
+        if (ok) {
+            const uint total = 2 + (((uint)(uchar)nlen.at(0) << 8) |
+                (uchar)nlen.at(1));
+            uint off = 2;
+
+            aNdef.clear();
+            aNdef.reserve(total - 2);
+            while (ok && off < total) {
+                QByteArray data;
+
+                ok = readBinary(off, qMin(chunk, total - off), data);
+                if (ok && data.isEmpty()) {
+                    iError = "Nothing has been read";
+                    ok = false;
+                }
+                aNdef.append(data);
+                off += data.size();
+            }
+        }
+    }
+
+    // The reader is always taken away
+    const bool stopped = hostCall("Stop");
+    return ok && stopped;
+}
+
+// ==========================================================================
+// MockNfcd
+// ==========================================================================
+
+MockNfcd::MockNfcd(
+    QDBusConnection aBus,
+    QObject* aParent) :
+    QObject(aParent),
+    iBus(aBus),
+    iRoot(new QObject(this)),
+    iAdapter(new QObject(this)),
+    iHost(new QObject(this)),
+    iPeer(new QObject(this)),
+    iControl(new QObject(this)),
+    iAdapterAdaptor(new AdapterAdaptor(this, iAdapter)),
+    iLastId(0),
+    iDropped(0),
+    iReplyDelay(0),
+    iSnepFd(-1),
+    iSnepNotifier(Q_NULLPTR),
+    iSnepFragments(0),
+    iSnepConnections(0),
+    iSnepContinues(0)
+{
+    // Both nfcd services share the root object
+    new DaemonAdaptor(this, iRoot);
+    new SettingsAdaptor(iRoot);
+    new HostAdaptor(iHost);
+    new PeerAdaptor(this, iPeer);
+    new ControlAdaptor(this, iControl);
+}
+
+MockNfcd::~MockNfcd()
+{
+    if (iSnepFd >= 0) {
+        close(iSnepFd);
+    }
+}
+
+bool
+MockNfcd::start()
+{
+    // Client registrations go away together with the client
+    iBus.connect("org.freedesktop.DBus", "/org/freedesktop/DBus",
+        "org.freedesktop.DBus", "NameOwnerChanged", this,
+        SLOT(onNameOwnerChanged(QString,QString,QString)));
+
+    return iBus.registerObject("/", iRoot, QDBusConnection::ExportAdaptors) &&
+        iBus.registerObject(ADAPTER_PATH, iAdapter,
+            QDBusConnection::ExportAdaptors) &&
+        iBus.registerObject(HOST_PATH, iHost,
+            QDBusConnection::ExportAdaptors) &&
+        iBus.registerObject(CONTROL_PATH, iControl,
+            QDBusConnection::ExportAdaptors) &&
+        iBus.registerService(SETTINGS_SERVICE) &&
+        iBus.registerService(DAEMON_SERVICE);
+}
+
+void
+MockNfcd::reply(
+    const QDBusMessage& aCall,
+    const QVariantList& aArgs)
+{
+    const QDBusMessage reply(aCall.createReply(aArgs));
+
+    aCall.setDelayedReply(true);
+    if (iReplyDelay) {
+        iDelayedReplies.enqueue(reply);
+        QTimer::singleShot(iReplyDelay, this, SLOT(onReplyTimer()));
+    } else {
+        iBus.send(reply);
+    }
+}
+
+void
+MockNfcd::error(
+    const QDBusMessage& aCall,
+    const QString& aName,
+    const QString& aMessage)
+{
+    aCall.setDelayedReply(true);
+    iBus.send(aCall.createErrorReply(aName, aMessage));
+}
+
+void
+MockNfcd::onReplyTimer()
+{
+    if (!iDelayedReplies.isEmpty()) {
+        iBus.send(iDelayedReplies.dequeue());
+    }
+}
+
+//static
+uint
+MockNfcd::dropRequests(
+    QMap<uint,QString>& aRequests,
+    const QString& aOwner)
+{
+    QMutableMapIterator<uint,QString> it(aRequests);
+    uint n = 0;
+
+    while (it.hasNext()) {
+        if (it.next().value() == aOwner) {
+            it.remove();
+            n++;
+        }
+    }
+    return n;
+}
+
+void
+MockNfcd::onNameOwnerChanged(
+    QString aName,
+    QString,
+    QString aNewOwner)
+{
+    if (aNewOwner.isEmpty() && aName.startsWith(':')) {
+        // Same as nfcd does, except that we keep the count
+        for (int i = iApps.count() - 1; i >= 0; i--) {
+            if (iApps.at(i).iOwner == aName) {
+                iApps.removeAt(i);
+                iDropped++;
+            }
+        }
+        iDropped += dropRequests(iModes, aName) +
+            dropRequests(iTechs, aName);
+    }
+}
+
+void
+MockNfcd::registerApp(
+    const QString& aPath,
+    const QByteArray& aAid,
+    uint aFlags,
+    const QDBusMessage& aMessage)
+{
+    App app;
+
+    app.iOwner = aMessage.service();
+    app.iPath = aPath;
+    app.iAid = aAid;
+    app.iFlags = aFlags;
+    iApps.append(app);
+    reply(aMessage);
+}
+
+void
+MockNfcd::unregisterApp(
+    const QString& aPath,
+    const QDBusMessage& aMessage)
+{
+    const QString owner(aMessage.service());
+
+    for (int i = 0; i < iApps.count(); i++) {
+        const App& app = iApps.at(i);
+
+        if (app.iOwner == owner && app.iPath == aPath) {
+            iApps.removeAt(i);
+            reply(aMessage);
+            return;
+        }
+    }
+    error(aMessage, ERROR_NOT_FOUND, "No such app: " + aPath);
+}
+
+void
+MockNfcd::request(
+    QMap<uint,QString>& aRequests,
+    const QDBusMessage& aMessage)
+{
+    while (!++iLastId);
+    aRequests.insert(iLastId, aMessage.service());
+    reply(aMessage, QVariantList() << iLastId);
+}
+
+void
+MockNfcd::release(
+    QMap<uint,QString>& aRequests,
+    uint aId,
+    const QDBusMessage& aMessage)
+{
+    if (!aRequests.contains(aId)) {
+        error(aMessage, ERROR_NOT_FOUND, QString("No such request: %1").
+            arg(aId));
+    } else if (aRequests.value(aId) != aMessage.service()) {
+        error(aMessage, ERROR_ACCESS_DENIED, "Not your request");
+    } else {
+        aRequests.remove(aId);
+        reply(aMessage);
+    }
+}
+
+void
+MockNfcd::registrations(
+    const QDBusMessage& aMessage)
+{
+    aMessage.setDelayedReply(true);
+    iBus.send(aMessage.createReply(QVariantList() <<
+        uint(iApps.count()) << uint(iModes.count()) <<
+        uint(iTechs.count()) << iDropped));
+}
+
+void
+MockNfcd::read(
+    uint aLe,
+    const QDBusMessage& aMessage)
+{
+    const QByteArray aid((const char*)ndef_aid, sizeof(ndef_aid));
+
+    for (int i = 0; i < iApps.count(); i++) {
+        if (iApps.at(i).iAid == aid) {
+            Reader reader(iBus, iApps.at(i));
+            QElapsedTimer timer;
+            QByteArray ndef;
+
+            timer.start();
+            if (reader.readNdef(aLe, ndef)) {
+                const uint us = timer.nsecsElapsed() / 1000;
+
+                aMessage.setDelayedReply(true);
+                iBus.send(aMessage.createReply(QVariantList() << ndef <<
+                    QVariant::fromValue(reader.iLatencies) << us));
+            } else {
+                error(aMessage, ERROR_FAILED, reader.iError);
+            }
+            return;
+        }
+    }
+    error(aMessage, ERROR_NOT_FOUND, "No NDEF app is registered");
+}
+
+QList<QDBusObjectPath>
+MockNfcd::peers() const
+{
+    QList<QDBusObjectPath> list;
+
+    if (iPush.type() == QDBusMessage::MethodCallMessage) {
+        list.append(QDBusObjectPath(PEER_PATH));
+    }
+    return list;
+}
+
+void
+MockNfcd::push(
+    const QByteArray& aResponses,
+    const QDBusMessage& aMessage)
+{
+    if (aResponses.isEmpty()) {
+        error(aMessage, ERROR_FAILED, "No responses");
+    } else if (!peers().isEmpty()) {
+        error(aMessage, ERROR_FAILED, "Push is already in progress");
+    } else if (!iBus.registerObject(PEER_PATH, iPeer,
+        QDBusConnection::ExportAdaptors)) {
+        error(aMessage, ERROR_FAILED, "Failed to register the peer");
+    } else {
+        // Reply when the peer leaves the field
+        aMessage.setDelayedReply(true);
+        iPush = aMessage;
+        iSnepResponses = aResponses;
+        iSnepNdef.clear();
+        iSnepConnections = 0;
+        iSnepContinues = 0;
+        Q_EMIT iAdapterAdaptor->PeersChanged(peers());
+    }
+}
+
+void
+MockNfcd::connectServiceName(
+    const QString& aServiceName,
+    const QDBusMessage& aMessage)
+{
+    int fds[2];
+
+    if (aServiceName != SNEP_SERVICE_NAME) {
+        error(aMessage, ERROR_NOT_FOUND, "No such service: " + aServiceName);
+    } else if (iSnepFd >= 0) {
+        error(aMessage, ERROR_FAILED, "Already connected");
+    } else if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) {
+        error(aMessage, ERROR_FAILED, strerror(errno));
+    } else {
+        // QDBusUnixFileDescriptor makes its own copy
+        const QDBusUnixFileDescriptor fd(fds[1]);
+
+        close(fds[1]);
+        iSnepFd = fds[0];
+        fcntl(iSnepFd, F_SETFL, fcntl(iSnepFd, F_GETFL) | O_NONBLOCK);
+        iSnepNotifier = new QSocketNotifier(iSnepFd,
+            QSocketNotifier::Read, this);
+        connect(iSnepNotifier, SIGNAL(activated(int)),
+            SLOT(onSnepReadyRead()));
+        iSnepRequest.clear();
+        iSnepFragments = 0;
+        iSnepConnections++;
+        reply(aMessage, QVariantList() << QVariant::fromValue(fd));
+    }
+}
+
+void
+MockNfcd::onSnepReadyRead()
+{
+    QByteArray buf(SNEP_MAX_PACKET_SIZE, 0);
+    const ssize_t n = ::read(iSnepFd, buf.data(), buf.size());
+
+    if (n > 0) {
+        iSnepFragments++;
+        iSnepRequest.append(buf.constData(), n);
+        if (iSnepFragments == 1 && n > SNEP_FIRST_FRAGMENT_SIZE) {
+            // Fail the whole thing
+            qWarning() << "First SNEP fragment is too large:" << n;
+            iSnepResponses.clear();
+            iSnepNdef.clear();
+            snepDisconnect();
+        } else if (iSnepRequest.size() >= SNEP_HEADER_SIZE) {
+            const uchar* hdr = (const uchar*)iSnepRequest.constData();
+            const uint len = ((uint)hdr[2] << 24) | ((uint)hdr[3] << 16) |
+                ((uint)hdr[4] << 8) | hdr[5];
+
+            if (uint(iSnepRequest.size()) >= SNEP_HEADER_SIZE + len) {
+                const uchar code = iSnepResponses.at(0);
+
+                iSnepResponses.remove(0, 1);
+                if (code == SNEP_RESPONSE_SUCCESS) {
+                    iSnepNdef = iSnepRequest.mid(SNEP_HEADER_SIZE, len);
+                }
+                iSnepRequest.clear();
+                if (code) {
+                    snepRespond(code);
+                } else {
+                    snepDisconnect();
+                }
+            } else if (iSnepFragments == 1) {
+                iSnepContinues++;
+                snepRespond(SNEP_RESPONSE_CONTINUE);
+            }
+        }
+    } else if (!n || (errno != EAGAIN && errno != EINTR)) {
+        // The client has hung up
+        snepDisconnect();
+    }
+}
+
+void
+MockNfcd::snepRespond(
+    uchar aCode)
+{
+    const uchar resp[SNEP_HEADER_SIZE] = { SNEP_VERSION, aCode, 0, 0, 0, 0 };
+
+    if (write(iSnepFd, resp, sizeof(resp)) != sizeof(resp)) {
+        qWarning() << "SNEP write error:" << strerror(errno);
+        snepDisconnect();
+    }
+}
+
+void
+MockNfcd::snepDisconnect()
+{
+    // This may be invoked by the notifier itself
+    if (iSnepNotifier) {
+        iSnepNotifier->setEnabled(false);
+        iSnepNotifier->deleteLater();
+        iSnepNotifier = Q_NULLPTR;
+    }
+    if (iSnepFd >= 0) {
+        close(iSnepFd);
+        iSnepFd = -1;
+    }
+
+    // The peer leaves the field after the last response
+    if (iSnepResponses.isEmpty() && !peers().isEmpty()) {
+        const QDBusMessage reply(iPush.createReply(QVariantList() <<
+            iSnepNdef << iSnepConnections << iSnepContinues));
+
+        iPush = QDBusMessage();
+        iBus.unregisterObject(PEER_PATH);
+        Q_EMIT iAdapterAdaptor->PeersChanged(peers());
+        iBus.send(reply);
+    }
+}
+
+#include "mocknfcd.moc"
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MOCK_NFCD_H
+#define MOCK_NFCD_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QString>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusObjectPath>
+
+class QSocketNotifier;
+
+// Stand-in for nfcd (org.sailfishos.nfc.daemon and .settings) on a
+// private bus. Keeps track of local host apps, mode and tech requests
+// and drives a scripted Type 4 reader through the registered app.
+//
+// It's controlled over org.sailfishos.nfc.Mock interface at /mock:
+//
+// <method name="SetReplyDelay">
+//   <arg name="ms" type="u" direction="in"/>
+// </method>
+// <method name="GetRegistrations">
+//   <arg name="apps" type="u" direction="out"/>
+//   <arg name="modes" type="u" direction="out"/>
+//   <arg name="techs" type="u" direction="out"/>
+//   <arg name="dropped" type="u" direction="out"/>
+// </method>
+// <method name="Read">
+//   <arg name="le" type="u" direction="in"/>
+//   <arg name="ndef" type="ay" direction="out"/>
+//   <arg name="latencies" type="au" direction="out"/>
+//   <arg name="total" type="u" direction="out"/>
+// </method>
+// <method name="Push">
+//   <arg name="responses" type="ay" direction="in"/>
+//   <arg name="ndef" type="ay" direction="out"/>
+//   <arg name="connections" type="u" direction="out"/>
+//   <arg name="continues" type="u" direction="out"/>
+// </method>
+//
+// Replies to RegisterLocalHostApp, RequestMode, RequestTechs and the
+// calls undoing them are delayed by SetReplyDelay milliseconds, while
+// the calls themselves take effect right away.
+// That's what a slow nfcd looks like to the client. Registrations
+// left behind by the clients leaving the bus are counted as dropped.
+//
+// Read taps the reader on the first app registered for the NDEF AID
+// and reads the whole message, Le bytes at a time (zero means MLe).
+// It returns the NDEF message and round trip times of each C-APDU
+// plus the total time in microseconds.
+//
+// Push brings a P2P peer into the field and plays SNEP server for
+// whoever connects to its urn:nfc:sn:snep service (the connection is
+// one end of a SOCK_SEQPACKET socketpair). Each connection gets the
+// next response code from the list once the PUT request is complete,
+// zero closes the socket instead of responding. A request which doesn't
+// fit into the first 128 byte fragment (the default LLCP MIU) gets a
+// Continue. Once all responses have been used up and the client has
+// disconnected, the peer leaves the field and Push returns the last
+// message received with Success, the number of connections made and
+// Continue responses sent.
+class MockNfcd :
+    public QObject
+{
+    Q_OBJECT
+    class DaemonAdaptor;
+    class SettingsAdaptor;
+    class AdapterAdaptor;
+    class HostAdaptor;
+    class PeerAdaptor;
+    class ControlAdaptor;
+    class Reader;
+
+public:
+    static const QString DAEMON_SERVICE;
+    static const QString SETTINGS_SERVICE;
+    static const QString CONTROL_PATH;
+    static const QString CONTROL_INTERFACE;
+
+    MockNfcd(QDBusConnection, QObject* aParent = Q_NULLPTR);
+    ~MockNfcd();
+
+    bool start();
+
+private Q_SLOTS:
+    void onNameOwnerChanged(QString, QString, QString);
+    void onReplyTimer();
+    void onSnepReadyRead();
+
+private:
+    static uint dropRequests(QMap<uint,QString>&, const QString&);
+    void reply(const QDBusMessage&, const QVariantList& aArgs = QVariantList());
+    void error(const QDBusMessage&, const QString&, const QString&);
+    void registerApp(const QString&, const QByteArray&, uint,
+        const QDBusMessage&);
+    void unregisterApp(const QString&, const QDBusMessage&);
+    void request(QMap<uint,QString>&, const QDBusMessage&);
+    void release(QMap<uint,QString>&, uint, const QDBusMessage&);
+    void registrations(const QDBusMessage&);
+    void read(uint, const QDBusMessage&);
+    QList<QDBusObjectPath> peers() const;
+    void push(const QByteArray&, const QDBusMessage&);
+    void connectServiceName(const QString&, const QDBusMessage&);
+    void snepRespond(uchar);
+    void snepDisconnect();
+
+private:
+    class App {
+    public:
+        QString iOwner;
+        QString iPath;
+        QByteArray iAid;
+        uint iFlags;
+    };
+
+    QDBusConnection iBus;
+    QObject* iRoot;
+    QObject* iAdapter;
+    QObject* iHost;
+    QObject* iPeer;
+    QObject* iControl;
+    AdapterAdaptor* iAdapterAdaptor;
+    QList<App> iApps;
+    QMap<uint,QString> iModes;  // Id => owner
+    QMap<uint,QString> iTechs;
+    uint iLastId;
+    uint iDropped;
+    uint iReplyDelay;
+    QQueue<QDBusMessage> iDelayedReplies;
+    QDBusMessage iPush;         // Pending Push call
+    QByteArray iSnepResponses;  // For the next connections
+    QByteArray iSnepRequest;    // Received so far
+    QByteArray iSnepNdef;       // Last one pushed successfully
+    int iSnepFd;
+    QSocketNotifier* iSnepNotifier;
+    uint iSnepFragments;
+    uint iSnepConnections;
+    uint iSnepContinues;
+};
+
+#endif // MOCK_NFCD_H
@@ -0,0 +1,16 @@
+TEMPLATE = app
+TARGET = mocknfcd
+CONFIG += console
+CONFIG -= app_bundle
+QT = core dbus
+
+QMAKE_CXXFLAGS += -Wno-unused-parameter
+
+DEFINES += QT_NO_KEYWORDS
+
+HEADERS += \
+    mocknfcd.h
+
+SOURCES += \
+    main.cpp \
+    mocknfcd.cpp
@@ -0,0 +1,16 @@
+TARGET = test_ndeftag
+
+include(../common/common.pri)
+
+# The APDU engine is compiled in, the same way apdureplay does it
+INCLUDEPATH += $${LIB_DIR}/src
+DEFINES += NFCSHARE_STATIC
+
+HEADERS += \
+    $${LIB_DIR}/include/ndeftag.h \
+    $${LIB_DIR}/src/nfcsharelog.h
+
+SOURCES += \
+    test_ndeftag.cpp \
+    $${LIB_DIR}/src/ndeftag.cpp \
+    $${LIB_DIR}/src/nfcsharelog.cpp
@@ -0,0 +1,1065 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// NdefTag APDU engine, without nfcd or D-Bus. Checks how SELECT,
+// READ BINARY and UPDATE BINARY are handled and what's in the CC and
+// NDEF files, and measures how long it takes to process them.
+
+#include "ndeftag.h"
+
+#include <QtTest/QtTest>
+
+#define INS_SELECT (0xa4)
+#define INS_READ_BINARY (0xb0)
+#define INS_READ_BINARY_ODO (0xb1)
+#define INS_UPDATE_BINARY (0xd6)
+
+#define SW_OK (0x9000)
+#define SW_READ_ONLY (0x6982)
+#define SW_END_OF_FILE (0x6282)
+#define SW_WRONG_LENGTH (0x6700)
+#define SW_NO_CURRENT_EF (0x6986)
+#define SW_WRONG_DATA (0x6a80)
+#define SW_FUNC_NOT_SUPPORTED (0x6a81)
+#define SW_NOT_FOUND (0x6a82)
+#define SW_WRONG_P1P2 (0x6a86)
+#define SW_WRONG_OFFSET (0x6b00)
+#define SW_INS_NOT_SUPPORTED (0x6d00)
+#define SW_CLA_NOT_SUPPORTED (0x6e00)
+
+#define CC_SIZE (15)
+#define CC_FID (0xe103)
+#define NDEF_FID (0xe104)
+#define MF_FID (0x3f00)
+
+class TestNdefTag :
+    public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void basic();
+    void tooMuchData();
+    void unsupported();
+    void select_data();
+    void select();
+    void selectName();
+    void selectLegacy();
+    void cc_data();
+    void cc();
+    void ndef();
+    void read_data();
+    void read();
+    void readOdo_data();
+    void readOdo();
+    void progress();
+    void reset();
+    void update_data();
+    void update();
+    void receive();
+    void receiveSingleWrite();
+    void receiveUnconfirmed();
+    void receiveZeroNlen();
+    void receiveNlenFirst();
+    void receiveInvalidNlen();
+    void receiveLarge();
+    void readWritten();
+    void benchSelect();
+    void benchReadBinary_data();
+    void benchReadBinary();
+    void benchSequence_data();
+    void benchSequence();
+
+private:
+    static QByteArray payload(int);
+    static QByteArray word(uint);
+    static QByteArray unwrap(const QByteArray&);
+    static uint sw(const NdefTag::Response&);
+    static NdefTag::Response process(NdefTag&, uchar, uchar, uchar,
+        const QByteArray& aData = QByteArray(), uint aLe = 0);
+    static NdefTag::Response selectFile(NdefTag&, uint);
+    static NdefTag::Response read(NdefTag&, uint, uint);
+    static NdefTag::Response write(NdefTag&, uint, const QByteArray&);
+    static QByteArray readChunk(NdefTag&, uint, uint, uint*);
+    static QByteArray readAll(NdefTag&, uint);
+};
+
+//static
+QByteArray
+TestNdefTag::payload(
+    int aSize)
+{
+    // NdefTag doesn't look inside, any bytes would do
+    QByteArray data(aSize, 0);
+
+    for (int i = 0; i < aSize; i++) {
+        data[i] = (char)(i * 31 + 7);
+    }
+    return data;
+}
+
+//static
+QByteArray
+TestNdefTag::word(
+    uint aValue)
+{
+    // Big-endian 16 bits, e.g. a file id or NLEN
+    QByteArray data;
+
+    data.append((uchar)(aValue >> 8));
+    data.append((uchar)aValue);
+    return data;
+}
+
+//static
+QByteArray
+TestNdefTag::unwrap(
+    const QByteArray& aData)
+{
+    // Strips 53 L off the B1 response
+    const uchar* ptr = (const uchar*)aData.constData();
+    const int head = (aData.size() < 2) ? 0 : (ptr[1] < 0x80) ? 2 :
+        (2 + (ptr[1] & 0x7f));
+
+    return (head && ptr[0] == 0x53) ? aData.mid(head) : QByteArray();
+}
+
+//static
+uint
+TestNdefTag::sw(
+    const NdefTag::Response& aResponse)
+{
+    return ((uint)aResponse.sw1() << 8) | aResponse.sw2();
+}
+
+//static
+NdefTag::Response
+TestNdefTag::process(
+    NdefTag& aTag,
+    uchar aIns,
+    uchar aP1,
+    uchar aP2,
+    const QByteArray& aData,
+    uint aLe)
+{
+    return aTag.process(0x00, aIns, aP1, aP2, aData, aLe);
+}
+
+//static
+NdefTag::Response
+TestNdefTag::selectFile(
+    NdefTag& aTag,
+    uint aFid)
+{
+    // Type 4 tag v2 style, no response data
+    return process(aTag, INS_SELECT, 0x00, 0x0c, word(aFid));
+}
+
+//static
+NdefTag::Response
+TestNdefTag::read(
+    NdefTag& aTag,
+    uint aOffset,
+    uint aLe)
+{
+    return process(aTag, INS_READ_BINARY, (uchar)(aOffset >> 8),
+        (uchar)aOffset, QByteArray(), aLe);
+}
+
+//static
+NdefTag::Response
+TestNdefTag::write(
+    NdefTag& aTag,
+    uint aOffset,
+    const QByteArray& aData)
+{
+    return process(aTag, INS_UPDATE_BINARY, (uchar)(aOffset >> 8),
+        (uchar)aOffset, aData);
+}
+
+//static
+QByteArray
+TestNdefTag::readChunk(
+    NdefTag& aTag,
+    uint aOffset,
+    uint aLe,
+    uint* aId)
+{
+    // Offsets beyond 32767 don't fit into P1-P2 of B0
+    const bool odo = aOffset > 0x7fff;
+    const NdefTag::Response r(odo ?
+        process(aTag, INS_READ_BINARY_ODO, 0x00, 0x00,
+            QByteArray::fromHex("5402") + word(aOffset), aLe) :
+        read(aTag, aOffset, aLe));
+    const uint status = sw(r);
+
+    *aId = r.id();
+    return (status == SW_OK || status == SW_END_OF_FILE) ?
+        (odo ? unwrap(r.data()) : r.data()) : QByteArray();
+}
+
+//static
+QByteArray
+TestNdefTag::readAll(
+    NdefTag& aTag,
+    uint aLe)
+{
+    // What a reader does: select the application, read the CC, then
+    // NLEN and finally the message in chunks no larger than MLe
+    QByteArray ndef;
+
+    if (sw(process(aTag, INS_SELECT, 0x04, 0x00, NdefTag::aid())) == SW_OK &&
+        sw(selectFile(aTag, CC_FID)) == SW_OK) {
+        const NdefTag::Response cc(read(aTag, 0, CC_SIZE));
+        const uchar* ccData = (const uchar*)cc.data().constData();
+
+        if (sw(cc) == SW_OK && cc.data().size() == CC_SIZE) {
+            const uint mle = ((uint)ccData[3] << 8) | ccData[4];
+            const uint ndefFid = ((uint)ccData[9] << 8) | ccData[10];
+            const uint chunk = aLe ? qMin(aLe, mle) : mle;
+
+            aTag.responseStatus(cc.id(), true);
+            if (sw(selectFile(aTag, ndefFid)) == SW_OK) {
+                const NdefTag::Response nlen(read(aTag, 0, 2));
+                const uchar* nlenData = (const uchar*)nlen.data().constData();
+
+                if (sw(nlen) == SW_OK && nlen.data().size() == 2) {
+                    const uint total = 2 + (((uint)nlenData[0] << 8) |
+                        nlenData[1]);
+                    uint off = 2;
+
+                    aTag.responseStatus(nlen.id(), true);
+                    while (off < total) {
+                        uint id;
+                        const QByteArray data(readChunk(aTag, off,
+                            qMin(chunk, total - off), &id));
+
+                        if (data.isEmpty()) {
+                            break;
+                        }
+                        aTag.responseStatus(id, true);
+                        ndef.append(data);
+                        off += data.size();
+                    }
+                }
+            }
+        }
+    }
+    aTag.stop();
+    return ndef;
+}
+
+// ==========================================================================
+// Tests
+// ==========================================================================
+
+void
+TestNdefTag::basic()
+{
+    const QByteArray ndef(payload(16));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    QCOMPARE(NdefTag::aid(), QByteArray::fromHex("d2760000850101"));
+    QCOMPARE(NdefTag::legacyAid(), QByteArray::fromHex("d2760000850100"));
+    QVERIFY(NdefTag::maxMessageSize() > 0);
+    QVERIFY(!tag.isTooMuchData());
+    QVERIFY(!tag.isDone());
+    QCOMPARE(tag.size(), uint(ndef.size() + 2));
+    QCOMPARE(tag.bytesRead(), 0u);
+    QVERIFY(tag.received().isEmpty());
+}
+
+void
+TestNdefTag::tooMuchData()
+{
+    const QByteArray ndef(payload(NdefTag::maxMessageSize() + 1));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    QVERIFY(tag.isTooMuchData());
+    QCOMPARE(tag.size(), 0u);
+}
+
+void
+TestNdefTag::unsupported()
+{
+    const QByteArray ndef(payload(16));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    QCOMPARE(sw(tag.process(0x80, INS_SELECT, 0x00, 0x0c, word(CC_FID), 0)),
+        uint(SW_CLA_NOT_SUPPORTED));
+    QCOMPARE(sw(process(tag, 0xca, 0x00, 0x00)), uint(SW_INS_NOT_SUPPORTED));
+
+    // Read-only tag doesn't even know UPDATE BINARY
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    QCOMPARE(sw(process(tag, INS_UPDATE_BINARY, 0x00, 0x00,
+        QByteArray(2, 0))), uint(SW_INS_NOT_SUPPORTED));
+}
+
+void
+TestNdefTag::select_data()
+{
+    // Response data for FCI/FCP: size (80), EF type (82), fid (83)
+    const QByteArray fcp("\x80\x02\x00\x0f\x82\x01\x01\x83\x02\xe1\x03", 11);
+
+    QTest::addColumn<uint>("p1");
+    QTest::addColumn<uint>("p2");
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<uint>("sw");
+    QTest::addColumn<QByteArray>("resp");
+
+    // Success
+    QTest::newRow("v2") << 0x00u << 0x0cu << word(CC_FID) <<
+        uint(SW_OK) << QByteArray();
+    QTest::newRow("ndef") << 0x00u << 0x0cu << word(NDEF_FID) <<
+        uint(SW_OK) << QByteArray();
+    QTest::newRow("last") << 0x00u << 0x0du << word(CC_FID) <<
+        uint(SW_OK) << QByteArray();
+    QTest::newRow("fci") << 0x00u << 0x00u << word(CC_FID) <<
+        uint(SW_OK) << QByteArray("\x6f\x0b", 2) + fcp;
+    QTest::newRow("fcp") << 0x00u << 0x04u << word(CC_FID) <<
+        uint(SW_OK) << QByteArray("\x62\x0b", 2) + fcp;
+    QTest::newRow("fmd") << 0x00u << 0x08u << word(CC_FID) <<
+        uint(SW_OK) << QByteArray("\x64\x00", 2);
+    QTest::newRow("mf") << 0x00u << 0x0cu << word(MF_FID) <<
+        uint(SW_OK) << QByteArray();
+    QTest::newRow("child") << 0x02u << 0x0cu << word(CC_FID) <<
+        uint(SW_OK) << QByteArray();
+    QTest::newRow("path/mf") << 0x08u << 0x0cu << word(CC_FID) <<
+        uint(SW_OK) << QByteArray();
+    QTest::newRow("path/mf/mf") << 0x08u << 0x0cu <<
+        word(MF_FID) + word(CC_FID) << uint(SW_OK) << QByteArray();
+    QTest::newRow("path/df") << 0x09u << 0x0cu << word(CC_FID) <<
+        uint(SW_OK) << QByteArray();
+    QTest::newRow("name") << 0x04u << 0x00u << NdefTag::aid() <<
+        uint(SW_OK) << QByteArray();
+
+    // Failures
+    QTest::newRow("unknown") << 0x00u << 0x0cu << word(0xe105) <<
+        uint(SW_NOT_FOUND) << QByteArray();
+    QTest::newRow("short") << 0x00u << 0x0cu << QByteArray(1, (char)0xe1) <<
+        uint(SW_WRONG_LENGTH) << QByteArray();
+    QTest::newRow("long") << 0x00u << 0x0cu << word(CC_FID) + word(0) <<
+        uint(SW_WRONG_LENGTH) << QByteArray();
+    QTest::newRow("empty") << 0x00u << 0x0cu << QByteArray() <<
+        uint(SW_WRONG_LENGTH) << QByteArray();
+    QTest::newRow("next") << 0x00u << 0x0eu << word(CC_FID) <<
+        uint(SW_NOT_FOUND) << QByteArray();
+    QTest::newRow("p2") << 0x00u << 0x1cu << word(CC_FID) <<
+        uint(SW_WRONG_P1P2) << QByteArray();
+    QTest::newRow("p1") << 0x01u << 0x0cu << word(CC_FID) <<
+        uint(SW_WRONG_P1P2) << QByteArray();
+    QTest::newRow("path/odd") << 0x08u << 0x0cu << QByteArray(3, (char)0xe1) <<
+        uint(SW_WRONG_LENGTH) << QByteArray();
+    QTest::newRow("path/deep") << 0x09u << 0x0cu <<
+        word(MF_FID) + word(CC_FID) << uint(SW_NOT_FOUND) << QByteArray();
+    QTest::newRow("name/unknown") << 0x04u << 0x00u <<
+        QByteArray::fromHex("a000000003") << uint(SW_NOT_FOUND) <<
+        QByteArray();
+}
+
+void
+TestNdefTag::select()
+{
+    QFETCH(uint, p1);
+    QFETCH(uint, p2);
+    QFETCH(QByteArray, data);
+    QFETCH(uint, sw);
+    QFETCH(QByteArray, resp);
+
+    // The CC is 15 bytes long, which is what FCI/FCP report as its size
+    const QByteArray ndef(payload(16));
+    NdefTag tag(ndef.constData(), ndef.size());
+    const NdefTag::Response r(process(tag, INS_SELECT, p1, p2, data));
+
+    QCOMPARE(TestNdefTag::sw(r), sw);
+    QCOMPARE(r.data(), resp);
+    QCOMPARE(r.isOk(), sw == SW_OK);
+}
+
+void
+TestNdefTag::selectName()
+{
+    const QByteArray ndef(payload(16));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    // Selecting the application forgets the current EF
+    QCOMPARE(sw(selectFile(tag, CC_FID)), uint(SW_OK));
+    QCOMPARE(sw(read(tag, 0, 2)), uint(SW_OK));
+    QCOMPARE(sw(process(tag, INS_SELECT, 0x04, 0x00, NdefTag::aid())),
+        uint(SW_OK));
+    QCOMPARE(sw(read(tag, 0, 2)), uint(SW_NO_CURRENT_EF));
+
+    // And so does selecting the MF
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    QCOMPARE(sw(selectFile(tag, MF_FID)), uint(SW_OK));
+    QCOMPARE(sw(read(tag, 0, 2)), uint(SW_NO_CURRENT_EF));
+}
+
+void
+TestNdefTag::selectLegacy()
+{
+    const QByteArray ndef(payload(16));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    // The v1 application isn't there unless it's been enabled
+    QCOMPARE(sw(process(tag, INS_SELECT, 0x04, 0x00, NdefTag::legacyAid())),
+        uint(SW_NOT_FOUND));
+    tag.setLegacyAidEnabled(true);
+    QCOMPARE(sw(process(tag, INS_SELECT, 0x04, 0x00, NdefTag::legacyAid())),
+        uint(SW_OK));
+
+    // And stays there when the message changes
+    tag.replace(ndef.constData(), 8);
+    QCOMPARE(sw(process(tag, INS_SELECT, 0x04, 0x00, NdefTag::legacyAid())),
+        uint(SW_OK));
+    tag.setLegacyAidEnabled(false);
+    QCOMPARE(sw(process(tag, INS_SELECT, 0x04, 0x00, NdefTag::legacyAid())),
+        uint(SW_NOT_FOUND));
+    QCOMPARE(sw(process(tag, INS_SELECT, 0x04, 0x00, NdefTag::aid())),
+        uint(SW_OK));
+}
+
+void
+TestNdefTag::cc_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<uint>("maxLe");
+    QTest::addColumn<uint>("receiveSize");
+    QTest::addColumn<QByteArray>("cc");
+
+    QTest::newRow("default") << 16 << 0u << 0u <<
+        QByteArray::fromHex("000f20ffffffff0406e1040012" "00ff");
+    QTest::newRow("maxLe") << 16 << 0x100u << 0u <<
+        QByteArray::fromHex("000f200100ffff0406e1040012" "00ff");
+    QTest::newRow("minLe") << 16 << 1u << 0u <<
+        QByteArray::fromHex("000f20000fffff0406e1040012" "00ff");
+    QTest::newRow("large") << 0x1234 << 0u << 0u <<
+        QByteArray::fromHex("000f20ffffffff0406e1041236" "00ff");
+    QTest::newRow("writable") << 16 << 0u << 0x100u <<
+        QByteArray::fromHex("000f20ffffffff0406e1040102" "0000");
+    QTest::newRow("writable/large") << 0x1234 << 0u << 0x100u <<
+        QByteArray::fromHex("000f20ffffffff0406e1041236" "0000");
+    QTest::newRow("writable/max") << 16 << 0u << 0x10000u <<
+        QByteArray::fromHex("000f20ffffffff0406e1047fff" "0000");
+}
+
+void
+TestNdefTag::cc()
+{
+    QFETCH(int, size);
+    QFETCH(uint, maxLe);
+    QFETCH(uint, receiveSize);
+    QFETCH(QByteArray, cc);
+
+    const QByteArray ndef(payload(size));
+    NdefTag tag(ndef.constData(), ndef.size(), maxLe, receiveSize);
+    NdefTag::Response r;
+
+    QCOMPARE(sw(selectFile(tag, CC_FID)), uint(SW_OK));
+    r = read(tag, 0, CC_SIZE);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(r.data(), cc);
+
+    // Reading the CC doesn't count as reading the tag
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.bytesRead(), 0u);
+}
+
+void
+TestNdefTag::ndef()
+{
+    const QByteArray ndef(payload(300));
+    NdefTag tag(ndef.constData(), ndef.size());
+    NdefTag::Response r;
+
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+
+    // NLEN (big-endian) followed by the message
+    r = read(tag, 0, 2);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(r.data(), QByteArray::fromHex("012c"));
+    r = read(tag, 2, ndef.size());
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(r.data(), ndef);
+    QCOMPARE(readAll(tag, 0), ndef);
+}
+
+void
+TestNdefTag::read_data()
+{
+    const int fileSize = 0x200 + 2;
+
+    QTest::addColumn<uint>("maxLe");
+    QTest::addColumn<uint>("offset");
+    QTest::addColumn<uint>("le");
+    QTest::addColumn<uint>("sw");
+    QTest::addColumn<int>("len");
+
+    QTest::newRow("short") << 0u << 0u << 0x10u << uint(SW_OK) << 0x10;
+    QTest::newRow("le00") << 0u << 0u << 0u << uint(SW_OK) << 0x100;
+    QTest::newRow("le256") << 0u << 0u << 0x100u << uint(SW_OK) << 0x100;
+    QTest::newRow("extended") << 0u << 0u << 0x10000u << uint(SW_END_OF_FILE) <<
+        fileSize;
+    QTest::newRow("exact") << 0u << 0x100u << uint(fileSize - 0x100) <<
+        uint(SW_OK) << fileSize - 0x100;
+    QTest::newRow("tail") << 0u << 0x1f0u << 0x20u << uint(SW_END_OF_FILE) <<
+        fileSize - 0x1f0;
+    QTest::newRow("tail/le00") << 0u << 0x1f0u << 0u << uint(SW_END_OF_FILE) <<
+        fileSize - 0x1f0;
+    QTest::newRow("last") << 0u << uint(fileSize - 1) << 1u << uint(SW_OK) << 1;
+    QTest::newRow("end") << 0u << uint(fileSize) << 1u <<
+        uint(SW_WRONG_OFFSET) << 0;
+    QTest::newRow("past") << 0u << 0x7fffu << 1u << uint(SW_WRONG_OFFSET) << 0;
+    QTest::newRow("mle") << 0x20u << 0u << 0x100u << uint(SW_OK) << 0x20;
+    QTest::newRow("mle/le00") << 0x20u << 0u << 0u << uint(SW_OK) << 0x20;
+    QTest::newRow("mle/tail") << 0x20u << 0x1f0u << 0x100u <<
+        uint(SW_END_OF_FILE) << fileSize - 0x1f0;
+}
+
+void
+TestNdefTag::read()
+{
+    QFETCH(uint, maxLe);
+    QFETCH(uint, offset);
+    QFETCH(uint, le);
+    QFETCH(uint, sw);
+    QFETCH(int, len);
+
+    const QByteArray ndef(payload(0x200));
+    const QByteArray file(word(ndef.size()) + ndef);
+    NdefTag tag(ndef.constData(), ndef.size(), maxLe);
+    const NdefTag::Response r(selectFile(tag, NDEF_FID).isOk() ?
+        read(tag, offset, le) : NdefTag::Response());
+
+    QCOMPARE(TestNdefTag::sw(r), sw);
+    QCOMPARE(r.data(), file.mid(offset, len));
+}
+
+void
+TestNdefTag::readOdo_data()
+{
+    QTest::addColumn<uint>("p1p2");
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<uint>("le");
+    QTest::addColumn<uint>("sw");
+    QTest::addColumn<QByteArray>("resp");
+
+    // Offsets are in the NDEF file which is 0x0202 bytes long and
+    // starts with 0200 (NLEN) followed by the payload
+    const QByteArray ndef(payload(0x200));
+    const QByteArray file(word(ndef.size()) + ndef);
+
+    QTest::newRow("current") << 0u << QByteArray::fromHex("540100") << 0x10u <<
+        uint(SW_OK) << QByteArray::fromHex("530e") + file.left(14);
+    QTest::newRow("fid") << uint(NDEF_FID) << QByteArray::fromHex("54020010") <<
+        0x10u << uint(SW_OK) << QByteArray::fromHex("530e") + file.mid(16, 14);
+    QTest::newRow("3bytes") << 0u << QByteArray::fromHex("5403000002") <<
+        0x10u << uint(SW_OK) << QByteArray::fromHex("530e") + file.mid(2, 14);
+    QTest::newRow("long") << 0u << QByteArray::fromHex("540100") << 0x100u <<
+        uint(SW_OK) << QByteArray::fromHex("5381fd") + file.left(0xfd);
+    QTest::newRow("tail") << 0u << QByteArray::fromHex("540201f0") << 0x20u <<
+        uint(SW_END_OF_FILE) << QByteArray::fromHex("5312") + file.mid(0x1f0);
+    QTest::newRow("end") << 0u << QByteArray::fromHex("54020202") << 0x10u <<
+        uint(SW_WRONG_OFFSET) << QByteArray();
+    QTest::newRow("sfi") << 0x0001u << QByteArray::fromHex("540100") <<
+        0x10u << uint(SW_FUNC_NOT_SUPPORTED) << QByteArray();
+    QTest::newRow("unknown") << 0xe105u << QByteArray::fromHex("540100") <<
+        0x10u << uint(SW_NOT_FOUND) << QByteArray();
+    QTest::newRow("tag") << 0u << QByteArray::fromHex("550100") << 0x10u <<
+        uint(SW_WRONG_DATA) << QByteArray();
+    QTest::newRow("empty") << 0u << QByteArray::fromHex("5400") << 0x10u <<
+        uint(SW_WRONG_DATA) << QByteArray();
+    QTest::newRow("4bytes") << 0u << QByteArray::fromHex("540400000000") <<
+        0x10u << uint(SW_WRONG_DATA) << QByteArray();
+    QTest::newRow("truncated") << 0u << QByteArray::fromHex("540200") <<
+        0x10u << uint(SW_WRONG_DATA) << QByteArray();
+    QTest::newRow("tiny") << 0u << QByteArray::fromHex("540100") << 2u <<
+        uint(SW_WRONG_LENGTH) << QByteArray();
+}
+
+void
+TestNdefTag::readOdo()
+{
+    QFETCH(uint, p1p2);
+    QFETCH(QByteArray, data);
+    QFETCH(uint, le);
+    QFETCH(uint, sw);
+    QFETCH(QByteArray, resp);
+
+    const QByteArray ndef(payload(0x200));
+    NdefTag tag(ndef.constData(), ndef.size());
+    NdefTag::Response r;
+
+    // Without P1-P2 it's the current EF and there's none yet
+    r = process(tag, INS_READ_BINARY_ODO, 0, 0, QByteArray::fromHex("540100"),
+        0x10);
+    QCOMPARE(TestNdefTag::sw(r), uint(SW_NO_CURRENT_EF));
+
+    QCOMPARE(TestNdefTag::sw(selectFile(tag, p1p2 ? CC_FID : NDEF_FID)),
+        uint(SW_OK));
+    r = process(tag, INS_READ_BINARY_ODO, (uchar)(p1p2 >> 8), (uchar)p1p2,
+        data, le);
+    QCOMPARE(TestNdefTag::sw(r), sw);
+    QCOMPARE(r.data(), resp);
+}
+
+void
+TestNdefTag::progress()
+{
+    const QByteArray ndef(payload(100));
+    NdefTag tag(ndef.constData(), ndef.size());
+    NdefTag::Response r;
+
+    QCOMPARE(tag.start(), int(NdefTag::EventNone));
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+
+    // Unconfirmed and failed reads don't count
+    r = read(tag, 0, 50);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), false), int(NdefTag::EventNone));
+    QCOMPARE(tag.bytesRead(), 0u);
+    QCOMPARE(tag.responseStatus(r.id() + 1, true), int(NdefTag::EventNone));
+    QCOMPARE(tag.bytesRead(), 0u);
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventProgress));
+    QCOMPARE(tag.bytesRead(), 50u);
+
+    // Reading the same bytes again isn't a progress
+    r = read(tag, 0, 50);
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.bytesRead(), 50u);
+
+    r = read(tag, 50, 0);
+    QCOMPARE(sw(r), uint(SW_END_OF_FILE));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventProgress));
+    QCOMPARE(tag.bytesRead(), tag.size());
+    QVERIFY(!tag.isDone());
+
+    // Done once the reader is gone
+    QCOMPARE(tag.stop(), int(NdefTag::EventDone));
+    QVERIFY(tag.isDone());
+    QCOMPARE(tag.start(), int(NdefTag::EventNone));
+    QCOMPARE(tag.bytesRead(), tag.size());
+}
+
+void
+TestNdefTag::reset()
+{
+    const QByteArray ndef(payload(100));
+    NdefTag tag(ndef.constData(), ndef.size());
+    NdefTag::Response r;
+
+    // Nothing to reset yet
+    QCOMPARE(tag.stop(), int(NdefTag::EventNone));
+
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = read(tag, 0, 50);
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventProgress));
+
+    // Incomplete read gets discarded when the reader goes away
+    QCOMPARE(tag.stop(), int(NdefTag::EventReset));
+    QCOMPARE(tag.bytesRead(), 0u);
+    QVERIFY(!tag.isDone());
+
+    // Or comes back
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = read(tag, 0, 50);
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventProgress));
+    QCOMPARE(tag.start(), int(NdefTag::EventReset));
+    QCOMPARE(tag.bytesRead(), 0u);
+
+    // And replace() starts from scratch
+    QCOMPARE(readAll(tag, 0), ndef);
+    QVERIFY(tag.isDone());
+    tag.replace(ndef.constData(), 10);
+    QVERIFY(!tag.isDone());
+    QCOMPARE(tag.size(), 12u);
+    QCOMPARE(sw(read(tag, 0, 2)), uint(SW_NO_CURRENT_EF));
+    QCOMPARE(readAll(tag, 0), ndef.left(10));
+}
+
+void
+TestNdefTag::update_data()
+{
+    // Receive buffer is NLEN + 32 bytes, 0x0022 in total
+    QTest::addColumn<uint>("file");
+    QTest::addColumn<uint>("offset");
+    QTest::addColumn<int>("len");
+    QTest::addColumn<uint>("sw");
+
+    QTest::newRow("ok") << uint(NDEF_FID) << 2u << 32 << uint(SW_OK);
+    QTest::newRow("all") << uint(NDEF_FID) << 0u << 34 << uint(SW_OK);
+    QTest::newRow("last") << uint(NDEF_FID) << 0x21u << 1 << uint(SW_OK);
+    QTest::newRow("empty") << uint(NDEF_FID) << 0u << 0 <<
+        uint(SW_WRONG_LENGTH);
+    QTest::newRow("too_long") << uint(NDEF_FID) << 0u << 35 <<
+        uint(SW_WRONG_LENGTH);
+    QTest::newRow("past_end") << uint(NDEF_FID) << 0x21u << 2 <<
+        uint(SW_WRONG_LENGTH);
+    QTest::newRow("end") << uint(NDEF_FID) << 0x22u << 1 <<
+        uint(SW_WRONG_OFFSET);
+    QTest::newRow("max_offset") << uint(NDEF_FID) << 0x7fffu << 1 <<
+        uint(SW_WRONG_OFFSET);
+    QTest::newRow("sfi") << uint(NDEF_FID) << 0x8100u << 1 <<
+        uint(SW_FUNC_NOT_SUPPORTED);
+    QTest::newRow("cc") << uint(CC_FID) << 0u << 2 << uint(SW_READ_ONLY);
+    QTest::newRow("mf") << uint(MF_FID) << 0u << 2 << uint(SW_NO_CURRENT_EF);
+}
+
+void
+TestNdefTag::update()
+{
+    QFETCH(uint, file);
+    QFETCH(uint, offset);
+    QFETCH(int, len);
+    QFETCH(uint, sw);
+
+    const QByteArray ndef(payload(16));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    const NdefTag::Response r((TestNdefTag::sw(selectFile(tag, file)) ==
+        SW_OK) ? write(tag, offset, QByteArray(len, 0x55)) :
+        NdefTag::Response());
+
+    QCOMPARE(TestNdefTag::sw(r), sw);
+    QVERIFY(r.data().isEmpty());
+
+    // Nothing gets received either way (NLEN is either 0 or too large)
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QVERIFY(tag.received().isEmpty());
+
+    // And what the reader hasn't committed never shows up in what
+    // it reads
+    QCOMPARE(readAll(tag, 0), ndef);
+}
+
+void
+TestNdefTag::receive()
+{
+    const QByteArray ndef(payload(16));
+    const QByteArray msg(payload(20).toHex().left(20));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    NdefTag::Response r;
+
+    // [NFCForum-TS-Type-4-Tag_2.0] 5.4.5 NDEF Update Procedure
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = write(tag, 0, word(0));
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    r = write(tag, 2, msg.left(10));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    r = write(tag, 12, msg.mid(10));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QVERIFY(tag.received().isEmpty());
+    r = write(tag, 0, word(msg.size()));
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg);
+
+    // Confirming it again changes nothing
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.received(), msg);
+
+    // Neither does replacing what's being read
+    tag.replace(ndef.constData(), 8);
+    QCOMPARE(readAll(tag, 0), ndef.left(8));
+}
+
+void
+TestNdefTag::receiveSingleWrite()
+{
+    const QByteArray ndef(payload(16));
+    const QByteArray msg(payload(32));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    NdefTag::Response r;
+
+    // NLEN and the whole message at once, filling up the buffer
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = write(tag, 0, word(msg.size()) + msg);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg);
+}
+
+void
+TestNdefTag::receiveUnconfirmed()
+{
+    const QByteArray ndef(payload(16));
+    const QByteArray msg(payload(10));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    NdefTag::Response r;
+
+    // The reader didn't get the response, it's not committed
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = write(tag, 0, word(msg.size()) + msg);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), false), int(NdefTag::EventNone));
+    QVERIFY(tag.received().isEmpty());
+
+    // Neither is a response which isn't the last one
+    r = write(tag, 0, word(msg.size()));
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id() - 1, true), int(NdefTag::EventNone));
+    QVERIFY(tag.received().isEmpty());
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg);
+}
+
+void
+TestNdefTag::receiveZeroNlen()
+{
+    const QByteArray ndef(payload(16));
+    const QByteArray msg1(payload(10));
+    const QByteArray msg2(payload(12).toHex().left(12));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    NdefTag::Response r1, r2;
+
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r1 = write(tag, 0, word(msg1.size()) + msg1);
+    QCOMPARE(tag.responseStatus(r1.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg1);
+
+    // Zero NLEN starts the next update and commits nothing
+    r2 = write(tag, 0, word(0));
+    QCOMPARE(sw(r2), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r2.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.received(), msg1);
+
+    // Even if NLEN gets zeroed before the previous commit is confirmed
+    r1 = write(tag, 0, word(msg2.size()) + msg2);
+    QCOMPARE(sw(r1), uint(SW_OK));
+    r2 = write(tag, 0, word(0));
+    QCOMPARE(sw(r2), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r1.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.responseStatus(r2.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.received(), msg1);
+
+    // Zero NLEN written together with the data is no commit either
+    r1 = write(tag, 0, word(0) + msg2);
+    QCOMPARE(tag.responseStatus(r1.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.received(), msg1);
+}
+
+void
+TestNdefTag::receiveNlenFirst()
+{
+    const QByteArray ndef(payload(16));
+    const QByteArray msg1(payload(10));
+    const QByteArray msg2(payload(10).toHex().left(10));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    NdefTag::Response r;
+
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = write(tag, 0, word(msg1.size()) + msg1);
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg1);
+
+    // Setting NLEN first commits whatever the buffer holds at the time,
+    // data written after that don't count until NLEN is written again
+    r = write(tag, 0, word(msg2.size()));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg1);
+    r = write(tag, 2, msg2);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QCOMPARE(tag.received(), msg1);
+    r = write(tag, 0, word(msg2.size()));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg2);
+
+    // Half of NLEN counts as NLEN too (the other half is already there)
+    r = write(tag, 1, QByteArray(1, (char)5));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg2.left(5));
+}
+
+void
+TestNdefTag::receiveInvalidNlen()
+{
+    const QByteArray ndef(payload(16));
+    const QByteArray msg(payload(10));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    NdefTag::Response r;
+
+    // NLEN larger than the buffer is written but ignored
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = write(tag, 0, word(33) + msg);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QVERIFY(tag.received().isEmpty());
+    r = write(tag, 0, word(0xffff));
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventNone));
+    QVERIFY(tag.received().isEmpty());
+
+    // The valid one still works
+    r = write(tag, 0, word(msg.size()));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg);
+}
+
+void
+TestNdefTag::receiveLarge()
+{
+    const QByteArray ndef(payload(64));
+    const QByteArray msg(payload(64).toHex().left(64));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 16);
+    NdefTag::Response r;
+
+    // The CC says the file is as large as the message being read,
+    // that's how much the reader may write back
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = write(tag, 0, word(msg.size()) + msg + 'x');
+    QCOMPARE(sw(r), uint(SW_WRONG_LENGTH));
+    r = write(tag, 0, word(msg.size()) + msg);
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(tag.received(), msg);
+}
+
+void
+TestNdefTag::readWritten()
+{
+    const QByteArray ndef(payload(16));
+    const QByteArray msg(payload(10).toHex().left(10));
+    NdefTag tag(ndef.constData(), ndef.size(), 0, 32);
+    NdefTag::Response r;
+
+    // Reading the NDEF file back right after the update, without
+    // selecting it again, returns what has just been written
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    r = write(tag, 0, word(msg.size()) + msg);
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    r = read(tag, 0, 2 + msg.size());
+    QCOMPARE(sw(r), uint(SW_OK));
+    QCOMPARE(r.data(), word(msg.size()) + msg);
+
+    // So does the next reader, which doesn't count as reading
+    // the original message
+    QCOMPARE(readAll(tag, 0), msg);
+    QCOMPARE(tag.bytesRead(), 0u);
+    QVERIFY(!tag.isDone());
+
+    // Until the next update
+    r = write(tag, 0, word(4));
+    QCOMPARE(tag.responseStatus(r.id(), true), int(NdefTag::EventReceived));
+    QCOMPARE(readAll(tag, 0), msg.left(4));
+
+    // Or the next message
+    tag.replace(ndef.constData(), ndef.size());
+    QVERIFY(tag.received().isEmpty());
+    QCOMPARE(readAll(tag, 0), ndef);
+    QVERIFY(tag.isDone());
+}
+
+// ==========================================================================
+// Benchmarks
+// ==========================================================================
+
+void
+TestNdefTag::benchSelect()
+{
+    const QByteArray ndef(payload(100));
+    const QByteArray ccFid(word(CC_FID));
+    const QByteArray ndefFid(word(NDEF_FID));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    QBENCHMARK {
+        process(tag, INS_SELECT, 0x00, 0x0c, ccFid);
+        process(tag, INS_SELECT, 0x00, 0x0c, ndefFid);
+    }
+}
+
+void
+TestNdefTag::benchReadBinary_data()
+{
+    QTest::addColumn<uint>("le");
+
+    QTest::newRow("16") << 16u;
+    QTest::newRow("256") << 0x100u;
+    QTest::newRow("4096") << 0x1000u;
+    QTest::newRow("65535") << 0xffffu;
+}
+
+void
+TestNdefTag::benchReadBinary()
+{
+    QFETCH(uint, le);
+
+    // One confirmed chunk at a time, including the bookkeeping
+    const QByteArray ndef(payload(NdefTag::maxMessageSize()));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    QCOMPARE(sw(selectFile(tag, NDEF_FID)), uint(SW_OK));
+    QBENCHMARK {
+        tag.responseStatus(read(tag, 2, le).id(), true);
+    }
+}
+
+void
+TestNdefTag::benchSequence_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<uint>("le");
+
+    QTest::newRow("100/256") << 100 << 0x100u;
+    QTest::newRow("1024/59") << 1024 << 59u;
+    QTest::newRow("1024/256") << 1024 << 0x100u;
+    QTest::newRow("1024/max") << 1024 << 0u;
+    QTest::newRow("32768/256") << 32768 << 0x100u;
+    QTest::newRow("32768/max") << 32768 << 0u;
+    QTest::newRow("max/256") << int(NdefTag::maxMessageSize()) << 0x100u;
+    QTest::newRow("max/max") << int(NdefTag::maxMessageSize()) << 0u;
+}
+
+void
+TestNdefTag::benchSequence()
+{
+    QFETCH(int, size);
+    QFETCH(uint, le);
+
+    // The whole detection and read sequence, as seen by the tag
+    const QByteArray ndef(payload(size));
+    NdefTag tag(ndef.constData(), ndef.size());
+
+    QCOMPARE(readAll(tag, le), ndef);
+    QBENCHMARK {
+        readAll(tag, le);
+    }
+}
+
+QTEST_APPLESS_MAIN(TestNdefTag)
+#include "test_ndeftag.moc"
@@ -0,0 +1,10 @@
+TARGET = test_nfcshare
+
+include(../common/common.pri)
+
+# Only the static NfcShare helpers, nothing talks to nfcd
+LIBS += -L$$OUT_PWD/../../lib -lnfcshare
+QMAKE_RPATHDIR += $$OUT_PWD/../../lib
+
+SOURCES += \
+    test_nfcshare.cpp
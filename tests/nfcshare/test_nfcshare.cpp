@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// NfcShare::encodedSize() against what NfcShare::encode() actually
+// produces, for every kind of text encodedSize() has to take into
+// account: 1, 2, 3 and 4 byte UTF-8 sequences, unpaired surrogates,
+// all four abbreviated URI prefixes and URLs which only look like ones.
+
+#include "ndefapp.h"
+#include "nfcshare.h"
+
+#include <QtTest/QtTest>
+
+#define NDEF_FLAG_SR (0x10)
+
+class TestNfcShare :
+    public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void encodedSize_data();
+    void encodedSize();
+    void encodedSizeLimit();
+
+private:
+    static char recordType(const QByteArray&);
+};
+
+//static
+char
+TestNfcShare::recordType(
+    const QByteArray& aNdef)
+{
+    // Flags, type length, 1 or 4 bytes of payload length, type
+    const int off = (aNdef.size() > 0 && (aNdef.at(0) & NDEF_FLAG_SR)) ?
+        3 : 6;
+
+    return (aNdef.size() > off) ? aNdef.at(off) : 0;
+}
+
+void
+TestNfcShare::encodedSize_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<char>("type");
+
+    QTest::newRow("empty") << QString() << 'T';
+    QTest::newRow("ascii") << QString("Hello, world!") << 'T';
+    QTest::newRow("ascii/long") << QString(300, QChar('a')) << 'T';
+    QTest::newRow("2-byte") << QString::fromUtf8("Grüße aus Ελλάδα") <<
+        'T';
+    QTest::newRow("3-byte") << QString::fromUtf8("日本語のテキスト") << 'T';
+    QTest::newRow("surrogate-pair") <<
+        QString::fromUtf8("emoji \xf0\x9f\x98\x80\xf0\x9f\x8e\x89") << 'T';
+    QTest::newRow("unpaired/high") << (QString("a") + QChar(0xd83d) +
+        QString("b")) << 'T';
+    QTest::newRow("unpaired/low") << (QString("a") + QChar(0xde00) +
+        QString("b")) << 'T';
+    QTest::newRow("unpaired/end") << (QString("a") + QChar(0xd83d)) << 'T';
+    QTest::newRow("unpaired/swapped") << (QString("a") + QChar(0xde00) +
+        QChar(0xd83d)) << 'T';
+    QTest::newRow("uri/http") << QString("http://example.com/path") << 'U';
+    QTest::newRow("uri/https") << QString("https://example.com/") << 'U';
+    QTest::newRow("uri/http-www") << QString("http://www.example.com/") <<
+        'U';
+    QTest::newRow("uri/https-www") <<
+        QString("https://www.example.com/a?b=c") << 'U';
+    QTest::newRow("uri/non-ascii") <<
+        QString::fromUtf8("https://example.com/päth/日本") << 'U';
+    QTest::newRow("uri/invalid") << QString("http://[invalid") << 'T';
+    QTest::newRow("uri/invalid-www") << QString("https://www.[invalid") <<
+        'T';
+    QTest::newRow("uri/no-prefix") << QString("ftp://example.com/") << 'T';
+}
+
+void
+TestNfcShare::encodedSize()
+{
+    QFETCH(QString, text);
+    QFETCH(char, type);
+
+    const QByteArray ndef(NfcShare::encode(text));
+
+    QVERIFY(!ndef.isEmpty());
+    QCOMPARE(recordType(ndef), type);
+    QVERIFY(uint(ndef.size()) <= NdefApp::maxMessageSize());
+    QCOMPARE(NfcShare::encodedSize(text), uint(ndef.size()));
+}
+
+void
+TestNfcShare::encodedSizeLimit()
+{
+    // Counting stops past the limit, what's left is still too much
+    const uint max = NdefApp::maxMessageSize();
+    const QString fits(max - 16, QChar('a'));
+    const QString tooLarge(max + 1, QChar('a'));
+
+    QCOMPARE(NfcShare::encodedSize(fits), uint(NfcShare::encode(fits).size()));
+    QVERIFY(NfcShare::encodedSize(tooLarge) > max);
+    QVERIFY(NfcShare::encodedSize(QString("http://") + tooLarge) > max);
+}
+
+QTEST_GUILESS_MAIN(TestNfcShare)
+#include "test_nfcshare.moc"
@@ -0,0 +1,6 @@
+TARGET = test_snep
+
+include(../common/testbus.pri)
+
+SOURCES += \
+    test_snep.cpp
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// SNEP push against the stand-in nfcd's P2P peer: single fragment and
+// Continue, the peer rejecting the request or hanging up and NdefApp
+// retrying with the peer which is still in the field, until it gives up.
+
+#include "ndefapp.h"
+#include "testbus.h"
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+#define WAIT_TIMEOUT_MS (10000)
+#define CLEANUP_TIMEOUT_MS (2000)
+
+#define SNEP_CLOSE (0x00)       // The mock closes the socket
+#define SNEP_SUCCESS (0x81)
+#define SNEP_NOT_FOUND (0xc0)
+#define SNEP_REJECT (0xff)
+
+// One more than NdefApp retries with the same peer
+#define SNEP_GIVE_UP (4)
+
+class TestSnep :
+    public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void push_data();
+    void push();
+
+private:
+    static QByteArray payload(int);
+
+private:
+    TestBus iBus;
+};
+
+//static
+QByteArray
+TestSnep::payload(
+    int aSize)
+{
+    // The peer doesn't look inside, any bytes would do
+    QByteArray data(aSize, 0);
+
+    for (int i = 0; i < aSize; i++) {
+        data[i] = (char)(i * 31 + 7);
+    }
+    return data;
+}
+
+void
+TestSnep::initTestCase()
+{
+    QVERIFY(iBus.start());
+}
+
+void
+TestSnep::cleanup()
+{
+    TestBus::Registrations left;
+
+    QVERIFY(iBus.waitForRegistrations(left, CLEANUP_TIMEOUT_MS));
+    QVERIFY(left.isEmpty());
+}
+
+void
+TestSnep::push_data()
+{
+    const QByteArray reject(SNEP_GIVE_UP, (char)SNEP_REJECT);
+
+    QTest::addColumn<int>("size");
+    QTest::addColumn<QByteArray>("responses");
+    QTest::addColumn<bool>("done");
+    QTest::addColumn<uint>("continues");
+
+    // 6 bytes of SNEP header + 122 bytes fit into the first fragment
+    QTest::newRow("single") << 122 <<
+        QByteArray(1, (char)SNEP_SUCCESS) << true << 0u;
+    QTest::newRow("fragments/123") << 123 <<
+        QByteArray(1, (char)SNEP_SUCCESS) << true << 1u;
+    QTest::newRow("fragments/4096") << 4096 <<
+        QByteArray(1, (char)SNEP_SUCCESS) << true << 1u;
+    QTest::newRow("reject/single") << 64 <<
+        (QByteArray(1, (char)SNEP_REJECT) + (char)SNEP_SUCCESS) <<
+        true << 0u;
+    QTest::newRow("reject/fragments") << 1024 <<
+        (QByteArray(1, (char)SNEP_NOT_FOUND) + (char)SNEP_SUCCESS) <<
+        true << 2u;
+    QTest::newRow("close/single") << 64 <<
+        (QByteArray(1, (char)SNEP_CLOSE) + (char)SNEP_SUCCESS) <<
+        true << 0u;
+    QTest::newRow("close/fragments") << 1024 <<
+        (QByteArray(1, (char)SNEP_CLOSE) + (char)SNEP_SUCCESS) <<
+        true << 2u;
+    QTest::newRow("give-up") << 64 << reject << false << 0u;
+}
+
+void
+TestSnep::push()
+{
+    QFETCH(int, size);
+    QFETCH(QByteArray, responses);
+    QFETCH(bool, done);
+    QFETCH(uint, continues);
+
+    const QByteArray ndef(payload(size));
+    NdefApp app(ndef.constData(), ndef.size(), NdefApp::TransportSnep,
+        Q_NULLPTR);
+    QSignalSpy doneSpy(&app, SIGNAL(done()));
+
+    QVERIFY(!app.isTooMuchData());
+
+    // Returns when the peer has left the field
+    TestBus::Push push;
+
+    QVERIFY2(iBus.push(responses, push), qPrintable(push.iError));
+    QCOMPARE(push.iConnections, uint(responses.size()));
+    QCOMPARE(push.iContinues, continues);
+    QCOMPARE(app.getMetrics()->retryCount(), uint(responses.size() - 1) +
+        (done ? 0 : 1));
+    if (done) {
+        QCOMPARE(push.iNdef, ndef);
+        QVERIFY(app.isDone() || doneSpy.wait(WAIT_TIMEOUT_MS));
+        QCOMPARE(app.getBytesTransferred(), app.getBytesTotal());
+    } else {
+        QVERIFY(push.iNdef.isEmpty());
+        QVERIFY(!app.isDone());
+        QVERIFY(!doneSpy.wait(1000));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestSnep)
+#include "test_snep.moc"
@@ -0,0 +1,12 @@
+TARGET = test_soak
+
+include(../common/testbus.pri)
+include(../common/heapstats.pri)
+
+# Same as libnfcshare, soaks both backends if set
+CONFIG(use_gio) {
+    DEFINES += HAVE_GIO
+}
+
+SOURCES += \
+    test_soak.cpp
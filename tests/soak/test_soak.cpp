@@ -0,0 +1,390 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// Soak test: cycles thousands of NdefApp instances against the stand-in
+// nfcd and watches for anything that accumulates. Each scenario runs in
+// windows, after each window the pending calls are allowed to settle
+// and the heap, RSS, allocations per cycle and p99 latency get sampled.
+// The last window is compared with the first one, growth beyond the
+// limits below fails the test. Nothing may be left registered with the
+// mock after any window either.
+//
+// SOAK_CYCLES environment variable overrides the number of cycles.
+
+#include "heapstats.h"
+#include "ndefapp.h"
+#include "testbus.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+#define SOAK_CYCLES_ENV "SOAK_CYCLES"
+#define SOAK_CYCLES (2000)
+#define SOAK_WINDOWS (10)
+#define SOAK_WARMUP (20)            // Cycles to fill caches and pools
+
+#define WAIT_TIMEOUT_MS (10000)
+#define SETTLE_TIMEOUT_MS (5000)
+#define REPLY_DELAY_MS (3)          // Every registration step takes that
+#define PAYLOAD_SIZE (1024)
+#define LE_SHORT (256)
+
+#define HEAP_GROWTH_MAX (256 * 1024)
+#define RSS_GROWTH_MAX (8 * 1024 * 1024)
+#define ALLOCS_GROWTH_MAX (1.5)     // Allocations per cycle, last/first
+#define P99_GROWTH_MAX (2.0)        // Last window vs the first one
+#define P99_SLACK_US (1000)         // Scheduling noise
+
+#define NFCSHARE_DBUS_BACKEND_ENV "NFCSHARE_DBUS_BACKEND"
+
+class TestSoak :
+    public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Scenario {
+        ScenarioDestroy,    // Destroyed right after it's been created
+        ScenarioPending,    // Destroyed with a registration step pending
+        ScenarioReady,      // Destroyed once it's ready
+        ScenarioTap         // Read by the reader, then destroyed
+    };
+
+private:
+    class Sample {
+    public:
+        size_t iHeap;
+        size_t iRss;
+        qreal iAllocsPerCycle;
+        uint iP99Us;
+    };
+
+    class Result {
+    public:
+        QString iName;
+        int iCycles;
+        Sample iFirst;
+        Sample iLast;
+        size_t iPeakHeap;
+    };
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+    void soak_data();
+    void soak();
+
+private:
+    static int soakCycles();
+    static QByteArray payload(int);
+    static uint percentile(QList<uint>, int);
+    bool cycle(Scenario, int, QList<uint>&);
+    bool settle();
+
+private:
+    TestBus iBus;
+    QList<Result> iResults;
+};
+
+//static
+int
+TestSoak::soakCycles()
+{
+    bool ok;
+    const int n = qgetenv(SOAK_CYCLES_ENV).toInt(&ok);
+
+    return (ok && n > 0) ? n : SOAK_CYCLES;
+}
+
+//static
+QByteArray
+TestSoak::payload(
+    int aSize)
+{
+    QByteArray data(aSize, 0);
+
+    for (int i = 0; i < aSize; i++) {
+        data[i] = (char)(i * 31 + 7);
+    }
+    return data;
+}
+
+//static
+uint
+TestSoak::percentile(
+    QList<uint> aValues,
+    int aPercent)
+{
+    if (aValues.isEmpty()) {
+        return 0;
+    } else {
+        const int i = (aValues.count() * aPercent + 99) / 100 - 1;
+
+        std::sort(aValues.begin(), aValues.end());
+        return aValues.at(qBound(0, i, aValues.count() - 1));
+    }
+}
+
+void
+TestSoak::initTestCase()
+{
+    QVERIFY(iBus.start());
+}
+
+void
+TestSoak::cleanupTestCase()
+{
+    QTextStream out(stdout);
+
+    out << "\nscenario      cycles  heap,KiB   rss,KiB  allocs/cycle"
+        "    p99,us  peak heap,KiB\n";
+    for (int i = 0; i < iResults.count(); i++) {
+        const Result& r = iResults.at(i);
+
+        out << qSetFieldWidth(14) << left << r.iName << right <<
+            qSetFieldWidth(6) << r.iCycles <<
+            qSetFieldWidth(10) << QString("%1%2").arg(r.iLast.iHeap >=
+                r.iFirst.iHeap ? "+" : "-").arg(qAbs(qint64(r.iLast.iHeap) -
+                qint64(r.iFirst.iHeap)) / 1024) <<
+            qSetFieldWidth(10) << QString("%1%2").arg(r.iLast.iRss >=
+                r.iFirst.iRss ? "+" : "-").arg(qAbs(qint64(r.iLast.iRss) -
+                qint64(r.iFirst.iRss)) / 1024) <<
+            qSetFieldWidth(14) << QString("%1 -> %2").
+                arg(r.iFirst.iAllocsPerCycle, 0, 'f', 0).
+                arg(r.iLast.iAllocsPerCycle, 0, 'f', 0) <<
+            qSetFieldWidth(10) << QString("%1 -> %2").
+                arg(r.iFirst.iP99Us).arg(r.iLast.iP99Us) <<
+            qSetFieldWidth(15) << r.iPeakHeap / 1024 <<
+            qSetFieldWidth(0) << "\n";
+    }
+}
+
+void
+TestSoak::cleanup()
+{
+    iBus.setReplyDelay(0);
+}
+
+bool
+TestSoak::settle()
+{
+    TestBus::Registrations left;
+
+    // Let the orphaned calls complete and undo what they've done
+    if (!iBus.waitForRegistrations(left, SETTLE_TIMEOUT_MS)) {
+        return false;
+    }
+    QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+    QCoreApplication::processEvents();
+    if (!left.isEmpty()) {
+        qWarning() << "Left behind:" << left.iApps << "apps," <<
+            left.iModes << "modes," << left.iTechs << "techs," <<
+            left.iDropped << "dropped";
+        return false;
+    }
+    return true;
+}
+
+bool
+TestSoak::cycle(
+    Scenario aScenario,
+    int aIndex,
+    QList<uint>& aLatencies)
+{
+    static const QByteArray ndef(payload(PAYLOAD_SIZE));
+    QElapsedTimer timer;
+
+    timer.start();
+    NdefApp* app = new NdefApp(ndef.constData(), ndef.size(),
+        NdefApp::TransportType4, Q_NULLPTR);
+    bool ok = !app->isTooMuchData();
+
+    switch (aScenario) {
+    case ScenarioDestroy:
+        break;
+    case ScenarioPending:
+        // Registration steps take REPLY_DELAY_MS each, this hits
+        // each of them as well as the gaps between them
+        QTest::qWait(aIndex % (4 * REPLY_DELAY_MS));
+        break;
+    case ScenarioReady:
+    case ScenarioTap:
+        if (!app->isReady()) {
+            QSignalSpy readySpy(app, SIGNAL(readyChanged()));
+
+            ok = ok && readySpy.wait(WAIT_TIMEOUT_MS) && app->isReady();
+        }
+        break;
+    }
+
+    if (ok && aScenario == ScenarioTap) {
+        QSignalSpy doneSpy(app, SIGNAL(done()));
+        TestBus::Read read;
+
+        // APDU round trips are what the user would notice
+        ok = iBus.read(LE_SHORT, read) && read.iNdef == ndef &&
+            (app->isDone() || doneSpy.wait(WAIT_TIMEOUT_MS));
+        aLatencies.append(read.iLatencies);
+        if (!ok) {
+            qWarning() << "Read failed:" << read.iError;
+        }
+    }
+
+    delete app;
+    if (aScenario != ScenarioTap) {
+        aLatencies.append(uint(timer.nsecsElapsed() / 1000));
+    }
+    return ok;
+}
+
+void
+TestSoak::soak_data()
+{
+    static const struct {
+        Scenario scenario;
+        const char* name;
+        int divider;        // Slow scenarios run fewer cycles
+    } scenarios[] = {
+        { ScenarioDestroy, "destroy", 1 },
+        { ScenarioPending, "pending", 4 },
+        { ScenarioReady, "ready", 4 },
+        { ScenarioTap, "tap", 10 }
+    };
+    const int n = soakCycles();
+    QStringList backends;
+
+    backends.append("qt");
+#ifdef HAVE_GIO
+    backends.append("gio");
+#endif
+
+    QTest::addColumn<QString>("backend");
+    QTest::addColumn<int>("scenario");
+    QTest::addColumn<int>("cycles");
+    for (int k = 0; k < backends.count(); k++) {
+        for (uint i = 0; i < sizeof(scenarios)/sizeof(scenarios[0]); i++) {
+            const QString name(backends.at(k) + "/" + scenarios[i].name);
+
+            QTest::newRow(name.toLatin1()) << backends.at(k) <<
+                int(scenarios[i].scenario) << qMax(n / scenarios[i].divider,
+                SOAK_WINDOWS);
+        }
+    }
+}
+
+void
+TestSoak::soak()
+{
+    QFETCH(QString, backend);
+    QFETCH(int, scenario);
+    QFETCH(int, cycles);
+
+    const Scenario s = (Scenario)scenario;
+    const int perWindow = cycles / SOAK_WINDOWS;
+    QList<uint> latencies;
+    QList<Sample> samples;
+    HeapStats stats;
+    Result result;
+    int i;
+
+    // Picked up by each new NdefApp
+    qputenv(NFCSHARE_DBUS_BACKEND_ENV, backend.toLatin1());
+    if (s == ScenarioPending) {
+        QVERIFY(iBus.setReplyDelay(REPLY_DELAY_MS));
+    }
+
+    for (i = 0; i < SOAK_WARMUP; i++) {
+        QVERIFY(cycle(s, i, latencies));
+    }
+    QVERIFY(settle());
+    heap_stats_reset_peak();
+
+    for (int w = 0; w < SOAK_WINDOWS; w++) {
+        Sample sample;
+        unsigned long allocs;
+
+        heap_stats_get(&stats);
+        allocs = stats.allocs;
+        latencies.clear();
+        for (int k = 0; k < perWindow; k++, i++) {
+            QVERIFY2(cycle(s, i, latencies), qPrintable(QString("Cycle %1").
+                arg(i)));
+        }
+        QVERIFY(settle());
+        heap_stats_get(&stats);
+        sample.iHeap = stats.current;
+        sample.iRss = stats.rss;
+        sample.iAllocsPerCycle = qreal(stats.allocs - allocs) / perWindow;
+        sample.iP99Us = percentile(latencies, 99);
+        samples.append(sample);
+    }
+
+    heap_stats_get(&stats);
+    result.iName = QString(QTest::currentDataTag());
+    result.iCycles = perWindow * SOAK_WINDOWS;
+    result.iFirst = samples.first();
+    result.iLast = samples.last();
+    result.iPeakHeap = stats.peak;
+    iResults.append(result);
+
+    const Sample& first = result.iFirst;
+    const Sample& last = result.iLast;
+
+    QVERIFY2(last.iHeap <= first.iHeap + HEAP_GROWTH_MAX,
+        qPrintable(QString("Heap grew by %1 bytes").arg(last.iHeap -
+            first.iHeap)));
+    QVERIFY2(last.iRss <= first.iRss + RSS_GROWTH_MAX,
+        qPrintable(QString("RSS grew by %1 bytes").arg(last.iRss -
+            first.iRss)));
+    QVERIFY2(last.iAllocsPerCycle <= first.iAllocsPerCycle *
+        ALLOCS_GROWTH_MAX, qPrintable(QString("Allocations per cycle went "
+            "from %1 to %2").arg(first.iAllocsPerCycle).
+            arg(last.iAllocsPerCycle)));
+    QVERIFY2(last.iP99Us <= first.iP99Us * P99_GROWTH_MAX + P99_SLACK_US,
+        qPrintable(QString("p99 went from %1 to %2 us").arg(first.iP99Us).
+            arg(last.iP99Us)));
+}
+
+QTEST_GUILESS_MAIN(TestSoak)
+#include "test_soak.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+SUBDIRS = type4tag ndeftag nfcshare decoder mocknfcd transfer soak encode snep handover
+
+# The stand-in nfcd has to be built first
+transfer.depends = mocknfcd
+soak.depends = mocknfcd
+encode.depends = mocknfcd
+snep.depends = mocknfcd
+handover.depends = mocknfcd
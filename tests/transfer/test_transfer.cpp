@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// End to end transfer benchmark: NdefApp registers with the stand-in
+// nfcd, which then reads the whole tag with a scripted reader. Reports
+// time to ready, APDU rate, median APDU round trip and full transfer
+// time per payload size. If libnfcshare has been built with GDBus
+// support, QtDBus and GDBus backends are measured head to head.
+
+#include "ndefapp.h"
+#include "testbus.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+#define WAIT_TIMEOUT_MS (10000)
+#define LE_MAX (0)          // The reader asks for as much as MLe allows
+#define LE_SHORT (256)      // Short Le=00
+#define CLEANUP_TIMEOUT_MS (2000)
+
+#define NFCSHARE_DBUS_BACKEND_ENV "NFCSHARE_DBUS_BACKEND"
+
+class TestTransfer :
+    public QObject
+{
+    Q_OBJECT
+
+private:
+    class Result {
+    public:
+        QString iBackend;
+        int iSize;
+        uint iLe;
+        qreal iReadyMs;
+        int iApdus;
+        qreal iApdusPerSec;
+        uint iMedianUs;
+        qreal iTransferMs;
+    };
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+    void transfer_data();
+    void transfer();
+
+private:
+    static QByteArray payload(int);
+    static uint median(QList<uint>);
+
+private:
+    TestBus iBus;
+    QList<Result> iResults;
+};
+
+//static
+QByteArray
+TestTransfer::payload(
+    int aSize)
+{
+    // The reader doesn't look inside, any bytes would do
+    QByteArray data(aSize, 0);
+
+    for (int i = 0; i < aSize; i++) {
+        data[i] = (char)(i * 31 + 7);
+    }
+    return data;
+}
+
+//static
+uint
+TestTransfer::median(
+    QList<uint> aValues)
+{
+    if (aValues.isEmpty()) {
+        return 0;
+    } else {
+        std::sort(aValues.begin(), aValues.end());
+        return aValues.at(aValues.count() / 2);
+    }
+}
+
+void
+TestTransfer::initTestCase()
+{
+    QVERIFY(iBus.start());
+}
+
+void
+TestTransfer::cleanupTestCase()
+{
+    QTextStream out(stdout);
+
+    out << "\nbackend  bytes     Le  ready,ms  APDUs   APDU/s  APDU,us"
+        "  transfer,ms\n";
+    for (int i = 0; i < iResults.count(); i++) {
+        const Result& r = iResults.at(i);
+
+        out << qSetFieldWidth(7) << r.iBackend <<
+            qSetFieldWidth(7) << r.iSize << qSetFieldWidth(7) <<
+            (r.iLe ? QString::number(r.iLe) : QString("MLe")) <<
+            qSetFieldWidth(10) << QString::number(r.iReadyMs, 'f', 2) <<
+            qSetFieldWidth(7) << r.iApdus <<
+            qSetFieldWidth(9) << QString::number(r.iApdusPerSec, 'f', 0) <<
+            qSetFieldWidth(9) << r.iMedianUs <<
+            qSetFieldWidth(13) << QString::number(r.iTransferMs, 'f', 2) <<
+            qSetFieldWidth(0) << "\n";
+    }
+}
+
+void
+TestTransfer::cleanup()
+{
+    // The next app must not run into what's left of the previous one,
+    // which may have talked to the mock over another connection
+    TestBus::Registrations left;
+
+    QVERIFY(iBus.waitForRegistrations(left, CLEANUP_TIMEOUT_MS));
+    QVERIFY(left.isEmpty());
+}
+
+void
+TestTransfer::transfer_data()
+{
+    static const int sizes[] = { 16, 64, 256, 1024, 4096, 16384, 32768 };
+    const int max = NdefApp::maxMessageSize();
+    QStringList backends;
+
+    backends.append("qt");
+#ifdef HAVE_GIO
+    backends.append("gio");
+#endif
+
+    QTest::addColumn<QString>("backend");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<uint>("le");
+    for (int k = 0; k < backends.count(); k++) {
+        const QString backend(backends.at(k));
+
+        for (uint i = 0; i <= sizeof(sizes)/sizeof(sizes[0]); i++) {
+            const bool last = (i == sizeof(sizes)/sizeof(sizes[0]));
+            const int size = last ? max : sizes[i];
+            const QString name(backend + "/" + (last ? QString("max") :
+                QString::number(size)));
+
+            QTest::newRow(QString(name + "/short").toLatin1()) <<
+                backend << size << uint(LE_SHORT);
+            QTest::newRow(QString(name + "/max").toLatin1()) <<
+                backend << size << uint(LE_MAX);
+        }
+    }
+}
+
+void
+TestTransfer::transfer()
+{
+    QFETCH(QString, backend);
+    QFETCH(int, size);
+    QFETCH(uint, le);
+
+    // Picked up by each new NdefApp
+    qputenv(NFCSHARE_DBUS_BACKEND_ENV, backend.toLatin1());
+
+    const QByteArray ndef(payload(size));
+    QElapsedTimer timer;
+    Result result;
+
+    // Time to ready covers all the registration steps
+    timer.start();
+    NdefApp app(ndef.constData(), ndef.size(), NdefApp::TransportType4,
+        Q_NULLPTR);
+    QSignalSpy readySpy(&app, SIGNAL(readyChanged()));
+    QSignalSpy doneSpy(&app, SIGNAL(done()));
+
+    QVERIFY(!app.isTooMuchData());
+    QVERIFY(app.isReady() || readySpy.wait(WAIT_TIMEOUT_MS));
+    QVERIFY(app.isReady());
+    result.iReadyMs = timer.nsecsElapsed() / 1e6;
+
+    TestBus::Read read;
+
+    QVERIFY2(iBus.read(le, read), qPrintable(read.iError));
+    QCOMPARE(read.iNdef, ndef);
+    QVERIFY(app.isDone() || doneSpy.wait(WAIT_TIMEOUT_MS));
+    QCOMPARE(app.getBytesTransferred(), app.getBytesTotal());
+
+    result.iBackend = backend;
+    result.iSize = size;
+    result.iLe = le;
+    result.iApdus = read.iLatencies.count();
+    result.iMedianUs = median(read.iLatencies);
+    result.iTransferMs = read.iTotal / 1e3;
+    result.iApdusPerSec = read.iTotal ?
+        (result.iApdus * 1e6 / read.iTotal) : 0;
+    iResults.append(result);
+    QTest::setBenchmarkResult(result.iTransferMs, QTest::WalltimeMilliseconds);
+}
+
+QTEST_GUILESS_MAIN(TestTransfer)
+#include "test_transfer.moc"
@@ -0,0 +1,11 @@
+TARGET = test_transfer
+
+include(../common/testbus.pri)
+
+# Same as libnfcshare, compares QtDBus and GDBus backends if set
+CONFIG(use_gio) {
+    DEFINES += HAVE_GIO
+}
+
+SOURCES += \
+    test_transfer.cpp
@@ -0,0 +1,611 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "type4tag.h"
+
+#include <string.h>
+
+#define SW_OK (0x9000)
+#define SW_END_OF_FILE (0x6282)
+#define SW_WRONG_LENGTH (0x6700)
+#define SW_NO_CURRENT_EF (0x6986)
+#define SW_WRONG_DATA (0x6a80)
+#define SW_FUNC_NOT_SUPPORTED (0x6a81)
+#define SW_NOT_FOUND (0x6a82)
+#define SW_WRONG_P1P2 (0x6a86)
+#define SW_WRONG_OFFSET (0x6b00)
+#define SW_INS_NOT_SUPPORTED (0x6d00)
+#define SW_CLA_NOT_SUPPORTED (0x6e00)
+
+static const guint8 test_ndef[] = {
+    0xd1, 0x01, 0x0c, 0x55, 0x04, 0x73, 0x61, 0x69,
+    0x6c, 0x66, 0x69, 0x73, 0x68, 0x6f, 0x73, 0x2e
+};
+
+static const guint8 test_aid[] = { 0xd2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01 };
+static const guint8 test_mf_fid[] = { 0x3f, 0x00 };
+static const guint8 test_cc_fid[] = { 0xe1, 0x03 };
+static const guint8 test_ndef_fid[] = { 0xe1, 0x04 };
+
+static
+guint
+test_select(
+    Type4Tag* tag,
+    const guint8* fid)
+{
+    GUtilData data, resp;
+
+    data.bytes = fid;
+    data.size = 2;
+    return type4_tag_process(tag, 0x00, 0xa4, 0x00, 0x0c, &data, 0, &resp);
+}
+
+static
+guint
+test_select_data(
+    Type4Tag* tag,
+    guint8 p1,
+    guint8 p2,
+    const void* bytes,
+    gsize size,
+    GUtilData* resp)
+{
+    GUtilData data;
+
+    data.bytes = bytes;
+    data.size = size;
+    return type4_tag_process(tag, 0x00, 0xa4, p1, p2, &data, 0, resp);
+}
+
+static
+guint
+test_read(
+    Type4Tag* tag,
+    guint offset,
+    guint le,
+    GUtilData* resp)
+{
+    return type4_tag_process(tag, 0x00, 0xb0, (guint8)(offset >> 8),
+        (guint8)offset, NULL, le, resp);
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+
+    g_assert(tag);
+    g_assert_cmpuint(type4_tag_size(tag), == ,sizeof(test_ndef) + 2);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,0);
+    g_assert(!type4_tag_fully_read(tag));
+    type4_tag_free(tag);
+    type4_tag_free(NULL);
+
+    /* NDEF file (NLEN + message) must fit into 0xfffe bytes */
+    g_assert(!type4_tag_new(NULL, 0xfffd, 0));
+}
+
+/*==========================================================================*
+ * select
+ *==========================================================================*/
+
+static
+void
+test_select_ok(
+    void)
+{
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+    GUtilData resp;
+
+    g_assert_cmpuint(test_select(tag, test_cc_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,2);
+    g_assert_cmpuint(resp.bytes[1], == ,0x0f);
+
+    g_assert_cmpuint(test_select(tag, test_ndef_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,2);
+    g_assert_cmpuint(resp.bytes[1], == ,sizeof(test_ndef));
+    type4_tag_free(tag);
+}
+
+static
+void
+test_select_fail(
+    void)
+{
+    static const guint8 bad_fid[] = { 0xe1, 0x05 };
+    static const guint8 long_fid[] = { 0xe1, 0x03, 0x00 };
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+    GUtilData data, resp;
+
+    g_assert_cmpuint(test_select(tag, bad_fid), == ,SW_NOT_FOUND);
+
+    data.bytes = long_fid;
+    data.size = sizeof(long_fid);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xa4, 0x00, 0x0c,
+        &data, 0, &resp), == ,SW_WRONG_LENGTH);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xa4, 0x00, 0x0c,
+        NULL, 0, &resp), == ,SW_WRONG_LENGTH);
+
+    /* Unsupported P1, P2 and occurrence */
+    g_assert_cmpuint(test_select_data(tag, 0x01, 0x0c, test_cc_fid, 2,
+        &resp), == ,SW_WRONG_P1P2);
+    g_assert_cmpuint(test_select_data(tag, 0x00, 0x1c, test_cc_fid, 2,
+        &resp), == ,SW_WRONG_P1P2);
+    g_assert_cmpuint(test_select_data(tag, 0x00, 0x0e, test_cc_fid, 2,
+        &resp), == ,SW_NOT_FOUND);
+
+    /* Paths which go nowhere */
+    g_assert_cmpuint(test_select_data(tag, 0x08, 0x0c, long_fid, 3,
+        &resp), == ,SW_WRONG_LENGTH);
+    g_assert_cmpuint(test_select_data(tag, 0x08, 0x0c, NULL, 0,
+        &resp), == ,SW_WRONG_LENGTH);
+    data.bytes = (const guint8*)"\xe1\x03\xe1\x04";
+    data.size = 4;
+    g_assert_cmpuint(test_select_data(tag, 0x08, 0x0c, data.bytes,
+        data.size, &resp), == ,SW_NOT_FOUND);
+
+    /* Unknown application and the v1 one which the plugin doesn't serve */
+    data.bytes = (const guint8*)"\xd2\x76\x00\x00\x85\x01\x00";
+    data.size = 7;
+    g_assert_cmpuint(test_select_data(tag, 0x04, 0x00, data.bytes,
+        data.size, &resp), == ,SW_NOT_FOUND);
+    g_assert_cmpuint(test_select_data(tag, 0x04, 0x00, test_aid, 6,
+        &resp), == ,SW_NOT_FOUND);
+
+    /* Wrong CLA and unknown INS */
+    data.bytes = test_cc_fid;
+    data.size = sizeof(test_cc_fid);
+    g_assert_cmpuint(type4_tag_process(tag, 0x80, 0xa4, 0x00, 0x0c,
+        &data, 0, &resp), == ,SW_CLA_NOT_SUPPORTED);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xca, 0x00, 0x00,
+        NULL, 0, &resp), == ,SW_INS_NOT_SUPPORTED);
+
+    /* Nothing is selected yet */
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_NO_CURRENT_EF);
+    g_assert(!resp.size);
+    type4_tag_free(tag);
+}
+
+static
+void
+test_select_variants(
+    void)
+{
+    static const guint8 mf_cc_path[] = { 0x3f, 0x00, 0xe1, 0x03 };
+    static const guint8 fci[] = {
+        0x6f, 0x0b, 0x80, 0x02, 0x00, 0x0f, 0x82, 0x01, 0x01,
+        0x83, 0x02, 0xe1, 0x03
+    };
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+    const gsize file_size = sizeof(test_ndef) + 2;
+    GUtilData resp;
+
+    /* FCI, FCP and FMD */
+    g_assert_cmpuint(test_select_data(tag, 0x00, 0x00, test_cc_fid, 2,
+        &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,sizeof(fci));
+    g_assert(!memcmp(resp.bytes, fci, sizeof(fci)));
+    g_assert_cmpuint(test_select_data(tag, 0x00, 0x04, test_ndef_fid, 2,
+        &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,sizeof(fci));
+    g_assert_cmpuint(resp.bytes[0], == ,0x62);
+    g_assert_cmpuint(resp.bytes[4], == ,file_size >> 8);
+    g_assert_cmpuint(resp.bytes[5], == ,file_size & 0xff);
+    g_assert(!memcmp(resp.bytes + 11, test_ndef_fid, 2));
+    g_assert_cmpuint(test_select_data(tag, 0x00, 0x08, test_cc_fid, 2,
+        &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,2);
+    g_assert_cmpuint(resp.bytes[0], == ,0x64);
+    g_assert_cmpuint(resp.bytes[1], == ,0x00);
+
+    /* Last occurrence is the same as the first one */
+    g_assert_cmpuint(test_select_data(tag, 0x00, 0x0d, test_ndef_fid, 2,
+        &resp), == ,SW_OK);
+    g_assert(!resp.size);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.bytes[1], == ,sizeof(test_ndef));
+
+    /* Child EF and paths */
+    g_assert_cmpuint(test_select_data(tag, 0x02, 0x0c, test_cc_fid, 2,
+        &resp), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.bytes[1], == ,0x0f);
+    g_assert_cmpuint(test_select_data(tag, 0x09, 0x0c, test_ndef_fid, 2,
+        &resp), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.bytes[1], == ,sizeof(test_ndef));
+    g_assert_cmpuint(test_select_data(tag, 0x08, 0x0c, mf_cc_path,
+        sizeof(mf_cc_path), &resp), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.bytes[1], == ,0x0f);
+
+    /* Selecting the MF or the application deselects the EF */
+    g_assert_cmpuint(test_select(tag, test_mf_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_NO_CURRENT_EF);
+    g_assert_cmpuint(test_select(tag, test_cc_fid), == ,SW_OK);
+    g_assert_cmpuint(test_select_data(tag, 0x04, 0x00, test_aid,
+        sizeof(test_aid), &resp), == ,SW_OK);
+    g_assert(!resp.size);
+    g_assert_cmpuint(test_read(tag, 0, 2, &resp), == ,SW_NO_CURRENT_EF);
+    type4_tag_free(tag);
+}
+
+/*==========================================================================*
+ * cc
+ *==========================================================================*/
+
+static
+void
+test_cc(
+    void)
+{
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+    const gsize file_size = sizeof(test_ndef) + 2;
+    GUtilData resp;
+
+    g_assert_cmpuint(test_select(tag, test_cc_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 15, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,15);
+    g_assert_cmpuint(resp.bytes[0], == ,0x00);
+    g_assert_cmpuint(resp.bytes[1], == ,0x0f);  /* CCLEN */
+    g_assert_cmpuint(resp.bytes[2], == ,0x20);  /* Mapping version */
+    g_assert_cmpuint(resp.bytes[7], == ,0x04);  /* NDEF File Control TLV */
+    g_assert_cmpuint(resp.bytes[8], == ,0x06);
+    g_assert_cmpuint(resp.bytes[9], == ,0xe1);
+    g_assert_cmpuint(resp.bytes[10], == ,0x04);
+    g_assert_cmpuint(resp.bytes[11], == ,file_size >> 8);
+    g_assert_cmpuint(resp.bytes[12], == ,file_size & 0xff);
+    g_assert_cmpuint(resp.bytes[13], == ,0x00); /* Read access */
+    g_assert_cmpuint(resp.bytes[14], == ,0xff); /* No write access */
+
+    /* Reading CC doesn't count */
+    type4_tag_confirm_read(tag);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,0);
+    type4_tag_free(tag);
+}
+
+/*==========================================================================*
+ * read
+ *==========================================================================*/
+
+static
+void
+test_read_chunks(
+    void)
+{
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+    const gsize file_size = sizeof(test_ndef) + 2;
+    gsize off = 0;
+    GUtilData resp;
+
+    g_assert_cmpuint(test_select(tag, test_ndef_fid), == ,SW_OK);
+    while (off < file_size) {
+        /* The last chunk is short */
+        g_assert_cmpuint(test_read(tag, off, 5, &resp), == ,
+            (file_size - off < 5) ? SW_END_OF_FILE : SW_OK);
+        g_assert_cmpuint(resp.size, == ,MIN(5, file_size - off));
+        if (off >= 2) {
+            g_assert(!memcmp(resp.bytes, test_ndef + off - 2, resp.size));
+        }
+        type4_tag_confirm_read(tag);
+        off += resp.size;
+        g_assert_cmpuint(type4_tag_bytes_read(tag), == ,off);
+    }
+    g_assert(type4_tag_fully_read(tag));
+
+    /* Reading it again doesn't change anything */
+    g_assert_cmpuint(test_read(tag, 0, 5, &resp), == ,SW_OK);
+    type4_tag_confirm_read(tag);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,file_size);
+
+    type4_tag_reset(tag);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,0);
+    g_assert(!type4_tag_fully_read(tag));
+    type4_tag_free(tag);
+}
+
+static
+void
+test_read_unconfirmed(
+    void)
+{
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+    GUtilData resp;
+
+    g_assert_cmpuint(test_select(tag, test_ndef_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 4, &resp), == ,SW_OK);
+
+    /* Response didn't make it to the reader, the next one did */
+    g_assert_cmpuint(test_read(tag, 4, 4, &resp), == ,SW_OK);
+    type4_tag_confirm_read(tag);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,4);
+
+    /* Confirming twice doesn't count twice */
+    type4_tag_confirm_read(tag);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,4);
+    type4_tag_free(tag);
+}
+
+static
+void
+test_read_bad_offset(
+    void)
+{
+    Type4Tag* tag = type4_tag_new(test_ndef, sizeof(test_ndef), 0);
+    GUtilData resp;
+
+    g_assert_cmpuint(test_select(tag, test_ndef_fid), == ,SW_OK);
+
+    /* P1 bit 8 set means SFI, which we don't support */
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb0, 0x81, 0x00,
+        NULL, 2, &resp), == ,SW_FUNC_NOT_SUPPORTED);
+
+    /* Offsets outside of the file */
+    g_assert_cmpuint(test_read(tag, sizeof(test_ndef) + 2, 1, &resp), == ,
+        SW_WRONG_OFFSET);
+    g_assert(!resp.size);
+    g_assert_cmpuint(test_read(tag, 0x7fff, 1, &resp), == ,SW_WRONG_OFFSET);
+    type4_tag_free(tag);
+}
+
+static
+void
+test_read_le(
+    void)
+{
+    const gsize size = 0x300;
+    const gsize file_size = size + 2;
+    guint8* ndef = g_malloc(size);
+    Type4Tag* tag;
+    GUtilData resp;
+    gsize i;
+
+    for (i = 0; i < size; i++) {
+        ndef[i] = (guint8)(i * 31 + 7);
+    }
+
+    tag = type4_tag_new(ndef, size, 0);
+    g_assert_cmpuint(test_select(tag, test_ndef_fid), == ,SW_OK);
+
+    /* Le=00 (or no Le at all) means 256 */
+    g_assert_cmpuint(test_read(tag, 2, 0, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x100);
+    g_assert(!memcmp(resp.bytes, ndef, resp.size));
+    g_assert_cmpuint(test_read(tag, 2, 0x100, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x100);
+
+    /* Extended Le gets everything that's there */
+    g_assert_cmpuint(test_read(tag, 0, 0x10000, &resp), == ,SW_END_OF_FILE);
+    g_assert_cmpuint(resp.size, == ,file_size);
+
+    /* Exactly up to the end is fine, beyond the end is a warning */
+    g_assert_cmpuint(test_read(tag, 0x200, file_size - 0x200, &resp), == ,
+        SW_OK);
+    g_assert_cmpuint(resp.size, == ,file_size - 0x200);
+    g_assert_cmpuint(test_read(tag, 0x280, 0, &resp), == ,SW_END_OF_FILE);
+    g_assert_cmpuint(resp.size, == ,file_size - 0x280);
+
+    /* The data are still there and count */
+    type4_tag_confirm_read(tag);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,file_size - 0x280);
+    type4_tag_free(tag);
+
+    /* MLe is advertised in the CC and caps Ne */
+    tag = type4_tag_new(ndef, size, 0x20);
+    g_assert_cmpuint(test_select(tag, test_cc_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 15, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.bytes[3], == ,0x00);
+    g_assert_cmpuint(resp.bytes[4], == ,0x20);
+    g_assert_cmpuint(test_select(tag, test_ndef_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 0, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x20);
+    g_assert_cmpuint(test_read(tag, 0, 0x1000, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x20);
+    g_assert_cmpuint(test_read(tag, file_size - 0x10, 0x100, &resp), == ,
+        SW_END_OF_FILE);
+    g_assert_cmpuint(resp.size, == ,0x10);
+    type4_tag_free(tag);
+
+    /* But not below what the CC allows */
+    tag = type4_tag_new(ndef, size, 1);
+    g_assert_cmpuint(test_select(tag, test_cc_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 15, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.bytes[3], == ,0x00);
+    g_assert_cmpuint(resp.bytes[4], == ,0x0f);
+    type4_tag_free(tag);
+
+    /* And the default is the largest one */
+    tag = type4_tag_new(ndef, size, 0);
+    g_assert_cmpuint(test_select(tag, test_cc_fid), == ,SW_OK);
+    g_assert_cmpuint(test_read(tag, 0, 15, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.bytes[3], == ,0xff);
+    g_assert_cmpuint(resp.bytes[4], == ,0xff);
+    type4_tag_free(tag);
+    g_free(ndef);
+}
+
+static
+void
+test_read_odo(
+    void)
+{
+    static const guint8 odo_0[] = { 0x54, 0x01, 0x00 };
+    static const guint8 odo_2[] = { 0x54, 0x03, 0x00, 0x00, 0x02 };
+    static const guint8 odo_end[] = { 0x54, 0x02, 0x80, 0x02 }; /* 0x8002 */
+    static const guint8 odo_bad_tag[] = { 0x55, 0x01, 0x00 };
+    static const guint8 odo_empty[] = { 0x54, 0x00 };
+    static const guint8 odo_long[] = { 0x54, 0x04, 0x00, 0x00, 0x00, 0x00 };
+    static const guint8 odo_short[] = { 0x54, 0x02, 0x00 };
+    const gsize size = 0x8000;
+    guint8* ndef = g_malloc(size);
+    Type4Tag* tag;
+    GUtilData data, resp;
+    guint8 odo[4];
+    gsize i;
+
+    for (i = 0; i < size; i++) {
+        ndef[i] = (guint8)(i * 31 + 7);
+    }
+
+    tag = type4_tag_new(ndef, size, 0);
+    data.bytes = odo_0;
+    data.size = sizeof(odo_0);
+
+    /* No current EF */
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x10, &resp), == ,SW_NO_CURRENT_EF);
+
+    /* P1-P2 selects the file, the response is wrapped into 53 L */
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0xe1, 0x04,
+        &data, 0x10, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x10);
+    g_assert_cmpuint(resp.bytes[0], == ,0x53);
+    g_assert_cmpuint(resp.bytes[1], == ,0x0e);
+    g_assert_cmpuint(resp.bytes[2], == ,size >> 8);
+    g_assert_cmpuint(resp.bytes[3], == ,size & 0xff);
+    g_assert(!memcmp(resp.bytes + 4, ndef, 12));
+
+    /* Stays selected, and the header may take 3 bytes */
+    data.bytes = odo_2;
+    data.size = sizeof(odo_2);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x100, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x100);
+    g_assert_cmpuint(resp.bytes[0], == ,0x53);
+    g_assert_cmpuint(resp.bytes[1], == ,0x81);
+    g_assert_cmpuint(resp.bytes[2], == ,0xfd);
+    g_assert(!memcmp(resp.bytes + 3, ndef, 0xfd));
+
+    /* Or 4 bytes */
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x1000, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x1000);
+    g_assert_cmpuint(resp.bytes[1], == ,0x82);
+    g_assert_cmpuint(resp.bytes[2], == ,0x0f);
+    g_assert_cmpuint(resp.bytes[3], == ,0xfc);
+    g_assert(!memcmp(resp.bytes + 4, ndef, 0xffc));
+
+    /* Beyond 32767, which B0 can't reach */
+    odo[0] = 0x54;
+    odo[1] = 0x02;
+    odo[2] = 0x7f;
+    odo[3] = 0xf2;
+    data.bytes = odo;
+    data.size = sizeof(odo);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x10, &resp), == ,SW_OK);
+    g_assert_cmpuint(resp.size, == ,0x10);
+    g_assert(!memcmp(resp.bytes + 2, ndef + 0x7ff0, 14));
+    type4_tag_confirm_read(tag);
+    g_assert_cmpuint(type4_tag_bytes_read(tag), == ,14);
+    odo[2] = 0x80;
+    odo[3] = 0x00;
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0, &resp), == ,SW_END_OF_FILE);
+    g_assert_cmpuint(resp.size, == ,4);
+    g_assert_cmpuint(resp.bytes[1], == ,2);
+    g_assert(!memcmp(resp.bytes + 2, ndef + size - 2, 2));
+
+    /* Errors */
+    data.bytes = odo_end;
+    data.size = sizeof(odo_end);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x10, &resp), == ,SW_WRONG_OFFSET);
+    data.bytes = odo_0;
+    data.size = sizeof(odo_0);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 2, &resp), == ,SW_WRONG_LENGTH);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x01,
+        &data, 0x10, &resp), == ,SW_FUNC_NOT_SUPPORTED);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0xe1, 0x05,
+        &data, 0x10, &resp), == ,SW_NOT_FOUND);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        NULL, 0x10, &resp), == ,SW_WRONG_DATA);
+    data.bytes = odo_bad_tag;
+    data.size = sizeof(odo_bad_tag);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x10, &resp), == ,SW_WRONG_DATA);
+    data.bytes = odo_empty;
+    data.size = sizeof(odo_empty);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x10, &resp), == ,SW_WRONG_DATA);
+    data.bytes = odo_long;
+    data.size = sizeof(odo_long);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x10, &resp), == ,SW_WRONG_DATA);
+    data.bytes = odo_short;
+    data.size = sizeof(odo_short);
+    g_assert_cmpuint(type4_tag_process(tag, 0x00, 0xb1, 0x00, 0x00,
+        &data, 0x10, &resp), == ,SW_WRONG_DATA);
+    type4_tag_free(tag);
+    g_free(ndef);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/type4tag/" name
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("select/ok"), test_select_ok);
+    g_test_add_func(TEST_("select/fail"), test_select_fail);
+    g_test_add_func(TEST_("select/variants"), test_select_variants);
+    g_test_add_func(TEST_("cc"), test_cc);
+    g_test_add_func(TEST_("read/chunks"), test_read_chunks);
+    g_test_add_func(TEST_("read/unconfirmed"), test_read_unconfirmed);
+    g_test_add_func(TEST_("read/bad_offset"), test_read_bad_offset);
+    g_test_add_func(TEST_("read/le"), test_read_le);
+    g_test_add_func(TEST_("read/odo"), test_read_odo);
+    return g_test_run();
+}
+
@@ -0,0 +1,13 @@
+TEMPLATE = app
+TARGET = test_type4tag
+CONFIG += console testcase no_testcase_installs link_pkgconfig
+CONFIG -= qt app_bundle
+PKGCONFIG += libglibutil glib-2.0
+
+QMAKE_CFLAGS += -Wno-unused-parameter
+
+INCLUDEPATH += ../../nfcdplugin
+
+SOURCES += \
+    test_type4tag.c \
+    ../../nfcdplugin/type4tag.c
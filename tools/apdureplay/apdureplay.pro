@@ -0,0 +1,29 @@
+TEMPLATE = app
+TARGET = apdureplay
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+QMAKE_CXXFLAGS += -Wno-unused-parameter
+
+DEFINES += QT_NO_KEYWORDS
+
+CONFIG(debug, debug|release) {
+    DEFINES += DEBUG
+}
+
+# The APDU engine and the trace format are compiled in from libnfcshare
+LIB_DIR = ../../lib
+INCLUDEPATH += $${LIB_DIR}/include $${LIB_DIR}/src
+DEFINES += NFCSHARE_STATIC
+
+HEADERS += \
+    $${LIB_DIR}/include/ndeftag.h \
+    $${LIB_DIR}/src/apdutrace.h \
+    $${LIB_DIR}/src/nfcsharelog.h
+
+SOURCES += \
+    main.cpp \
+    $${LIB_DIR}/src/apdutrace.cpp \
+    $${LIB_DIR}/src/ndeftag.cpp \
+    $${LIB_DIR}/src/nfcsharelog.cpp
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// Feeds a trace recorded with NFCSHARE_APDU_TRACE through the APDU
+// engine, compares the responses with the recorded ones and reports
+// how long the engine took to produce them.
+
+#include "apdutrace.h"
+#include "ndeftag.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtCore/QVector>
+
+#include <algorithm>
+
+#define RET_OK (0)
+#define RET_DIVERGED (1)
+#define RET_ERR (2)
+
+static
+qint64
+percentile(
+    const QVector<qint64>& aSorted,
+    int aPercent)
+{
+    if (aSorted.isEmpty()) {
+        return 0;
+    } else {
+        const int i = (aSorted.size() * aPercent + 99) / 100 - 1;
+        return aSorted.at(qBound(0, i, aSorted.size() - 1));
+    }
+}
+
+static
+int
+replay(
+    const QString& aFileName,
+    bool aVerbose)
+{
+    QTextStream out(stdout);
+    ApduTrace trace(aFileName);
+
+    if (!trace.isValid()) {
+        QTextStream(stderr) << aFileName << ": not a valid trace\n";
+        return RET_ERR;
+    }
+
+    NdefTag tag(trace.ndef().constData(), trace.ndef().size(),
+        trace.maxLe(), trace.receiveSize());
+    QHash<uint,uint> ids; // Recorded id => replayed id
+    QVector<qint64> times;
+    ApduTrace::Entry e;
+    int sessions = 0, restarts = 0, replaced = 0;
+    int commands = 0, statuses = 0, diverged = 0;
+    quint64 lastTimestamp = 0;
+
+    while (trace.next(e)) {
+        lastTimestamp = e.iTimestamp;
+        switch (e.iType) {
+        case ApduTrace::TypeStart:
+            sessions++;
+            tag.start();
+            break;
+        case ApduTrace::TypeRestart:
+            // NdefApp handles Restart by stopping the tag, the next
+            // SELECT starts it over
+            restarts++;
+            tag.stop();
+            break;
+        case ApduTrace::TypeStop:
+            tag.stop();
+            break;
+        case ApduTrace::TypeCommand:
+            {
+                QElapsedTimer timer;
+
+                timer.start();
+                const NdefTag::Response r(tag.process(e.iCla, e.iIns,
+                    e.iP1, e.iP2, e.iData, e.iLe));
+                const qint64 ns = timer.nsecsElapsed();
+
+                commands++;
+                times.append(ns);
+                if (e.iResponseId) {
+                    ids.insert(e.iResponseId, r.id());
+                }
+                if (r.sw1() != e.iSw1 || r.sw2() != e.iSw2 ||
+                    r.data() != e.iResponse) {
+                    diverged++;
+                    out << "#" << commands << " " << hex <<
+                        (uint)e.iCla << " " << (uint)e.iIns << " " <<
+                        (uint)e.iP1 << " " << (uint)e.iP2 << " " <<
+                        e.iData.toHex() << dec <<
+                        ": expected " << e.iResponse.toHex() << " " <<
+                        QByteArray(1, e.iSw1).toHex() <<
+                        QByteArray(1, e.iSw2).toHex() << ", got " <<
+                        r.data().toHex() << " " <<
+                        QByteArray(1, r.sw1()).toHex() <<
+                        QByteArray(1, r.sw2()).toHex() << "\n";
+                } else if (aVerbose) {
+                    out << "#" << commands << " ok " << ns / 1000 << " us\n";
+                }
+            }
+            break;
+        case ApduTrace::TypeStatus:
+            statuses++;
+            tag.responseStatus(ids.value(e.iResponseId), e.iOk);
+            break;
+        case ApduTrace::TypeReplace:
+            replaced++;
+            tag.replace(e.iData.constData(), e.iData.size());
+            break;
+        case ApduTrace::TypeLegacyAid:
+            tag.setLegacyAidEnabled(e.iOk);
+            break;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    qint64 total = 0;
+    for (int i = 0; i < times.size(); i++) {
+        total += times.at(i);
+    }
+
+    out << "ndef_bytes: " << trace.ndef().size() << "\n";
+    out << "sessions: " << sessions << "\n";
+    out << "restarts: " << restarts << "\n";
+    out << "messages_replaced: " << replaced << "\n";
+    out << "commands: " << commands << "\n";
+    out << "statuses: " << statuses << "\n";
+    out << "recorded_ms: " << lastTimestamp / 1000000 << "\n";
+    out << "engine_total_us: " << total / 1000 << "\n";
+    out << "engine_p50_us: " << percentile(times, 50) / 1000 << "\n";
+    out << "engine_p99_us: " << percentile(times, 99) / 1000 << "\n";
+    out << "engine_max_us: " << (times.isEmpty() ? 0 : times.last() / 1000)
+        << "\n";
+    out << "bytes_read: " << tag.bytesRead() << "/" << tag.size() << "\n";
+    out << "diverged: " << diverged << "\n";
+    return diverged ? RET_DIVERGED : RET_OK;
+}
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args(app.arguments());
+    const bool verbose = args.removeAll("-v") > 0;
+
+    if (args.size() == 2) {
+        return replay(args.at(1), verbose);
+    } else {
+        QTextStream(stderr) << "Usage: " << app.applicationName() <<
+            " [-v] TRACE\n";
+        return RET_ERR;
+    }
+}
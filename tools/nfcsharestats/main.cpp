@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer
+ *     in the documentation and/or other materials provided with the
+ *     distribution.
+ *
+ *  3. Neither the names of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+// Summarizes the share history written by NdefApp when
+// NFCSHARE_HISTORY_FILE is set: latency percentiles for the whole
+// log, then broken down by reader, technology and payload size.
+
+#include "sharehistory.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QMap>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtCore/QVector>
+
+#include <algorithm>
+
+#define RET_OK (0)
+#define RET_ERR (2)
+
+// Upper bounds (inclusive) of the payload size buckets
+static const uint SIZE_LIMIT[] = { 256, 1024, 4096, 16384 };
+#define SIZE_BUCKETS (sizeof(SIZE_LIMIT)/sizeof(SIZE_LIMIT[0]) + 1)
+
+class Group
+{
+public:
+    Group();
+
+    void add(const ShareHistory::Record&);
+    void print(QTextStream&, const QString&) const;
+
+    static void printHeader(QTextStream&, const QString&);
+
+private:
+    static qreal percentile(const QVector<qreal>&, int);
+    static QString column(const QVector<qreal>&, int);
+
+private:
+    uint iCount;
+    uint iDone;
+    uint iRetries;
+    uint iResets;
+    QVector<qreal> iReady;
+    QVector<qreal> iFirstApdu;
+    QVector<qreal> iTransfer;
+};
+
+Group::Group() :
+    iCount(0),
+    iDone(0),
+    iRetries(0),
+    iResets(0)
+{}
+
+void
+Group::add(
+    const ShareHistory::Record& aRecord)
+{
+    iCount++;
+    iRetries += aRecord.iRetries;
+    iResets += aRecord.iResets;
+    if (aRecord.iOutcome == "done") {
+        iDone++;
+    }
+    if (aRecord.iReadyMs >= 0) {
+        iReady.append(aRecord.iReadyMs);
+    }
+    if (aRecord.iFirstApduMs >= 0) {
+        iFirstApdu.append(aRecord.iFirstApduMs);
+    }
+    if (aRecord.iTransferMs >= 0) {
+        iTransfer.append(aRecord.iTransferMs);
+    }
+}
+
+//static
+qreal
+Group::percentile(
+    const QVector<qreal>& aValues,
+    int aPercent)
+{
+    QVector<qreal> sorted(aValues);
+    std::sort(sorted.begin(), sorted.end());
+    const int i = (sorted.size() * aPercent + 99) / 100 - 1;
+    return sorted.at(qBound(0, i, sorted.size() - 1));
+}
+
+//static
+QString
+Group::column(
+    const QVector<qreal>& aValues,
+    int aPercent)
+{
+    return aValues.isEmpty() ? QString("-") :
+        QString::number(percentile(aValues, aPercent), 'f', 1);
+}
+
+//static
+void
+Group::printHeader(
+    QTextStream& aOut,
+    const QString& aTitle)
+{
+    aOut << "\n" << aTitle << "\n";
+    aOut << qSetFieldWidth(24) << left << "" << qSetFieldWidth(9) << right
+        << "n" << "done%" << "retries" << "resets"
+        << "ready50" << "ready99" << "first50" << "first99"
+        << "xfer50" << "xfer90" << "xfer99" << qSetFieldWidth(0) << "\n";
+}
+
+void
+Group::print(
+    QTextStream& aOut,
+    const QString& aName) const
+{
+    aOut << qSetFieldWidth(24) << left << aName.right(24) <<
+        qSetFieldWidth(9) << right << iCount <<
+        QString::number(iCount ? (100.0 * iDone / iCount) : 0, 'f', 1) <<
+        iRetries << iResets <<
+        column(iReady, 50) << column(iReady, 99) <<
+        column(iFirstApdu, 50) << column(iFirstApdu, 99) <<
+        column(iTransfer, 50) << column(iTransfer, 90) <<
+        column(iTransfer, 99) << qSetFieldWidth(0) << "\n";
+}
+
+static
+QString
+sizeBucket(
+    uint aBytes)
+{
+    uint i;
+
+    for (i = 0; i < SIZE_BUCKETS - 1; i++) {
+        if (aBytes <= SIZE_LIMIT[i]) {
+            return QString("<=%1").arg(SIZE_LIMIT[i]);
+        }
+    }
+    return QString(">%1").arg(SIZE_LIMIT[i - 1]);
+}
+
+static
+bool
+load(
+    const QString& aFileName,
+    QVector<ShareHistory::Record>& aRecords)
+{
+    QFile file(aFileName);
+
+    if (file.open(QIODevice::ReadOnly)) {
+        while (!file.atEnd()) {
+            ShareHistory::Record rec;
+
+            if (ShareHistory::Record::parse(file.readLine(), rec)) {
+                aRecords.append(rec);
+            }
+        }
+        return true;
+    } else {
+        QTextStream(stderr) << aFileName << ": " << file.errorString() << "\n";
+        return false;
+    }
+}
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList files(app.arguments().mid(1));
+    QVector<ShareHistory::Record> records;
+
+    if (files.isEmpty()) {
+        QTextStream(stderr) << "Usage: " << app.applicationName() <<
+            " HISTORY...\n";
+        return RET_ERR;
+    }
+
+    for (int i = 0; i < files.size(); i++) {
+        if (!load(files.at(i), records)) {
+            return RET_ERR;
+        }
+    }
+
+    Group all;
+    QMap<QString,Group> readers;
+    QMap<QString,Group> techs;
+    QMap<uint,Group> sizes;     // Keyed by bucket index to keep the order
+    QMap<QString,Group> outcomes;
+
+    for (int i = 0; i < records.size(); i++) {
+        const ShareHistory::Record& rec = records.at(i);
+        uint bucket = 0;
+
+        while (bucket < SIZE_BUCKETS - 1 && rec.iBytes > SIZE_LIMIT[bucket]) {
+            bucket++;
+        }
+        all.add(rec);
+        readers[rec.iReader.isEmpty() ? QString("-") : rec.iReader].add(rec);
+        techs[rec.iTech.isEmpty() ? QString("-") :
+            QString::fromLatin1(rec.iTech)].add(rec);
+        sizes[bucket].add(rec);
+        outcomes[QString::fromLatin1(rec.iOutcome)].add(rec);
+    }
+
+    // Times are in milliseconds
+    QTextStream out(stdout);
+    Group::printHeader(out, "All sessions");
+    all.print(out, "all");
+
+    Group::printHeader(out, "By reader");
+    for (auto it = readers.constBegin(); it != readers.constEnd(); ++it) {
+        it.value().print(out, it.key());
+    }
+
+    Group::printHeader(out, "By technology");
+    for (auto it = techs.constBegin(); it != techs.constEnd(); ++it) {
+        it.value().print(out, it.key());
+    }
+
+    Group::printHeader(out, "By payload size");
+    for (auto it = sizes.constBegin(); it != sizes.constEnd(); ++it) {
+        it.value().print(out, sizeBucket(it.key() < SIZE_BUCKETS - 1 ?
+            SIZE_LIMIT[it.key()] : SIZE_LIMIT[SIZE_BUCKETS - 2] + 1));
+    }
+
+    Group::printHeader(out, "By outcome");
+    for (auto it = outcomes.constBegin(); it != outcomes.constEnd(); ++it) {
+        it.value().print(out, it.key());
+    }
+    return RET_OK;
+}
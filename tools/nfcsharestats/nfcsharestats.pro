@@ -0,0 +1,26 @@
+TEMPLATE = app
+TARGET = nfcsharestats
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+
+QMAKE_CXXFLAGS += -Wno-unused-parameter
+
+DEFINES += QT_NO_KEYWORDS
+
+CONFIG(debug, debug|release) {
+    DEFINES += DEBUG
+}
+
+# The history format is compiled in from libnfcshare
+LIB_DIR = ../../lib
+INCLUDEPATH += $${LIB_DIR}/src
+
+HEADERS += \
+    $${LIB_DIR}/src/nfcsharelog.h \
+    $${LIB_DIR}/src/sharehistory.h
+
+SOURCES += \
+    main.cpp \
+    $${LIB_DIR}/src/nfcsharelog.cpp \
+    $${LIB_DIR}/src/sharehistory.cpp